@@ -0,0 +1,84 @@
+// Structures shared between the renderer and the shaders. CMake splices this into the
+// generated shaders (the *.glsl.in files) and Systems/ShaderTypes.hpp includes it, so it
+// has to stay valid as both GLSL and C++
+
+// Each model instance represented in the GPU. rotation is a quaternion (xyz, w)
+struct Instance
+{
+    vec4 rotation;
+    vec3 position;
+    uint flags;
+    vec3 scale;
+    float pad;
+};
+
+const uint InstanceLit = 1u;
+
+// The per-camera data representation in the GPU
+struct SceneData
+{
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+    vec3 camera_position;
+    float pad;
+};
+
+// A point light. Its contribution fades out to nothing at range, which is what lets the
+// clustered lighting leave it out of clusters further away
+struct Light
+{
+    vec3 position;
+    float intensity;
+    vec3 color;
+    float range;
+};
+
+// One cluster of a camera's light grid, its lights are the count indices starting at offset
+struct Cluster
+{
+    uint offset;
+    uint count;
+};
+
+// Every camera has these images back to back in the gbuffer descriptor, starting at
+// scene_index * CameraImages: its albedo, position and normal, the HDR surface, the auto exposure
+// histogram and the two adaptation images
+const uint CameraImages = 7u;
+
+// Auto exposure meters the HDR surface at MeterSize x MeterSize evenly spread texels and sorts them
+// into a luminance histogram (histogram.fragment.glsl). Bin 0 holds the ones too dark to count, the
+// rest split the metered log range evenly. The histogram image is HistogramBins x HistogramRows,
+// each row counting MeterSize / HistogramRows rows of texels so no texel of it counts past what a
+// half float holds exactly. adaptation.fragment.glsl reduces it to a single texel holding the
+// smoothed luminance and the exposure, ping-ponging between two images so it can read last frame's
+const uint MeterSize = 128u;
+const uint HistogramBins = 64u;
+const uint HistogramRows = 32u;
+
+// One row per resolved material. albedo indexes the bindless texture array every material
+// pipeline shares, NoTexture when there is none
+struct MaterialData
+{
+    uint albedo;
+    uint pad0;
+    uint pad1;
+    uint pad2;
+};
+
+const uint NoTexture = 0xFFFFFFFFu;
+
+// A vertex as the geometry pool stores it, pulled by gl_VertexIndex in vertex.glsl.
+// position_xy/position_z: unorm16 position inside the mesh's bounding box
+// normal:                 octahedral encoded normal, snorm16 x2
+// tex_coords:             half x2
+struct PackedVertex
+{
+    uint position_xy;
+    uint position_z;
+    uint normal;
+    uint tex_coords;
+};
+
+// Meshes whose vertices all share one colour don't get a colour stream
+const int NoColorStream = -2147483647 - 1;
@@ -1,11 +1,46 @@
 #include "Application.hpp"
 #include "Component.hpp"
+#include "TextureCache.hpp"
+#include "Systems/Material.hpp"
 #include "../Util/DataRep.hpp"
 
 #include <imgui.h>
 
 namespace Engine
 {
+    void Scene::updateResources()
+    {
+        // Finished model loads go into the entities waiting on them all at once, here between frames.
+        // modified() lets the renderer know the slot needs to be rebuilt
+        // A load that failed leaves the entity without a model
+        if (res.update())
+            loading_query.each(
+                [](flecs::entity e, Component::Model& model)
+                {
+                    if (!model.loading.ready()) return;
+
+                    if (model.loading.failed())
+                    {
+                        try { std::rethrow_exception(model.loading.error()); }
+                        catch (const std::exception& error) { std::cout << error.what() << "\n"; }
+                        catch (...) { std::cout << "Error loading " << model.loading.entry().name << "\n"; }
+                        model.loading = {};
+                        return;
+                    }
+
+                    model.model   = model.loading.entry();
+                    model.loading = {};
+                    e.modified<Component::Model>();
+                });
+
+        // Textures first so materials waiting on them can take them this frame
+        if (res.exists<TextureCache>("textures"))
+            res.get<TextureCache>("textures").value->update(res);
+
+        if (res.exists<System::MaterialTable>("materials"))
+            res.get<System::MaterialTable>("materials").value->update();
+    }
+
     void Scene::renderOverlay() const
     {
         ImGui::Begin("Entities");
@@ -21,9 +56,13 @@ namespace Engine
                     auto* transform = e.get_mut<Component::Transform>();
                     if (ImGui::TreeNode("Transform"))
                     {
-                        ImGui::SliderFloat3("Position", (float*)&transform->position, -25.f, 25.f);
-                        ImGui::SliderScalarN("Rotation", ImGuiDataType_Double, (double*)&transform->rotation, 3, &min, &max);
-                        ImGui::SliderFloat3("Scale", (float*)&transform->scale, 0.f, 10.f);
+                        bool changed = false;
+                        changed |= ImGui::SliderFloat3("Position", (float*)&transform->position, -25.f, 25.f);
+                        changed |= ImGui::SliderScalarN("Rotation", ImGuiDataType_Double, (double*)&transform->rotation, 3, &min, &max);
+                        changed |= ImGui::SliderFloat3("Scale", (float*)&transform->scale, 0.f, 10.f);
+
+                        // Let the renderer know this instance needs to be uploaded again
+                        if (changed) e.modified<Component::Transform>();
                         ImGui::TreePop();
                     }
                 }
@@ -85,6 +124,7 @@ namespace Engine
                     {
                         ImGui::ColorPicker3("Color", (float*)&light->color);
                         ImGui::SliderFloat("Intensity", (float*)&light->intensity, 0.f, 1000.f);
+                        ImGui::SliderFloat("Range", &light->range, 0.f, 100.f);
                         ImGui::TreePop();
                     }
                 }
@@ -96,6 +136,7 @@ namespace Engine
 
         // Nicer way to do this
         ImGui::Begin("Resources");
+        ImGui::Text("Loading: %lu (%.1f ms average latency)", res.loading(), (res.loading() ? res.loadLatency() : 0.0));
         if (ImGui::CollapsingHeader("Models"))
         {
             auto model_map = res.get_type_map<Engine::Model>();
@@ -107,7 +148,7 @@ namespace Engine
                     const auto& meshes = model_ptr->getMeshes();
                     ImGui::Text("%lu kB", Util::convert<Util::Bytes, Util::Kilobytes>(model_ptr->allocated()));
                     ImGui::Text("Contains %lu meshes", meshes.size());
-                    for (const auto& mesh : meshes) ImGui::Text("  %lu vertices, %lu indices", mesh->mesh->vertexCount(), mesh->mesh->indexCount());
+                    for (const auto& mesh : meshes) ImGui::Text("  %lu vertices, %lu indices", mesh->geometry.vertex_count, mesh->index_count);
                     */
                    ImGui::TreePop();
                 }
@@ -124,6 +165,13 @@ namespace Engine
         }
         if (ImGui::CollapsingHeader("Textures"))
         {
+            if (res.exists<TextureCache>("textures"))
+            {
+                const auto stats = res.get<TextureCache>("textures").value->stats();
+                ImGui::Text("Cache: %lu textures, %lu loading (%lu path hits, %lu content hits)", 
+                    stats.textures, stats.pending, stats.path_hits, stats.content_hits);
+            }
+
             auto texture_map = res.get_type_map<mn::Graphics::Texture>();
             for (const auto& [ name, texture ] : texture_map)
                 if (ImGui::TreeNode(name.c_str()))
@@ -2,6 +2,7 @@
 
 #include <midnight/midnight.hpp>
 
+#include "Component.hpp"
 #include "ResourceManager.hpp"
 #include "../Util/Profiler.hpp"
 
@@ -23,6 +24,7 @@ namespace Engine
         };
 
         Scene(std::shared_ptr<mn::Graphics::Window> w) :
+            loading_query(world.query_builder<Component::Model>().cached().build()),
             window{w}
         {   }
 
@@ -32,6 +34,9 @@ namespace Engine
         virtual void render(mn::Graphics::RenderFrame&) const = 0;
         virtual void poll(mn::Graphics::Event&) = 0;
 
+        // Picks up whatever finished loading in the background, between update and render
+        void updateResources();
+
     protected:
         flecs::entity createEntity(std::string name = "")
         {
@@ -45,6 +50,9 @@ namespace Engine
         Engine::ResourceManager res;
         flecs::world world;
 
+        // Entities with a model, updateResources() looks through them for finished loads
+        flecs::query<Component::Model> loading_query;
+
         // Needed only for overlay
         std::vector<flecs::entity> entities;
 
@@ -87,6 +95,8 @@ namespace Engine
                 }
 
                 if (!scenes.size()) break;
+
+                scenes.back()->updateResources();
                 
                 {
                     Util::ProfilerBlock render_block(profiler, "PollEvents");
@@ -26,10 +26,25 @@ namespace Engine::Component
     struct Hidden { };
     struct DontCull { };
 
+    // Never or hardly ever moves. The renderer keeps these in a BVH it rebuilds from scratch when
+    // one of them changes, rather than the one it refits as things move
+    struct Static { };
+
+    // Always drawn into the renderer's occlusion buffer, for the walls and floors that hide the most
+    struct Occluder { };
+
     struct Model
     {
         bool lit;
         ResourceManager::Entry<Engine::Model> model;
+
+        // Added to the renderer's lod_bias for this model. lod_override pins every mesh to one
+        // level (0 is the coarsest, past the last LOD is the full mesh), -1 lets the renderer pick
+        float lod_bias = 0.f;
+        int lod_override = -1;
+
+        // Set instead of model while it loads, the entity isn't drawn until the scene swaps it in
+        ResourceManager::Pending<Engine::Model> loading;
     };
 
     struct Camera
@@ -80,5 +95,7 @@ namespace Engine::Component
     {
         mn::Math::Vec3f color;
         float intensity;
+        // Distance the light fades out to zero over, it isn't shaded past it
+        float range = 10.f;
     };
 }
\ No newline at end of file
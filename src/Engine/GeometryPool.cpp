@@ -0,0 +1,189 @@
+#include "GeometryPool.hpp"
+
+#include <algorithm>
+
+namespace Engine
+{
+    GeometryPool::Allocation::Allocation(Allocation&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    GeometryPool::Allocation& GeometryPool::Allocation::operator=(Allocation&& other) noexcept
+    {
+        if (this == &other) return *this;
+        if (pool) pool->release(*this);
+
+        vertex_offset = other.vertex_offset;
+        vertex_count  = other.vertex_count;
+        color_offset  = other.color_offset;
+        color_count   = other.color_count;
+        index_offset  = other.index_offset;
+        index_count   = other.index_count;
+        pool = std::move(other.pool);
+        return *this;
+    }
+
+    GeometryPool::Allocation::~Allocation()
+    {
+        if (pool) pool->release(*this);
+    }
+
+    std::shared_ptr<GeometryPool> GeometryPool::get()
+    {
+        // Weak so the GPU buffers go away with the last model instead of at static destruction
+        static std::mutex get_mutex;
+        static std::weak_ptr<GeometryPool> current;
+
+        std::lock_guard lock(get_mutex);
+        auto pool = current.lock();
+        if (!pool)
+        {
+            pool = std::make_shared<GeometryPool>();
+            current = pool;
+        }
+        return pool;
+    }
+
+    template<typename T>
+    void GeometryPool::grow(std::shared_ptr<mn::Graphics::TypeBuffer<T>>& buffer, Util::RangeAllocator& ranges, std::size_t count)
+    {
+        const auto capacity = std::max({ ranges.capacity() * 2, ranges.capacity() + count, std::size_t(1) << 16 });
+
+        // Draws already recorded keep the old buffer alive through their shared_ptr
+        auto bigger = std::make_shared<mn::Graphics::TypeBuffer<T>>();
+        bigger->resize(capacity);
+        if (buffer && buffer->size())
+            std::copy(&buffer->at(0), &buffer->at(0) + buffer->size(), &bigger->at(0));
+
+        buffer = bigger;
+        ranges.grow(capacity);
+    }
+
+    GeometryPool::Allocation GeometryPool::allocate(std::span<const Vertex> vertices, std::span<const uint32_t> colors, std::span<const uint32_t> indices)
+    {
+        std::lock_guard lock(mutex);
+
+        if (!bind_buffer)
+        {
+            bind_buffer = std::make_shared<mn::Graphics::TypeBuffer<mn::Graphics::Mesh::Vertex>>();
+            bind_buffer->resize(1);
+        }
+
+        auto vertex_offset = vertex_ranges.allocate(vertices.size());
+        if (!vertex_offset)
+        {
+            grow(vertex_buffer, vertex_ranges, vertices.size());
+            vertex_offset = vertex_ranges.allocate(vertices.size());
+        }
+
+        auto color_offset = color_ranges.allocate(colors.size());
+        if (!color_offset)
+        {
+            grow(color_buffer, color_ranges, colors.size());
+            color_offset = color_ranges.allocate(colors.size());
+        }
+
+        auto index_offset = index_ranges.allocate(indices.size());
+        if (!index_offset)
+        {
+            grow(index_buffer, index_ranges, indices.size());
+            index_offset = index_ranges.allocate(indices.size());
+        }
+
+        if (vertices.size()) 
+            std::copy(vertices.begin(), vertices.end(), &vertex_buffer->at(*vertex_offset));
+
+        if (colors.size())
+            std::copy(colors.begin(), colors.end(), &color_buffer->at(*color_offset));
+        
+        if (indices.size())
+            std::transform(indices.begin(), indices.end(), &index_buffer->at(*index_offset),
+                [base = static_cast<uint32_t>(*vertex_offset)](uint32_t index) { return index + base; });
+
+        Allocation allocation;
+        allocation.vertex_offset = *vertex_offset;
+        allocation.vertex_count  = vertices.size();
+        allocation.color_offset  = *color_offset;
+        allocation.color_count   = colors.size();
+        allocation.index_offset  = *index_offset;
+        allocation.index_count   = indices.size();
+        allocation.pool = shared_from_this();
+        return allocation;
+    }
+
+    GeometryPool::Allocation GeometryPool::allocateIndices(std::span<const uint32_t> indices, std::size_t vertex_offset)
+    {
+        std::lock_guard lock(mutex);
+
+        auto index_offset = index_ranges.allocate(indices.size());
+        if (!index_offset)
+        {
+            grow(index_buffer, index_ranges, indices.size());
+            index_offset = index_ranges.allocate(indices.size());
+        }
+
+        if (indices.size())
+            std::transform(indices.begin(), indices.end(), &index_buffer->at(*index_offset),
+                [base = static_cast<uint32_t>(vertex_offset)](uint32_t index) { return index + base; });
+
+        Allocation allocation;
+        allocation.index_offset = *index_offset;
+        allocation.index_count  = indices.size();
+        allocation.pool = shared_from_this();
+        return allocation;
+    }
+
+    void GeometryPool::read(std::size_t vertex_offset, std::span<Vertex> vertices, std::size_t index_offset, std::span<uint32_t> indices) const
+    {
+        std::lock_guard lock(mutex);
+
+        if (vertices.size())
+            std::copy(&vertex_buffer->at(vertex_offset), &vertex_buffer->at(vertex_offset) + vertices.size(), vertices.begin());
+
+        if (indices.size())
+            std::transform(&index_buffer->at(index_offset), &index_buffer->at(index_offset) + indices.size(), indices.begin(),
+                [base = static_cast<uint32_t>(vertex_offset)](uint32_t index) { return index - base; });
+    }
+
+    void GeometryPool::reserve(std::size_t vertex_count, std::size_t color_count, std::size_t index_count)
+    {
+        std::lock_guard lock(mutex);
+        if (vertex_ranges.largestFree() < vertex_count) grow(vertex_buffer, vertex_ranges, vertex_count);
+        if (color_ranges.largestFree()  < color_count)  grow(color_buffer,  color_ranges,  color_count);
+        if (index_ranges.largestFree()  < index_count)  grow(index_buffer,  index_ranges,  index_count);
+    }
+
+    void GeometryPool::release(const Allocation& allocation)
+    {
+        // Frames already recorded may still draw from these, reusing them right away would have a
+        // new upload overwrite geometry the GPU is reading
+        std::lock_guard lock(mutex);
+        vertex_ranges.retire(allocation.vertex_offset, allocation.vertex_count, FramesInFlight);
+        color_ranges.retire(allocation.color_offset, allocation.color_count, FramesInFlight);
+        index_ranges.retire(allocation.index_offset, allocation.index_count, FramesInFlight);
+    }
+
+    void GeometryPool::nextFrame()
+    {
+        std::lock_guard lock(mutex);
+        vertex_ranges.nextFrame();
+        color_ranges.nextFrame();
+        index_ranges.nextFrame();
+    }
+
+    GeometryPool::Stats GeometryPool::stats() const
+    {
+        std::lock_guard lock(mutex);
+        return Stats{
+            .vertex_used          = vertex_ranges.used(),
+            .vertex_capacity      = vertex_ranges.capacity(),
+            .index_used           = index_ranges.used(),
+            .index_capacity       = index_ranges.capacity(),
+            .vertex_retired       = vertex_ranges.retired(),
+            .index_retired        = index_ranges.retired(),
+            .vertex_fragmentation = vertex_ranges.fragmentation(),
+            .index_fragmentation  = index_ranges.fragmentation()
+        };
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "../Util/RangeAllocator.hpp"
+#include "Systems/ShaderTypes.hpp"
+
+#include <midnight/midnight.hpp>
+
+#include <memory>
+#include <mutex>
+#include <span>
+
+namespace Engine
+{
+    // One vertex buffer and one index buffer shared by every model, so a whole frame can draw
+    // with the same buffers bound. Indices are rebased on upload to point straight into the
+    // shared vertex buffer, and the buffers grow (keeping their contents) when they run out of room.
+    // Vertices are stored packed (see VertexPacking.hpp) and pulled by the vertex shader, meshes
+    // with per-vertex colours also get a range in the colour buffer
+    struct GeometryPool : std::enable_shared_from_this<GeometryPool>
+    {
+        using Vertex = System::GLSL::PackedVertex;
+
+        // Frames the GPU may still be drawing while the next one is recorded. Ranges handed back wait
+        // this many nextFrame() calls before anything else can be put in them
+        static constexpr std::size_t FramesInFlight = 3;
+
+        // A mesh's ranges in the pool, handed back when it is destroyed
+        struct Allocation
+        {
+            std::size_t vertex_offset = 0, vertex_count = 0;
+            std::size_t color_offset = 0, color_count = 0;
+            std::size_t index_offset = 0, index_count = 0;
+
+            Allocation() = default;
+            Allocation(Allocation&& other) noexcept;
+            Allocation& operator=(Allocation&& other) noexcept;
+            ~Allocation();
+
+            std::size_t allocated() const { return vertex_count * sizeof(Vertex) + (color_count + index_count) * sizeof(uint32_t); }
+
+        private:
+            friend struct GeometryPool;
+            std::shared_ptr<GeometryPool> pool;
+        };
+
+        struct Stats
+        {
+            std::size_t vertex_used, vertex_capacity;
+            std::size_t index_used, index_capacity;
+            // Given back, waiting for the frames in flight to be done with them. Part of used
+            std::size_t vertex_retired, index_retired;
+            float vertex_fragmentation, index_fragmentation;
+        };
+
+        // The pool everyone currently shares, created on first use and destroyed once nothing holds it
+        static std::shared_ptr<GeometryPool> get();
+
+        GeometryPool() = default;
+        GeometryPool(const GeometryPool&) = delete;
+
+        // colors is either empty or one per vertex
+        Allocation allocate(std::span<const Vertex> vertices, std::span<const uint32_t> colors, std::span<const uint32_t> indices);
+
+        // Just indices, rebased onto vertices some other allocation already put at vertex_offset.
+        // For index ranges added to a mesh after the fact, like LOD levels built on demand
+        Allocation allocateIndices(std::span<const uint32_t> indices, std::size_t vertex_offset);
+
+        // Copies a mesh's ranges back out, with the indices relative to vertex_offset again
+        void read(std::size_t vertex_offset, std::span<Vertex> vertices, std::size_t index_offset, std::span<uint32_t> indices) const;
+
+        // Makes sure that many vertices, colours and indices fit in one piece each, so a batch of
+        // allocations grows the buffers at most once
+        void reserve(std::size_t vertex_count, std::size_t color_count, std::size_t index_count);
+
+        auto vertices() const { std::lock_guard lock(mutex); return vertex_buffer; }
+        auto colors()   const { std::lock_guard lock(mutex); return color_buffer; }
+        auto indices()  const { std::lock_guard lock(mutex); return index_buffer; }
+
+        // drawIndexed wants a vertex buffer bound even though the shaders pull their vertices
+        auto binding()  const { std::lock_guard lock(mutex); return bind_buffer; }
+
+        // Called once a frame by the renderer, before it records any draws. Frees the ranges given back
+        // FramesInFlight frames ago, which nothing still in flight can be reading anymore
+        void nextFrame();
+
+        Stats stats() const;
+
+    private:
+        void release(const Allocation& allocation);
+
+        template<typename T>
+        static void grow(std::shared_ptr<mn::Graphics::TypeBuffer<T>>& buffer, Util::RangeAllocator& ranges, std::size_t count);
+
+        mutable std::mutex mutex;
+
+        std::shared_ptr<mn::Graphics::TypeBuffer<Vertex>> vertex_buffer;
+        std::shared_ptr<mn::Graphics::TypeBuffer<uint32_t>> color_buffer, index_buffer;
+        std::shared_ptr<mn::Graphics::TypeBuffer<mn::Graphics::Mesh::Vertex>> bind_buffer;
+        Util::RangeAllocator vertex_ranges, color_ranges, index_ranges;
+    };
+}
@@ -0,0 +1,82 @@
+#include "InstancePacking.hpp"
+
+#include <cmath>
+
+namespace Engine
+{
+    mn::Math::Vec4f toQuaternion(const mn::Math::Vec3f& x_axis, const mn::Math::Vec3f& y_axis, const mn::Math::Vec3f& z_axis)
+    {
+        using namespace mn::Math;
+
+        const float m00 = x(x_axis), m10 = y(x_axis), m20 = z(x_axis);
+        const float m01 = x(y_axis), m11 = y(y_axis), m21 = z(y_axis);
+        const float m02 = x(z_axis), m12 = y(z_axis), m22 = z(z_axis);
+
+        // Whichever of w, x, y, z is largest is computed first, the rest are divided by it. Near a half
+        // turn w goes to 0 and only the axis branches stay accurate
+        Vec4f q;
+        const float trace = m00 + m11 + m22;
+        if (trace > 0.f)
+        {
+            const float s = std::sqrt(trace + 1.f) * 2.f;
+            q = Vec4f{ (m21 - m12) / s, (m02 - m20) / s, (m10 - m01) / s, 0.25f * s };
+        }
+        else if (m00 > m11 && m00 > m22)
+        {
+            const float s = std::sqrt(1.f + m00 - m11 - m22) * 2.f;
+            q = Vec4f{ 0.25f * s, (m01 + m10) / s, (m02 + m20) / s, (m21 - m12) / s };
+        }
+        else if (m11 > m22)
+        {
+            const float s = std::sqrt(1.f + m11 - m00 - m22) * 2.f;
+            q = Vec4f{ (m01 + m10) / s, 0.25f * s, (m12 + m21) / s, (m02 - m20) / s };
+        }
+        else
+        {
+            const float s = std::sqrt(1.f + m22 - m00 - m11) * 2.f;
+            q = Vec4f{ (m02 + m20) / s, (m12 + m21) / s, 0.25f * s, (m10 - m01) / s };
+        }
+
+        return q * (1.f / length(q));
+    }
+
+    mn::Math::Vec4f toQuaternion(const mn::Math::Mat4<float>& rotation)
+    {
+        using namespace mn::Math;
+
+        return toQuaternion(
+            xyz(rotation * Vec4f{ 1.f, 0.f, 0.f, 0.f }),
+            xyz(rotation * Vec4f{ 0.f, 1.f, 0.f, 0.f }),
+            xyz(rotation * Vec4f{ 0.f, 0.f, 1.f, 0.f }));
+    }
+
+    mn::Math::Vec3f rotate(const mn::Math::Vec4f& quaternion, const mn::Math::Vec3f& v)
+    {
+        using namespace mn::Math;
+
+        const auto axis = xyz(quaternion);
+        return v + outer(axis, outer(axis, v) + v * w(quaternion)) * 2.f;
+    }
+
+    mn::Math::Vec3f instancePosition(const PackedInstance& instance, const mn::Math::Vec3f& position)
+    {
+        using namespace mn::Math;
+
+        const auto& s = instance.scale;
+        return instance.position + rotate(instance.rotation, Vec3f{ x(s) * x(position), y(s) * y(position), z(s) * z(position) });
+    }
+
+    mn::Math::Vec3f instanceNormal(const PackedInstance& instance, const mn::Math::Vec3f& normal)
+    {
+        using namespace mn::Math;
+
+        // The cofactors are the inverse scale times its determinant, so a zero scale on one axis doesn't
+        // divide by zero (the normal just lines up with that axis, like the flattened surface's does)
+        const auto& s = instance.scale;
+        const float flip = (x(s) * y(s) * z(s) < 0.f ? -1.f : 1.f);
+        const Vec3f scaled{ x(normal) * y(s) * z(s) * flip, y(normal) * x(s) * z(s) * flip, z(normal) * x(s) * y(s) * flip };
+
+        const float size = length(scaled);
+        return rotate(instance.rotation, size > 0.f ? scaled * (1.f / size) : scaled);
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Systems/ShaderTypes.hpp"
+
+#include <midnight/midnight.hpp>
+
+namespace Engine
+{
+    using PackedInstance = System::GLSL::Instance;
+
+    // Unit quaternion (xyz, w) of the rotation taking the basis vectors to x_axis, y_axis and z_axis.
+    // These should be orthonormal, scale belongs in the instance's own scale. Anything a little off
+    // still comes out a unit quaternion
+    mn::Math::Vec4f toQuaternion(const mn::Math::Vec3f& x_axis, const mn::Math::Vec3f& y_axis, const mn::Math::Vec3f& z_axis);
+
+    // Same, reading the axes off a rotation matrix
+    mn::Math::Vec4f toQuaternion(const mn::Math::Mat4<float>& rotation);
+
+    // What vertex.glsl does with an instance, for CPU work and the tests. Positions are scaled, rotated
+    // and moved. Normals take the inverse transpose of the scale before the rotation, so they stay
+    // perpendicular to the surface under non-uniform scale and keep pointing out of mirrored instances
+    mn::Math::Vec3f rotate(const mn::Math::Vec4f& quaternion, const mn::Math::Vec3f& v);
+    mn::Math::Vec3f instancePosition(const PackedInstance& instance, const mn::Math::Vec3f& position);
+    mn::Math::Vec3f instanceNormal(const PackedInstance& instance, const mn::Math::Vec3f& normal);
+}
@@ -1,37 +1,175 @@
 #include "Model.hpp"
+#include "ModelFile.hpp"
+#include "VertexPacking.hpp"
 
 #include "../Util/DataRep.hpp"
+#include "../Util/MappedFile.hpp"
+#include "../Util/TaskQueue.hpp"
 
-#include <type_traits>
-
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
 
 #include <imgui.h>
 
-#include <meshoptimizer.h>
-
 namespace Engine
 {
-    Model::Model(const std::filesystem::path& path, std::shared_ptr<System::Material> material_sys)
+    namespace
+    {
+        std::atomic<uint32_t> mesh_ids{0};
+
+        // Shared by every mesh's LOD chain. Leaves a core or so for the frame
+        Util::TaskQueue& lodBuilder()
+        {
+            static Util::TaskQueue queue(std::max(std::thread::hardware_concurrency() / 2, 1U));
+            return queue;
+        }
+    }
+
+    uint32_t Model::BoundedMesh::nextId()
+    {
+        return mesh_ids.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint32_t Model::BoundedMesh::idCount()
+    {
+        return mesh_ids.load(std::memory_order_relaxed);
+    }
+
+    Model::BoundedMesh::LOD::LOD(const BoundedMesh& mesh, const LodSettings& settings) :
+        pool(GeometryPool::get()),
+        aabb(mesh.aabb),
+        vertex_offset(mesh.geometry.vertex_offset),
+        vertex_count(mesh.geometry.vertex_count),
+        index_offset(mesh.geometry.index_offset),
+        index_count(mesh.index_count),
+        settings(settings),
+        slots(settings.targets.size())
+    {
+        // Until a level is built the selector goes by the most error its target lets through
+        const auto extent   = mesh.aabb.max - mesh.aabb.min;
+        const float largest = std::max({ mn::Math::x(extent), mn::Math::y(extent), mn::Math::z(extent) });
+        for (std::size_t l = 0; l < slots.size(); l++)
+            slots[l].estimate = settings.targets[l].max_error * largest;
+    }
+
+    Model::BoundedMesh::LOD::LOD(const BoundedMesh& mesh, std::span<const Level> levels) :
+        pool(GeometryPool::get()),
+        aabb(mesh.aabb),
+        vertex_offset(mesh.geometry.vertex_offset),
+        vertex_count(mesh.geometry.vertex_count),
+        index_offset(mesh.geometry.index_offset),
+        index_count(mesh.index_count),
+        settings{ .targets = {} },
+        slots(levels.size())
+    {
+        for (std::size_t l = 0; l < slots.size(); l++)
+        {
+            slots[l].level    = Level{ .offset = index_offset + levels[l].offset, .count = levels[l].count, .error = levels[l].error };
+            slots[l].estimate = levels[l].error;
+            slots[l].requested.store(true, std::memory_order_relaxed);
+            slots[l].ready.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    Model::BoundedMesh::LOD::Level Model::BoundedMesh::LOD::level(std::size_t l) const
+    {
+        const auto& slot = slots[l];
+        if (slot.ready.load(std::memory_order_acquire)) return slot.level;
+        return Level{ .error = slot.estimate };
+    }
+
+    Model::BoundedMesh::LOD::State Model::BoundedMesh::LOD::state(std::size_t l) const
+    {
+        if (slots[l].ready.load(std::memory_order_acquire)) return State::Ready;
+        return (slots[l].requested.load(std::memory_order_relaxed) ? State::Building : State::Empty);
+    }
+
+    void Model::BoundedMesh::LOD::request(std::size_t l)
+    {
+        if (l >= slots.size() || slots[l].requested.exchange(true, std::memory_order_relaxed)) return;
+
+        // Weak so a mesh dropped before its turn comes up just gets skipped
+        lodBuilder().push([weak = weak_from_this(), l]()
+        {
+            if (const auto lod = weak.lock()) lod->build(l);
+        });
+    }
+
+    void Model::BoundedMesh::LOD::build(std::size_t l)
+    {
+        // The packed vertices are all that's kept of the mesh, they're close enough to simplify from
+        std::vector<GeometryPool::Vertex> packed(vertex_count);
+        std::vector<uint32_t> indices(index_count);
+        pool->read(vertex_offset, packed, index_offset, indices);
+        const auto vertices = unpackVertices(packed, aabb);
+
+        float error;
+        const auto level = ModelFile::simplify(vertices, indices, settings, settings.targets[l], error);
+
+        auto& slot = slots[l];
+        slot.indices = pool->allocateIndices(level, vertex_offset);
+        slot.level   = Level{ .offset = slot.indices.index_offset, .count = level.size(), .error = error };
+        slot.ready.store(true, std::memory_order_release);
+    }
+
+    std::size_t Model::BoundedMesh::LOD::allocated() const
+    {
+        std::size_t total = 0;
+        for (const auto& slot : slots)
+            if (slot.ready.load(std::memory_order_acquire)) total += slot.indices.allocated();
+        return total;
+    }
+
+    std::size_t Model::BoundedMesh::LOD::pending()
+    {
+        return lodBuilder().pending();
+    }
+
+    // Whichever of the mapping or the import the views point into
+    struct Model::Staged::Meshes
+    {
+        Util::MappedFile file;
+        std::vector<ModelFile::MeshData> imported;
+        std::vector<ModelFile::MeshView> views;
+    };
+
+    Model::Model(const std::filesystem::path& path, std::shared_ptr<System::Material> material_sys, LodSettings lod_settings) :
+        _lod_settings(std::move(lod_settings))
     {
         loadFromFile(path, material_sys);
     }
 
+    Model::Model(Staged&& staged) :
+        _lod_settings(std::move(staged.lod_settings))
+    {
+        upload(staged);
+    }
+
     
     std::shared_ptr<Model::BoundedMesh> Model::pushMesh(const std::shared_ptr<mn::Graphics::Mesh>& mesh)
     {
         auto model = std::make_shared<BoundedMesh>();
-        model->mesh = mesh;
         
         const auto vertex_span = mesh->vertices();
+        const auto index_span  = mesh->indices();
+
+        // The bounds are what the positions get quantized against, so they're needed first
         for (const auto& vertex : vertex_span)
         {
             model->aabb.min = mn::Math::min(model->aabb.min, vertex.position);
             model->aabb.max = mn::Math::max(model->aabb.max, vertex.position);
         }
 
+        const auto colors  = packColors(vertex_span);
+        model->geometry    = GeometryPool::get()->allocate(packVertices(vertex_span, model->aabb), colors, index_span);
+        model->index_count = index_span.size();
+        model->source_vertex_count = vertex_span.size();
+        model->color       = (vertex_span.empty() ? 0xFFFFFFFF : packColor(vertex_span[0].color));
+        model->lods        = std::make_shared<BoundedMesh::LOD>(*model, _lod_settings);
+
         _meshes.push_back(model);
 
         return model;
@@ -42,189 +180,161 @@ namespace Engine
         _meshes.push_back(mesh);
     }
 
-    void Model::loadFromFile(const std::filesystem::path& path, std::shared_ptr<System::Material> material_sys)
+    Model::Staged Model::stage(const std::filesystem::path& path, std::shared_ptr<System::Material> material_sys, LodSettings lod_settings)
     {
-        using namespace mn;
-        using namespace mn::Graphics;
-
-        Assimp::Importer importer;
-        const auto* scene = importer.ReadFile(path.string(), 
-            aiProcess_Triangulate | 
-            aiProcess_FlipUVs | 
-            aiProcess_GenNormals |
-            aiProcess_GenBoundingBoxes);
+        const auto start = std::chrono::steady_clock::now();
 
-        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+        auto meshes = std::make_shared<Staged::Meshes>();
+        if (ModelFile::isBaked(path))
         {
-            std::cout << "Error loading model: " << path.filename().string() << "\n";
-            return;
+            // Straight from the mapping into the geometry pool
+            meshes->file = Util::MappedFile(path);
+            auto views = (meshes->file ? ModelFile::read(meshes->file) : std::nullopt);
+            if (!views) throw std::runtime_error("Error loading baked model: " + path.filename().string());
+            meshes->views = std::move(*views);
         }
+        else
+        {
+            auto imported = ModelFile::import(path);
+            if (!imported) throw std::runtime_error("Error loading model: " + path.filename().string());
+            meshes->imported = std::move(*imported);
 
-        const auto transfer_vector = 
-            [](auto& vec, const auto& in_vec)
-            {
-                Math::x(vec) = in_vec.x;
-                Math::y(vec) = in_vec.y;
-                if constexpr (std::decay_t<decltype(vec)>::Size == 3)
-                    Math::z(vec) = in_vec.z;
-            };
-
-        const std::function<void(aiNode*, const aiScene*)>
-            process = [&, this](aiNode* node, const aiScene* scene) -> void
-            {
-                for (uint32_t i = 0; i < node->mNumMeshes; i++)
-                {
-                    auto* file_mesh = scene->mMeshes[node->mMeshes[i]];
+            meshes->views.reserve(meshes->imported.size());
+            for (const auto& mesh : meshes->imported) meshes->views.push_back(mesh.view());
+        }
 
-                    // Could do this in a thread
-                    // Process mesh
-                    BoundingBox aabb;
-                    transfer_vector(aabb.min, file_mesh->mAABB.mMin);
-                    transfer_vector(aabb.max, file_mesh->mAABB.mMax);
+        return Staged{
+            .path         = path,
+            .material_sys = std::move(material_sys),
+            .lod_settings = std::move(lod_settings),
+            .meshes       = std::move(meshes),
+            .milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+        };
+    }
 
-                    Mesh::Frame frame;
-                    frame.vertices.resize(file_mesh->mNumVertices);
-                    for (uint32_t i = 0; i < file_mesh->mNumVertices; i++)
-                    {
-                        frame.vertices[i].color = { 1.f, 1.f, 1.f, 1.f };
-                        transfer_vector(frame.vertices[i].position, file_mesh->mVertices[i]);
-                        transfer_vector(frame.vertices[i].normal,   file_mesh->mNormals[i] );
-                        if (file_mesh->mTextureCoords[0])
-                            transfer_vector(frame.vertices[i].tex_coords, file_mesh->mTextureCoords[0][i]);
-                    }
+    void Model::loadFromFile(const std::filesystem::path& path, std::shared_ptr<System::Material> material_sys)
+    {
+        try
+        {
+            upload(stage(path, std::move(material_sys), _lod_settings));
+        }
+        catch (const std::runtime_error& error)
+        {
+            std::cout << error.what() << "\n";
+        }
+    }
 
-                    frame.indices.reserve(file_mesh->mNumFaces);
-                    for (uint32_t i = 0; i < file_mesh->mNumFaces; i++)
-                    {
-                        const aiFace& face = file_mesh->mFaces[i];
-                        for (uint32_t j = 0; j < face.mNumIndices; j++)
-                            frame.indices.push_back(face.mIndices[j]);
-                    }
+    void Model::upload(const Staged& staged)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const auto& meshes = staged.meshes->views;
 
-                    System::Material::Instance material;
-                    if (scene->HasMaterials() && file_mesh->mMaterialIndex < scene->mNumMaterials && material_sys.get())
-                        material = material_sys->resolveMaterial(path, scene->mMaterials[file_mesh->mMaterialIndex]);
+        // Upload everything in one go, the pool grows at most once for the whole model
+        std::size_t total_vertices = 0, total_colors = 0, total_indices = 0;
+        for (const auto& mesh : meshes)
+        {
+            total_vertices += mesh.vertices.size();
+            total_colors   += mesh.colors.size();
+            total_indices  += mesh.indices.size();
+        }
 
-                    this->_meshes.push_back(std::make_shared<BoundedMesh>(
-                        BoundedMesh {
-                            .aabb = aabb,
-                            .mesh = std::make_shared<Mesh>(Mesh::fromFrame(frame)),
-                            .material = material
-                        })
-                    );
-                }   
+        const auto geometry = GeometryPool::get();
+        geometry->reserve(total_vertices, total_colors, total_indices);
 
-                for (uint32_t i = 0; i < node->mNumChildren; i++)
-                    process(node->mChildren[i], scene);
-            };
-        process(scene->mRootNode, scene);
+        // Materials hand out rows in the order they're resolved, so this stays on one thread
+        _meshes.reserve(_meshes.size() + meshes.size());
+        for (const auto& mesh : meshes)
+        {
+            auto& bounded = _meshes.emplace_back(std::make_shared<BoundedMesh>(
+                BoundedMesh {
+                    .aabb = mesh.aabb,
+                    .geometry = geometry->allocate(mesh.vertices, mesh.colors, mesh.indices),
+                    .index_count = mesh.index_count,
+                    .source_vertex_count = mesh.source_vertex_count,
+                    .color = mesh.color,
+                    .material = (staged.material_sys ? staged.material_sys->resolveMaterial(staged.path, mesh.material) : System::Material::Instance{}),
+                    .meshlets = mesh.meshlets
+                })
+            );
 
-        optimize_mesh();
-    }
+            // Baked levels come along in the allocation, anything else is built when first needed
+            bounded->lods = (mesh.levels.empty() ? 
+                std::make_shared<BoundedMesh::LOD>(*bounded, _lod_settings) :
+                std::make_shared<BoundedMesh::LOD>(*bounded, mesh.levels));
+        }
 
-    std::size_t Model::allocated() const
-    {
-        return std::reduce(_meshes.begin(), _meshes.end(), 0U, [](auto acc, const auto& mesh) { return acc + mesh->mesh->allocated(); });
+        _load_info = LoadInfo{
+            .baked = ModelFile::isBaked(staged.path),
+            .milliseconds = staged.milliseconds + std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+        };
     }
 
-    void Model::optimize_mesh()
+    void Model::setLodSettings(const LodSettings& settings)
     {
+        _lod_settings = settings;
         for (auto& mesh : _meshes)
-        {
-            auto vertices = mesh->mesh->vertices(); 
-            auto indices  = mesh->mesh->indices();
-            meshopt_optimizeVertexCache(
-                &indices[0],
-                &indices[0], 
-                indices.size(),
-                mesh->mesh->vertexCount());
-            
-            meshopt_optimizeOverdraw(
-                &indices[0],
-                &indices[0],
-                indices.size(),
-                (float*)&vertices[0],
-                vertices.size(),
-                sizeof(mn::Graphics::Mesh::Vertex),
-                1.05f
-            );
-
-            meshopt_optimizeVertexFetch(
-                &vertices[0],
-                &indices[0],
-                indices.size(),
-                &vertices[0],
-                vertices.size(),
-                sizeof(mn::Graphics::Mesh::Vertex)
-            );
-
-            const float thresholds[] = {
-                0.001f, 0.01f, 0.1f, 0.2f, 0.5f
-            };
+            mesh->lods = std::make_shared<BoundedMesh::LOD>(*mesh, _lod_settings);
+    }
 
-            std::size_t index = 0;
-            std::vector<uint32_t> sandbox(indices.size());
-            std::vector<uint32_t> final_indices;
-            for (int i = 0; i < 5; i++)
-            {
-                size_t target_index_count = size_t(indices.size() * thresholds[i]);
-                float target_error = 1e-1f;
-
-                float lod_error = 0.f;
-                const auto size = meshopt_simplifySloppy(
-                    &sandbox[0],
-                    &indices[0],
-                    indices.size(),
-                    (float*)&vertices[0],
-                    vertices.size(),
-                    sizeof(mn::Graphics::Mesh::Vertex),
-                    target_index_count,
-                    target_error,
-                    &lod_error
-                );
-                meshopt_optimizeVertexCache(&sandbox[0], &sandbox[0], size, vertices.size());
-                std::copy(sandbox.begin(), sandbox.begin() + size, std::back_inserter(final_indices));
-                mesh->lods.lod_offsets.push_back(BoundedMesh::LOD::Level { .offset = index, .count = size });
-                index += size;
-            }
-            
-            mesh->lods.lod = std::make_shared<mn::Graphics::TypeBuffer<uint32_t>>();
-            mesh->lods.lod->resize(final_indices.size());
-            std::copy(final_indices.begin(), final_indices.end(), &mesh->lods.lod->at(0));
-        }
+    std::size_t Model::allocated() const
+    {
+        return std::reduce(_meshes.begin(), _meshes.end(), 0U, [](auto acc, const auto& mesh) 
+            { return acc + mesh->geometry.allocated() + (mesh->lods ? mesh->lods->allocated() : 0); });
     }
 
     void Model::drawUI() const
     {
-        std::size_t total_byte_size = 0;
+        std::size_t total_byte_size = 0, total_vertices = 0, total_source_vertices = 0;
         for (const auto& mesh : _meshes)
-            total_byte_size += mesh->mesh->allocated() + mesh->lods.lod->allocated();
+        {
+            total_byte_size       += mesh->geometry.allocated() + (mesh->lods ? mesh->lods->allocated() : 0);
+            total_vertices        += mesh->geometry.vertex_count;
+            total_source_vertices += mesh->source_vertex_count;
+        }
 
+        if (_load_info)
+            ImGui::Text("%s in %.1f ms", (_load_info->baked ? "Loaded baked file" : "Imported"), _load_info->milliseconds);
         ImGui::Text("Total GPU Allocation: %s kB", Util::withCommas( Util::convert<Util::Bytes, Util::Kilobytes>(total_byte_size) ).c_str());
+        ImGui::Text("Vertices: %s (%s before welding)", Util::withCommas(total_vertices).c_str(), Util::withCommas(total_source_vertices).c_str());
+        ImGui::Text("LOD levels building (all models): %lu", BoundedMesh::LOD::pending());
         for (int i = 0; i < _meshes.size(); i++)
         {
             if (ImGui::TreeNode((std::stringstream() << "Mesh " << i + 1).str().c_str()))
             {
-                ImGui::Text("Vertex Count: %s", Util::withCommas(_meshes[i]->mesh->vertexCount()).c_str());
-                ImGui::Text("Base Index Count: %s", Util::withCommas(_meshes[i]->mesh->indexCount()).c_str());
-
-                ImGui::SeparatorText((std::stringstream() << "LOD levels: " << _meshes[i]->lods.lod_offsets.size()).str().c_str());
-                if (_meshes[i]->lods.lod_offsets.size())
+                ImGui::Text("Vertex Count: %s (%s before welding)", 
+                    Util::withCommas(_meshes[i]->geometry.vertex_count).c_str(),
+                    Util::withCommas(_meshes[i]->source_vertex_count).c_str());
+                ImGui::Text("Base Index Count: %s", Util::withCommas(_meshes[i]->index_count).c_str());
+                ImGui::Text("Meshlets: %lu", _meshes[i]->meshlets.size());
+
+                const auto* lods = _meshes[i]->lods.get();
+                const auto level_count = (lods ? lods->size() : 0);
+                ImGui::SeparatorText((std::stringstream() << "LOD levels: " << level_count).str().c_str());
+                if (level_count)
                 {
-                    ImGui::BeginTable("LodOffsets", 2);
+                    ImGui::BeginTable("LodOffsets", 3);
                     ImGui::TableNextRow();
                     ImGui::TableSetColumnIndex(0);
                     ImGui::Text("Level");
                     ImGui::TableSetColumnIndex(1);
                     ImGui::Text("Index Count");
+                    ImGui::TableSetColumnIndex(2);
+                    ImGui::Text("Error");
 
-                    for (int j = 0; j < _meshes[i]->lods.lod_offsets.size(); j++)
+                    for (std::size_t j = 0; j < level_count; j++)
                     {
                         ImGui::TableNextRow();
                         ImGui::TableSetColumnIndex(0);
-                        ImGui::Text("%i", j);
+                        ImGui::Text("%lu", j);
                         ImGui::TableSetColumnIndex(1);
-                        ImGui::Text("%lu", _meshes[i]->lods.lod_offsets[j].count);
+                        switch (lods->state(j))
+                        {
+                        case BoundedMesh::LOD::State::Ready:    ImGui::Text("%lu", lods->level(j).count); break;
+                        case BoundedMesh::LOD::State::Building: ImGui::Text("building"); break;
+                        case BoundedMesh::LOD::State::Empty:    ImGui::Text("not built"); break;
+                        }
+                        ImGui::TableSetColumnIndex(2);
+                        ImGui::Text("%.4f", lods->level(j).error);
                     }
                     ImGui::EndTable();
                 }
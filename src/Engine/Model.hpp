@@ -1,41 +1,169 @@
 #pragma once
 
 #include <midnight/midnight.hpp>
+#include <atomic>
 #include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
 
+#include "GeometryPool.hpp"
 #include "Systems/Material.hpp"
 
 namespace Engine
 {
+    namespace ModelFile { struct MeshView; }
+
     struct BoundingBox
     {
         mn::Math::Vec3f min, max;
     };
 
+    // How a mesh's LOD levels get simplified, one target per level, coarsest first like the
+    // levels are numbered
+    struct LodSettings
+    {
+        struct Target
+        {
+            // Fraction of the full mesh's indices to aim for
+            float ratio;
+            // The level stops short of ratio rather than deviate further than this, relative to the mesh's extents
+            float max_error;
+        };
+
+        std::vector<Target> targets = {
+            { 0.001f, 0.1f }, { 0.01f, 0.05f }, { 0.1f, 0.02f }, { 0.2f, 0.01f }, { 0.5f, 0.005f }
+        };
+
+        // How much normal and UV error count next to the (extent relative) position error
+        float normal_weight = 0.5f, uv_weight = 0.5f;
+
+        // Open borders stay where they are, so meshes sharing an edge don't pull apart
+        bool lock_border = true;
+    };
+
     struct Model
     {
         struct BoundedMesh
         {
             BoundingBox aabb;
-            std::shared_ptr<mn::Graphics::Mesh> mesh;
+            // The full mesh's indices come first in the allocation, followed by the LOD levels if it was baked with them.
+            // The vertex positions are quantized against aabb
+            GeometryPool::Allocation geometry;
+            std::size_t index_count = 0;
+            // Vertex count as it came in, before the import welded duplicates
+            std::size_t source_vertex_count = 0;
+            // Colour of every vertex when the allocation has no colour stream, RGBA8
+            uint32_t color = 0xFFFFFFFF;
             System::Material::Instance material;
             
-            struct LOD
+            // The LOD chain. Levels are simplified on a background thread the first time someone
+            // asks for them, and read as empty (count 0) until they're in the pool. Baked meshes
+            // come with their levels already built
+            struct LOD : std::enable_shared_from_this<LOD>
             {
                 struct Level
                 {
-                    std::size_t offset, count;
+                    // Into the pool's index buffer. ModelFile hands them out relative to the mesh's
+                    // geometry.index_offset instead
+                    std::size_t offset = 0, count = 0;
+                    // Object space deviation from the full mesh. Before the level is built, the most
+                    // its target allows
+                    float error = 0.f;
                 };
 
-                std::vector<Level> lod_offsets;
-                std::shared_ptr<mn::Graphics::TypeBuffer<uint32_t>> lod;
-                // TODO: We should not have a separate index buffer here
-            } lods;
+                enum class State
+                {
+                    Empty, Building, Ready
+                };
+
+                // Nothing built yet, mesh's geometry has to be in the pool already
+                LOD(const BoundedMesh& mesh, const LodSettings& settings);
+
+                // Every level built, levels are relative to mesh.geometry.index_offset and live in its allocation
+                LOD(const BoundedMesh& mesh, std::span<const Level> levels);
+
+                std::size_t size() const { return slots.size(); }
+
+                // Everything below is safe from any thread
+                Level level(std::size_t l) const;
+                State state(std::size_t l) const;
+
+                // Queues level l for building unless it's built or on its way already
+                void request(std::size_t l);
+
+                // Pool memory the levels built so far take up
+                std::size_t allocated() const;
+
+                // Level builds queued or running, over every mesh
+                static std::size_t pending();
+
+            private:
+                struct Slot
+                {
+                    Level level;
+                    // The error level() reports until the level is built
+                    float estimate = 0.f;
+                    GeometryPool::Allocation indices;
+                    std::atomic<bool> requested{false}, ready{false};
+                };
+
+                void build(std::size_t l);
+
+                std::shared_ptr<GeometryPool> pool;
+                BoundingBox aabb;
+                std::size_t vertex_offset = 0, vertex_count = 0;
+                std::size_t index_offset = 0, index_count = 0;
+                LodSettings settings;
+                std::vector<Slot> slots;
+            };
+
+            // Never null for meshes made by Model
+            std::shared_ptr<LOD> lods;
+
+            // Clusters of the full mesh. Its indices are laid out meshlet after meshlet, so any
+            // run of neighbouring meshlets can be drawn as one range
+            struct Meshlet
+            {
+                // Relative to geometry.index_offset
+                std::size_t offset, count;
+                // Object space bounding sphere and normal cone, straight from meshoptimizer
+                mn::Math::Vec3f center;
+                float radius;
+                mn::Math::Vec3f cone_apex, cone_axis;
+                float cone_cutoff;
+            };
+
+            std::vector<Meshlet> meshlets;
+
+            // Dense id handed out on creation so systems can keep per-mesh state in flat tables
+            uint32_t id = nextId();
+
+            static uint32_t nextId();
+            static uint32_t idCount();
         };
 
+        // A model file read and processed, with nothing on the GPU yet. stage() is safe on any thread
+        // and throws if the file can't be loaded, the Staged constructor then does the upload and
+        // resolves the materials on the main thread. That's the split ResourceManager::load needs
+        struct Staged
+        {
+            struct Meshes;
+
+            std::filesystem::path path;
+            std::shared_ptr<System::Material> material_sys;
+            LodSettings lod_settings;
+            std::shared_ptr<const Meshes> meshes;
+            double milliseconds;
+        };
+
+        static Staged stage(const std::filesystem::path& path, std::shared_ptr<System::Material> material_sys = nullptr, LodSettings lod_settings = {});
+
         Model() = default;
         Model(const Model&) = delete;
-        Model(const std::filesystem::path& path, std::shared_ptr<System::Material> material_sys = nullptr);
+        Model(const std::filesystem::path& path, std::shared_ptr<System::Material> material_sys = nullptr, LodSettings lod_settings = {});
+        Model(Staged&& staged);
 
         std::shared_ptr<BoundedMesh> pushMesh(const std::shared_ptr<mn::Graphics::Mesh>& mesh);
         void pushBoundedMesh(const std::shared_ptr<BoundedMesh>& mesh);
@@ -44,13 +172,26 @@ namespace Engine
 
         const auto& getMeshes() const { return _meshes; }
 
+        // Drops every mesh's LOD levels, baked ones included, and has them rebuilt with these as the
+        // renderer asks. Only between frames
+        void setLodSettings(const LodSettings& settings);
+        const LodSettings& getLodSettings() const { return _lod_settings; }
+
         void drawUI() const;
 
         std::size_t allocated() const;
 
     private:
-        void optimize_mesh();
+        void upload(const Staged& staged);
+
+        struct LoadInfo
+        {
+            bool baked;
+            double milliseconds;
+        };
 
+        std::optional<LoadInfo> _load_info;
+        LodSettings _lod_settings;
         std::vector<std::shared_ptr<BoundedMesh>> _meshes;
     };
 }
\ No newline at end of file
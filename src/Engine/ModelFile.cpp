@@ -0,0 +1,590 @@
+#include "ModelFile.hpp"
+#include "VertexPacking.hpp"
+
+#include "../Util/ThreadPool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <type_traits>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <meshoptimizer.h>
+
+namespace Engine::ModelFile
+{
+    namespace
+    {
+        // What Assimp hands us and meshoptimizer works on, packed once everything else is done
+        using SourceVertex = mn::Graphics::Mesh::Vertex;
+
+        // Merges vertices that agree on position, normal and UV, after snapping each onto a grid far
+        // finer than the packed vertex format keeps. Plenty of formats store a vertex per triangle
+        // corner, which leaves the vertex cache optimization nothing to work with
+        void weld(std::vector<SourceVertex>& vertices, std::vector<uint32_t>& indices, const BoundingBox& aabb)
+        {
+            using namespace mn;
+
+            if (indices.empty()) return;
+
+            struct Key
+            {
+                int32_t position[3], normal[3], tex_coords[2];
+            };
+
+            const auto extent = aabb.max - aabb.min;
+            const float largest = std::max({ Math::x(extent), Math::y(extent), Math::z(extent) });
+            const float position_step = (largest > 0.f ? largest : 1.f) / float(1 << 20);
+            const auto snap = [](float value, float step) { return static_cast<int32_t>(std::lround(value / step)); };
+
+            std::vector<Key> keys(vertices.size());
+            for (std::size_t i = 0; i < vertices.size(); i++)
+            {
+                const auto& vertex = vertices[i];
+                keys[i] = Key{
+                    .position   = { snap(Math::x(vertex.position), position_step), snap(Math::y(vertex.position), position_step), snap(Math::z(vertex.position), position_step) },
+                    .normal     = { snap(Math::x(vertex.normal), 1.f / 1024.f), snap(Math::y(vertex.normal), 1.f / 1024.f), snap(Math::z(vertex.normal), 1.f / 1024.f) },
+                    .tex_coords = { snap(Math::x(vertex.tex_coords), 1.f / 65536.f), snap(Math::y(vertex.tex_coords), 1.f / 65536.f) }
+                };
+            }
+
+            // Vertices no triangle uses are dropped on the way
+            std::vector<uint32_t> remap(vertices.size());
+            const auto count = meshopt_generateVertexRemap(
+                &remap[0],
+                &indices[0],
+                indices.size(),
+                &keys[0],
+                keys.size(),
+                sizeof(Key)
+            );
+
+            std::vector<SourceVertex> welded(count);
+            meshopt_remapVertexBuffer(&welded[0], &vertices[0], vertices.size(), sizeof(SourceVertex), &remap[0]);
+            meshopt_remapIndexBuffer(&indices[0], &indices[0], indices.size(), &remap[0]);
+            vertices = std::move(welded);
+        }
+
+        // Reorders the mesh for the vertex cache/overdraw/fetch
+        void optimize(std::vector<SourceVertex>& vertices, std::vector<uint32_t>& indices)
+        {
+            if (indices.empty()) return;
+
+            meshopt_optimizeVertexCache(
+                &indices[0],
+                &indices[0], 
+                indices.size(),
+                vertices.size());
+            
+            meshopt_optimizeOverdraw(
+                &indices[0],
+                &indices[0],
+                indices.size(),
+                (float*)&vertices[0],
+                vertices.size(),
+                sizeof(SourceVertex),
+                1.05f
+            );
+
+            meshopt_optimizeVertexFetch(
+                &vertices[0],
+                &indices[0],
+                indices.size(),
+                &vertices[0],
+                vertices.size(),
+                sizeof(SourceVertex)
+            );
+        }
+
+        // Splits the first index_count indices (the full mesh) into meshlets and rewrites them
+        // meshlet by meshlet, so the renderer can draw any run of neighbouring meshlets as one range.
+        // The meshlets are built walking the cache optimized order, so locality mostly survives
+        std::vector<Meshlet> buildMeshlets(const std::vector<SourceVertex>& vertices, std::vector<uint32_t>& indices, std::size_t index_count)
+        {
+            // Sizes the meshoptimizer docs suggest, the cone weight trades some culling for tighter spheres
+            constexpr std::size_t MaxVertices  = 64;
+            constexpr std::size_t MaxTriangles = 124;
+            constexpr float ConeWeight = 0.25f;
+
+            std::vector<Meshlet> result;
+            if (!index_count) return result;
+
+            const auto bound = meshopt_buildMeshletsBound(index_count, MaxVertices, MaxTriangles);
+            std::vector<meshopt_Meshlet> meshlets(bound);
+            std::vector<uint32_t> meshlet_vertices(bound * MaxVertices);
+            std::vector<uint8_t> meshlet_triangles(bound * MaxTriangles * 3);
+
+            const auto count = meshopt_buildMeshlets(
+                meshlets.data(),
+                meshlet_vertices.data(),
+                meshlet_triangles.data(),
+                &indices[0],
+                index_count,
+                (float*)&vertices[0],
+                vertices.size(),
+                sizeof(SourceVertex),
+                MaxVertices,
+                MaxTriangles,
+                ConeWeight
+            );
+
+            std::vector<uint32_t> ordered;
+            ordered.reserve(index_count);
+            result.reserve(count);
+            for (std::size_t m = 0; m < count; m++)
+            {
+                const auto& meshlet = meshlets[m];
+                const auto bounds = meshopt_computeMeshletBounds(
+                    &meshlet_vertices[meshlet.vertex_offset],
+                    &meshlet_triangles[meshlet.triangle_offset],
+                    meshlet.triangle_count,
+                    (float*)&vertices[0],
+                    vertices.size(),
+                    sizeof(SourceVertex)
+                );
+
+                result.push_back(Meshlet{
+                    .offset      = ordered.size(),
+                    .count       = meshlet.triangle_count * 3,
+                    .center      = { bounds.center[0], bounds.center[1], bounds.center[2] },
+                    .radius      = bounds.radius,
+                    .cone_apex   = { bounds.cone_apex[0], bounds.cone_apex[1], bounds.cone_apex[2] },
+                    .cone_axis   = { bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2] },
+                    .cone_cutoff = bounds.cone_cutoff
+                });
+
+                for (std::size_t i = 0; i < meshlet.triangle_count * 3; i++)
+                    ordered.push_back(meshlet_vertices[meshlet.vertex_offset + meshlet_triangles[meshlet.triangle_offset + i]]);
+            }
+
+            // Every triangle has to land in exactly one meshlet, otherwise keep the mesh as it was
+            if (ordered.size() != index_count)
+            {
+                result.clear();
+                return result;
+            }
+
+            std::copy(ordered.begin(), ordered.end(), indices.begin());
+            return result;
+        }
+
+        // Baked layout: FileHeader, mesh_count FileMeshes, then each mesh's packed vertices, colours,
+        // indices, FileMeshlets and material string. Offsets are in bytes from the start of the file, the streams are
+        // Alignment aligned so they can be used straight out of the mapping
+        constexpr uint32_t Magic = 0x424D5053; // "SPMB"
+        constexpr std::size_t MaxLevels = 8;
+        constexpr std::size_t Alignment = 16;
+
+        struct FileHeader
+        {
+            uint32_t magic, version, vertex_size, mesh_count;
+        };
+
+        struct FileLevel
+        {
+            uint64_t offset, count;
+            float error;
+            uint32_t pad;
+        };
+
+        struct FileMeshlet
+        {
+            uint64_t offset, count;
+            float center[3], radius;
+            float cone_apex[3], cone_axis[3], cone_cutoff;
+            uint32_t pad;
+        };
+
+        struct FileMesh
+        {
+            float aabb_min[3], aabb_max[3];
+            uint32_t level_count, material_size;
+            uint32_t color, pad;
+            uint64_t vertex_offset, vertex_count, source_vertex_count;
+            uint64_t color_offset, color_count;
+            uint64_t index_offset, index_count, base_index_count;
+            uint64_t meshlet_offset, meshlet_count;
+            uint64_t material_offset;
+            FileLevel levels[MaxLevels];
+        };
+
+        static_assert(std::is_trivially_copyable_v<Vertex>);
+        static_assert(alignof(Vertex) <= Alignment);
+
+        std::size_t align(std::size_t offset)
+        {
+            return (offset + Alignment - 1) / Alignment * Alignment;
+        }
+    }
+
+    MeshView MeshData::view() const
+    {
+        return MeshView{
+            .aabb        = aabb,
+            .vertices    = vertices,
+            .source_vertex_count = source_vertex_count,
+            .colors      = colors,
+            .color       = color,
+            .indices     = indices,
+            .index_count = index_count,
+            .levels      = levels,
+            .meshlets    = meshlets,
+            .material    = material
+        };
+    }
+
+    std::vector<uint32_t> simplify(std::span<const mn::Graphics::Mesh::Vertex> vertices, std::span<const uint32_t> indices, 
+        const LodSettings& settings, const LodSettings::Target& target, float& error)
+    {
+        using namespace mn;
+
+        std::vector<uint32_t> result;
+        error = 0.f;
+        if (vertices.empty() || indices.empty()) return result;
+
+        // Normals and UVs side by side, meshoptimizer wants the attributes as one float array
+        constexpr std::size_t AttributeCount = 5;
+        std::vector<float> attributes(vertices.size() * AttributeCount);
+        for (std::size_t i = 0; i < vertices.size(); i++)
+        {
+            float* out = &attributes[i * AttributeCount];
+            out[0] = Math::x(vertices[i].normal);
+            out[1] = Math::y(vertices[i].normal);
+            out[2] = Math::z(vertices[i].normal);
+            out[3] = Math::x(vertices[i].tex_coords);
+            out[4] = Math::y(vertices[i].tex_coords);
+        }
+
+        const float weights[AttributeCount] = {
+            settings.normal_weight, settings.normal_weight, settings.normal_weight, settings.uv_weight, settings.uv_weight
+        };
+
+        result.resize(indices.size());
+        float relative_error = 0.f;
+        const auto size = meshopt_simplifyWithAttributes(
+            &result[0],
+            &indices[0],
+            indices.size(),
+            (const float*)&vertices[0],
+            vertices.size(),
+            sizeof(SourceVertex),
+            &attributes[0],
+            sizeof(float) * AttributeCount,
+            weights,
+            AttributeCount,
+            nullptr,
+            static_cast<std::size_t>(indices.size() * target.ratio) / 3 * 3,
+            target.max_error,
+            (settings.lock_border ? meshopt_SimplifyLockBorder : 0),
+            &relative_error
+        );
+
+        result.resize(size);
+        if (size) meshopt_optimizeVertexCache(&result[0], &result[0], size, vertices.size());
+
+        // meshopt reports errors relative to the mesh extents, so scale them back into object space
+        error = relative_error * meshopt_simplifyScale((const float*)&vertices[0], vertices.size(), sizeof(SourceVertex));
+        return result;
+    }
+
+    std::optional<std::vector<MeshData>> import(const std::filesystem::path& path, std::size_t thread_count, const std::optional<LodSettings>& lods)
+    {
+        using namespace mn;
+
+        Assimp::Importer importer;
+        const auto* scene = importer.ReadFile(path.string(), 
+            aiProcess_Triangulate | 
+            aiProcess_FlipUVs | 
+            aiProcess_GenNormals |
+            aiProcess_GenBoundingBoxes);
+
+        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+            return std::nullopt;
+
+        const auto transfer_vector = 
+            [](auto& vec, const auto& in_vec)
+            {
+                Math::x(vec) = in_vec.x;
+                Math::y(vec) = in_vec.y;
+                if constexpr (std::decay_t<decltype(vec)>::Size == 3)
+                    Math::z(vec) = in_vec.z;
+            };
+
+        // Walk the node tree first so the meshes keep the file's depth-first order however the work is split up
+        std::vector<const aiMesh*> file_meshes;
+        const std::function<void(const aiNode*)>
+            collect = [&](const aiNode* node) -> void
+            {
+                for (uint32_t i = 0; i < node->mNumMeshes; i++)
+                    file_meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+
+                for (uint32_t i = 0; i < node->mNumChildren; i++)
+                    collect(node->mChildren[i]);
+            };
+        collect(scene->mRootNode);
+
+        std::vector<MeshData> meshes(file_meshes.size());
+
+        // Every mesh is converted and optimized on its own
+        if (!thread_count) thread_count = std::thread::hardware_concurrency();
+        Util::ThreadPool pool(std::clamp<std::size_t>(thread_count, 1, std::max<std::size_t>(file_meshes.size(), 1)));
+        pool.parallel_for(file_meshes.size(),
+            [&](std::size_t m, std::size_t)
+            {
+                const auto* file_mesh = file_meshes[m];
+                auto& result = meshes[m];
+
+                transfer_vector(result.aabb.min, file_mesh->mAABB.mMin);
+                transfer_vector(result.aabb.max, file_mesh->mAABB.mMax);
+
+                // Only the first diffuse map is used
+                aiString texture;
+                if (scene->HasMaterials() && file_mesh->mMaterialIndex < scene->mNumMaterials &&
+                    scene->mMaterials[file_mesh->mMaterialIndex]->GetTexture(aiTextureType_DIFFUSE, 0, &texture) == aiReturn_SUCCESS)
+                    result.material.diffuse = texture.C_Str();
+
+                std::vector<SourceVertex> vertices(file_mesh->mNumVertices);
+                for (uint32_t i = 0; i < file_mesh->mNumVertices; i++)
+                {
+                    vertices[i].color = { 1.f, 1.f, 1.f, 1.f };
+                    transfer_vector(vertices[i].position, file_mesh->mVertices[i]);
+                    transfer_vector(vertices[i].normal,   file_mesh->mNormals[i] );
+                    if (file_mesh->mTextureCoords[0])
+                        transfer_vector(vertices[i].tex_coords, file_mesh->mTextureCoords[0][i]);
+                }
+
+                result.indices.reserve(file_mesh->mNumFaces * 3);
+                for (uint32_t i = 0; i < file_mesh->mNumFaces; i++)
+                {
+                    const aiFace& face = file_mesh->mFaces[i];
+                    for (uint32_t j = 0; j < face.mNumIndices; j++)
+                        result.indices.push_back(face.mIndices[j]);
+                }
+
+                result.source_vertex_count = vertices.size();
+                weld(vertices, result.indices, result.aabb);
+
+                optimize(vertices, result.indices);
+                result.index_count = result.indices.size();
+                result.meshlets    = buildMeshlets(vertices, result.indices, result.index_count);
+
+                // Levels go after the full mesh, in the meshlet order it ends up in
+                if (lods)
+                    for (const auto& target : lods->targets)
+                    {
+                        float error;
+                        const auto level = simplify(vertices, std::span(result.indices).first(result.index_count), *lods, target, error);
+                        result.levels.push_back(Level{ .offset = result.indices.size(), .count = level.size(), .error = error });
+                        result.indices.insert(result.indices.end(), level.begin(), level.end());
+                    }
+
+                result.colors   = packColors(vertices);
+                result.color    = (vertices.empty() ? 0xFFFFFFFF : packColor(vertices[0].color));
+                result.vertices = packVertices(vertices, result.aabb);
+            });
+
+        return meshes;
+    }
+
+
+    bool isBaked(const std::filesystem::path& path)
+    {
+        return path.extension() == Extension;
+    }
+
+    bool write(const std::filesystem::path& path, std::span<const MeshData> meshes)
+    {
+        std::vector<FileMesh> table(meshes.size());
+
+        std::size_t offset = sizeof(FileHeader) + sizeof(FileMesh) * meshes.size();
+        for (std::size_t m = 0; m < meshes.size(); m++)
+        {
+            const auto& mesh = meshes[m];
+            if (mesh.levels.size() > MaxLevels) return false;
+
+            auto& entry = table[m];
+            std::memset(&entry, 0, sizeof(entry));
+            entry.aabb_min[0] = mn::Math::x(mesh.aabb.min);
+            entry.aabb_min[1] = mn::Math::y(mesh.aabb.min);
+            entry.aabb_min[2] = mn::Math::z(mesh.aabb.min);
+            entry.aabb_max[0] = mn::Math::x(mesh.aabb.max);
+            entry.aabb_max[1] = mn::Math::y(mesh.aabb.max);
+            entry.aabb_max[2] = mn::Math::z(mesh.aabb.max);
+            entry.level_count   = static_cast<uint32_t>(mesh.levels.size());
+            entry.material_size = static_cast<uint32_t>(mesh.material.diffuse.size());
+            for (std::size_t l = 0; l < mesh.levels.size(); l++)
+                entry.levels[l] = FileLevel{ .offset = mesh.levels[l].offset, .count = mesh.levels[l].count, .error = mesh.levels[l].error };
+
+            entry.vertex_offset    = align(offset);
+            entry.vertex_count     = mesh.vertices.size();
+            entry.color            = mesh.color;
+            entry.source_vertex_count = mesh.source_vertex_count;
+            entry.color_offset     = align(entry.vertex_offset + mesh.vertices.size() * sizeof(Vertex));
+            entry.color_count      = mesh.colors.size();
+            entry.index_offset     = align(entry.color_offset + mesh.colors.size() * sizeof(uint32_t));
+            entry.index_count      = mesh.indices.size();
+            entry.base_index_count = mesh.index_count;
+            entry.meshlet_offset   = align(entry.index_offset + mesh.indices.size() * sizeof(uint32_t));
+            entry.meshlet_count    = mesh.meshlets.size();
+            entry.material_offset  = entry.meshlet_offset + mesh.meshlets.size() * sizeof(FileMeshlet);
+            offset = entry.material_offset + entry.material_size;
+        }
+
+        // Written next to the target and moved over it, so a reader never sees half a file
+        auto temp_path = path;
+        temp_path += ".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            if (!file) return false;
+
+            const FileHeader header{
+                .magic       = Magic,
+                .version     = Version,
+                .vertex_size = sizeof(Vertex),
+                .mesh_count  = static_cast<uint32_t>(meshes.size())
+            };
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(table.data()), sizeof(FileMesh) * table.size());
+
+            const char zeros[Alignment] = {};
+            std::size_t written = sizeof(FileHeader) + sizeof(FileMesh) * table.size();
+            const auto pad_to = [&](std::size_t target)
+            {
+                file.write(zeros, target - written);
+                written = target;
+            };
+
+            for (std::size_t m = 0; m < meshes.size(); m++)
+            {
+                const auto& mesh  = meshes[m];
+                const auto& entry = table[m];
+
+                pad_to(entry.vertex_offset);
+                file.write(reinterpret_cast<const char*>(mesh.vertices.data()), mesh.vertices.size() * sizeof(Vertex));
+                written += mesh.vertices.size() * sizeof(Vertex);
+
+                pad_to(entry.color_offset);
+                file.write(reinterpret_cast<const char*>(mesh.colors.data()), mesh.colors.size() * sizeof(uint32_t));
+                written += mesh.colors.size() * sizeof(uint32_t);
+
+                pad_to(entry.index_offset);
+                file.write(reinterpret_cast<const char*>(mesh.indices.data()), mesh.indices.size() * sizeof(uint32_t));
+                written += mesh.indices.size() * sizeof(uint32_t);
+
+                pad_to(entry.meshlet_offset);
+                for (const auto& meshlet : mesh.meshlets)
+                {
+                    const FileMeshlet out{
+                        .offset      = meshlet.offset,
+                        .count       = meshlet.count,
+                        .center      = { mn::Math::x(meshlet.center), mn::Math::y(meshlet.center), mn::Math::z(meshlet.center) },
+                        .radius      = meshlet.radius,
+                        .cone_apex   = { mn::Math::x(meshlet.cone_apex), mn::Math::y(meshlet.cone_apex), mn::Math::z(meshlet.cone_apex) },
+                        .cone_axis   = { mn::Math::x(meshlet.cone_axis), mn::Math::y(meshlet.cone_axis), mn::Math::z(meshlet.cone_axis) },
+                        .cone_cutoff = meshlet.cone_cutoff
+                    };
+                    file.write(reinterpret_cast<const char*>(&out), sizeof(out));
+                }
+                written += mesh.meshlets.size() * sizeof(FileMeshlet);
+
+                file.write(mesh.material.diffuse.data(), mesh.material.diffuse.size());
+                written += mesh.material.diffuse.size();
+            }
+
+            if (!file) return false;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temp_path, path, error);
+        return !error;
+    }
+
+    std::optional<std::vector<MeshView>> read(const Util::MappedFile& file)
+    {
+        const auto bytes = file.bytes();
+        const auto* data = bytes.data();
+
+        FileHeader header;
+        if (bytes.size() < sizeof(header)) return std::nullopt;
+        std::memcpy(&header, data, sizeof(header));
+
+        if (header.magic != Magic || header.version != Version || header.vertex_size != sizeof(Vertex)) return std::nullopt;
+        if ((bytes.size() - sizeof(header)) / sizeof(FileMesh) < header.mesh_count) return std::nullopt;
+
+        const auto fits = [&](uint64_t offset, uint64_t count, uint64_t size)
+        {
+            return offset <= bytes.size() && count <= (bytes.size() - offset) / size;
+        };
+
+        std::vector<MeshView> meshes;
+        meshes.reserve(header.mesh_count);
+        for (uint32_t m = 0; m < header.mesh_count; m++)
+        {
+            FileMesh entry;
+            std::memcpy(&entry, data + sizeof(header) + m * sizeof(FileMesh), sizeof(entry));
+
+            if (entry.vertex_offset % Alignment || entry.color_offset % Alignment || entry.index_offset % Alignment || entry.meshlet_offset % Alignment) 
+                return std::nullopt;
+            if (!fits(entry.vertex_offset, entry.vertex_count, sizeof(Vertex)) ||
+                !fits(entry.color_offset, entry.color_count, sizeof(uint32_t)) ||
+                (entry.color_count && entry.color_count != entry.vertex_count) ||
+                !fits(entry.index_offset, entry.index_count, sizeof(uint32_t)) ||
+                !fits(entry.meshlet_offset, entry.meshlet_count, sizeof(FileMeshlet)) ||
+                !fits(entry.material_offset, entry.material_size, 1) ||
+                entry.level_count > MaxLevels || entry.base_index_count > entry.index_count) 
+                return std::nullopt;
+
+            MeshView mesh{
+                .aabb = BoundingBox{
+                    .min = { entry.aabb_min[0], entry.aabb_min[1], entry.aabb_min[2] },
+                    .max = { entry.aabb_max[0], entry.aabb_max[1], entry.aabb_max[2] }
+                },
+                .vertices    = { reinterpret_cast<const Vertex*>(data + entry.vertex_offset), entry.vertex_count },
+                .source_vertex_count = entry.source_vertex_count,
+                .colors      = { reinterpret_cast<const uint32_t*>(data + entry.color_offset), entry.color_count },
+                .color       = entry.color,
+                .indices     = { reinterpret_cast<const uint32_t*>(data + entry.index_offset), entry.index_count },
+                .index_count = entry.base_index_count,
+                .material    = { .diffuse = std::string(reinterpret_cast<const char*>(data + entry.material_offset), entry.material_size) }
+            };
+
+            // The indices go into the pool as they are, one past the vertices would draw another mesh's
+            if (std::any_of(mesh.indices.begin(), mesh.indices.end(), [&](uint32_t index) { return index >= entry.vertex_count; }))
+                return std::nullopt;
+
+            for (uint32_t l = 0; l < entry.level_count; l++)
+            {
+                const auto& level = entry.levels[l];
+                if (level.offset > entry.index_count || level.count > entry.index_count - level.offset) return std::nullopt;
+                mesh.levels.push_back(Level{ .offset = level.offset, .count = level.count, .error = level.error });
+            }
+
+            mesh.meshlets.reserve(entry.meshlet_count);
+            for (uint64_t i = 0; i < entry.meshlet_count; i++)
+            {
+                FileMeshlet meshlet;
+                std::memcpy(&meshlet, data + entry.meshlet_offset + i * sizeof(FileMeshlet), sizeof(meshlet));
+                if (meshlet.offset > entry.base_index_count || meshlet.count > entry.base_index_count - meshlet.offset) return std::nullopt;
+                mesh.meshlets.push_back(Meshlet{
+                    .offset      = meshlet.offset,
+                    .count       = meshlet.count,
+                    .center      = { meshlet.center[0], meshlet.center[1], meshlet.center[2] },
+                    .radius      = meshlet.radius,
+                    .cone_apex   = { meshlet.cone_apex[0], meshlet.cone_apex[1], meshlet.cone_apex[2] },
+                    .cone_axis   = { meshlet.cone_axis[0], meshlet.cone_axis[1], meshlet.cone_axis[2] },
+                    .cone_cutoff = meshlet.cone_cutoff
+                });
+            }
+
+            meshes.push_back(std::move(mesh));
+        }
+
+        return meshes;
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Model.hpp"
+#include "../Util/MappedFile.hpp"
+
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace Engine::ModelFile
+{
+    using Vertex = GeometryPool::Vertex;
+    using Level   = Model::BoundedMesh::LOD::Level;
+    using Meshlet = Model::BoundedMesh::Meshlet;
+
+    // A mesh ready for the geometry pool: the welded and optimized vertices packed against aabb, their
+    // colours (empty when they all share color), then the full mesh's indices (in meshlet order)
+    // followed by the LOD levels', if it was imported with any. Both imports and baked files end up as these
+    struct MeshView
+    {
+        BoundingBox aabb;
+        std::span<const Vertex> vertices;
+        std::size_t source_vertex_count;
+        std::span<const uint32_t> colors;
+        uint32_t color;
+        std::span<const uint32_t> indices;
+        std::size_t index_count;
+        std::vector<Level> levels;
+        std::vector<Meshlet> meshlets;
+        System::Material::Description material;
+    };
+
+    // Owns what an import produced
+    struct MeshData
+    {
+        BoundingBox aabb;
+        std::vector<Vertex> vertices;
+        // How many the file had before welding
+        std::size_t source_vertex_count = 0;
+        std::vector<uint32_t> colors;
+        uint32_t color = 0xFFFFFFFF;
+        std::vector<uint32_t> indices;
+        std::size_t index_count;
+        std::vector<Level> levels;
+        std::vector<Meshlet> meshlets;
+        System::Material::Description material;
+
+        MeshView view() const;
+    };
+
+    // Assimp import plus all the meshoptimizer processing, meshes in the file's depth-first
+    // node order. Nothing here touches the GPU. The meshes are processed on thread_count
+    // threads, 0 for one per core. LOD levels are only built here when lods is set (the baker does),
+    // otherwise the renderer has them built as it needs them
+    std::optional<std::vector<MeshData>> import(const std::filesystem::path& path, std::size_t thread_count = 0, 
+        const std::optional<LodSettings>& lods = std::nullopt);
+
+    // One LOD level towards target over the given mesh, weighing in normals and UVs. Returns the
+    // level's indices, vertex cache optimized, and its object space error. Safe off the main thread
+    std::vector<uint32_t> simplify(std::span<const mn::Graphics::Mesh::Vertex> vertices, std::span<const uint32_t> indices, 
+        const LodSettings& settings, const LodSettings::Target& target, float& error);
+
+    // Baked files are the imported meshes written out as is, so loading one is a mapping and a copy
+    // into the geometry pool. Bump Version whenever the layout or the processing changes
+    inline const std::filesystem::path Extension = ".spm";
+    constexpr uint32_t Version = 5;
+
+    bool isBaked(const std::filesystem::path& path);
+
+    bool write(const std::filesystem::path& path, std::span<const MeshData> meshes);
+
+    // The spans point into file, which has to stay mapped while they're in use. Empty if the
+    // file is not a baked model of this version, or anything in it points outside the file or
+    // its mesh's vertices
+    std::optional<std::vector<MeshView>> read(const Util::MappedFile& file);
+}
@@ -3,6 +3,19 @@
 #include <unordered_map>
 #include <memory>
 #include <typeindex>
+#include <atomic>
+#include <cassert>
+#include <concepts>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "../Util/Profiler.hpp"
+#include "../Util/TaskQueue.hpp"
 
 #include <cxxabi.h>
 
@@ -17,12 +30,145 @@ namespace Engine
             std::shared_ptr<T> value;
         };
 
+        // What load() needs of a type: T::stage(args...) does everything that can happen off the main
+        // thread (reading, decoding, processing) and returns a T::Staged, which T is then built from
+        // on the main thread, where it's safe to create GPU resources
+        template<typename T, typename... Args>
+        static constexpr bool Stageable = requires (Args&&... args)
+        {
+            { T::stage(std::forward<Args>(args)...) } -> std::same_as<typename T::Staged>;
+        } && std::constructible_from<T, typename T::Staged&&>;
+
+        // Handed out by load() while the resource is staged on a background thread. It resolves
+        // between frames in update(), so a coroutine can co_await it and carry on on the main thread.
+        // If either half of the load threw, it resolves with no value and the exception in error(),
+        // co_await rethrows it
+        template<typename T>
+        struct Pending
+        {
+            struct State
+            {
+                std::string name;
+                std::optional<typename T::Staged> staged;
+                std::shared_ptr<T> value;
+                std::exception_ptr error;
+                std::atomic<bool> built{false};
+                bool resolved = false;
+                std::size_t profile_id;
+                std::vector<std::coroutine_handle<>> waiters;
+            };
+
+            std::shared_ptr<State> state;
+
+            bool loading() const { return state && !state->resolved; }
+            bool ready()   const { return state && state->resolved; }
+            bool failed()  const { return ready() && state->error; }
+
+            std::exception_ptr error() const { return (state ? state->error : nullptr); }
+
+            Entry<T> entry() const { return Entry<T>{ .name = state->name, .value = state->value }; }
+
+            bool await_ready() const { return ready(); }
+            void await_suspend(std::coroutine_handle<> handle) const { state->waiters.push_back(handle); }
+            Entry<T> await_resume() const
+            {
+                if (state->error) std::rethrow_exception(state->error);
+                return entry();
+            }
+        };
+
+        // Stages T on a loader thread, then builds it from that and registers it under name once
+        // update() sees the staging finished. The arguments are copied
+        template<typename T, typename... Args>
+            requires Stageable<T, Args...>
+        Pending<T>
+        load(const std::string& name, Args&&... args)
+        {
+            using State = typename Pending<T>::State;
+
+            if (!loader) loader = std::make_unique<Util::TaskQueue>(LoaderThreads);
+
+            auto state = std::make_shared<State>();
+            state->name = name;
+            state->profile_id = profiler.beginBlock("ResourceLoad");
+
+            // An exception getting out of here would take the loader thread and the program with it
+            loader->push([state, args = std::make_tuple(std::forward<Args>(args)...)]() mutable
+            {
+                try
+                {
+                    state->staged.emplace(std::apply([](auto&&... a) { return T::stage(std::move(a)...); }, std::move(args)));
+                }
+                catch (...)
+                {
+                    state->error = std::current_exception();
+                }
+                state->built.store(true, std::memory_order_release);
+            });
+
+            in_flight.push_back([this, state]()
+            {
+                if (!state->built.load(std::memory_order_acquire)) return false;
+
+                if (!state->error)
+                {
+                    try
+                    {
+                        state->value = std::make_shared<T>(std::move(*state->staged));
+                        insert<T>(state->name, state->value);
+                    }
+                    catch (...)
+                    {
+                        state->error = std::current_exception();
+                    }
+                }
+                state->staged.reset();
+                state->resolved = true;
+                profiler.endBlock(state->profile_id, "ResourceLoad");
+
+                for (auto waiter : std::exchange(state->waiters, {})) waiter.resume();
+                return true;
+            });
+
+            return Pending<T>{ .state = state };
+        }
+
+        // Called between frames on the main thread. Registers every finished load and resumes
+        // whatever was waiting on it, returns how many finished
+        std::size_t update()
+        {
+            std::size_t finished = 0;
+
+            // A resumed coroutine may well start another load, so walk a copy
+            auto current = std::exchange(in_flight, {});
+            for (auto& resolve : current)
+            {
+                if (resolve()) finished++;
+                else in_flight.push_back(std::move(resolve));
+            }
+
+            return finished;
+        }
+
+        // Loads started but not registered yet
+        std::size_t loading() const { return in_flight.size(); }
+
+        // Average ms from load() to registration over the last few seconds
+        double loadLatency() const { return profiler.getBlock("ResourceLoad")->getAverageRuntime(5.0); }
+
         template<typename T, typename... Args>
         Entry<T>
         create(const std::string& name, Args&&... args)
+        {
+            return insert<T>(name, std::make_shared<T>(std::forward<Args>(args)...));
+        }
+
+        // Registers something that was built elsewhere
+        template<typename T>
+        Entry<T>
+        insert(const std::string& name, std::shared_ptr<T> ptr)
         {
             const auto tid = std::type_index(typeid(T));
-            auto ptr = std::make_shared<T>(std::forward<Args>(args)...);
             resources[tid][name] = ptr;
             return Entry<T>{ .name = name, .value = ptr };
         }
@@ -69,6 +215,14 @@ namespace Engine
         }
     
     private:
+        static constexpr std::size_t LoaderThreads = 2;
+
         std::unordered_map<std::type_index, std::unordered_map<std::string, std::shared_ptr<void>>> resources;
+
+        std::vector<std::function<bool()>> in_flight;
+        mutable Util::Profiler profiler;
+
+        // Last so the loader threads are joined before anything they write to goes away
+        std::unique_ptr<Util::TaskQueue> loader;
     };
 }
\ No newline at end of file
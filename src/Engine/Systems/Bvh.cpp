@@ -0,0 +1,396 @@
+#include "Bvh.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+namespace Engine::System
+{
+    namespace
+    {
+        BoundingBox merge(const BoundingBox& a, const BoundingBox& b)
+        {
+            return BoundingBox{ mn::Math::min(a.min, b.min), mn::Math::max(a.max, b.max) };
+        }
+
+        double area(const BoundingBox& box)
+        {
+            using namespace mn;
+
+            const auto extent = box.max - box.min;
+            return 2.0 * (double(Math::x(extent)) * Math::y(extent) + double(Math::y(extent)) * Math::z(extent) + double(Math::z(extent)) * Math::x(extent));
+        }
+
+        bool same(const BoundingBox& a, const BoundingBox& b)
+        {
+            using namespace mn;
+
+            return Math::x(a.min) == Math::x(b.min) && Math::y(a.min) == Math::y(b.min) && Math::z(a.min) == Math::z(b.min) &&
+                   Math::x(a.max) == Math::x(b.max) && Math::y(a.max) == Math::y(b.max) && Math::z(a.max) == Math::z(b.max);
+        }
+
+        float axis(const mn::Math::Vec3f& v, int a)
+        {
+            return (a == 0 ? mn::Math::x(v) : a == 1 ? mn::Math::y(v) : mn::Math::z(v));
+        }
+    }
+
+    uint32_t Bvh::allocate()
+    {
+        if (free_list == Null)
+        {
+            nodes.emplace_back();
+            return static_cast<uint32_t>(nodes.size() - 1);
+        }
+
+        const auto node = free_list;
+        free_list = nodes[node].parent;
+        nodes[node] = Node{};
+        return node;
+    }
+
+    void Bvh::release(uint32_t node)
+    {
+        nodes[node] = Node{};
+        nodes[node].parent = free_list;
+        free_list = node;
+    }
+
+    uint32_t Bvh::insert(uint32_t item, const BoundingBox& box)
+    {
+        const auto leaf = allocate();
+        nodes[leaf].box  = box;
+        nodes[leaf].item = item;
+        leaf_count++;
+
+        if (root == Null)
+        {
+            root = leaf;
+            return leaf;
+        }
+
+        // Walk down towards the sibling that grows the tree's surface area the least, stopping
+        // once pairing up with the current node is cheaper than going further
+        auto sibling = root;
+        while (!nodes[sibling].leaf())
+        {
+            const auto& node = nodes[sibling];
+            const double combined    = area(merge(node.box, box));
+            const double cost        = 2.0 * combined;
+            const double inheritance = 2.0 * (combined - area(node.box));
+
+            const auto descend = [&](uint32_t child)
+            {
+                const auto& c = nodes[child];
+                const double grown = area(merge(c.box, box));
+                return (c.leaf() ? grown : grown - area(c.box)) + inheritance;
+            };
+
+            const double left = descend(node.left), right = descend(node.right);
+            if (cost < left && cost < right) break;
+            sibling = (left < right ? node.left : node.right);
+        }
+
+        const auto old_parent = nodes[sibling].parent;
+        const auto parent = allocate();
+        nodes[parent].parent = old_parent;
+        nodes[parent].box    = merge(nodes[sibling].box, box);
+        nodes[parent].left   = sibling;
+        nodes[parent].right  = leaf;
+        internal_area += area(nodes[parent].box);
+
+        nodes[sibling].parent = parent;
+        nodes[leaf].parent    = parent;
+
+        if (old_parent == Null)
+            root = parent;
+        else
+        {
+            (nodes[old_parent].left == sibling ? nodes[old_parent].left : nodes[old_parent].right) = parent;
+            refit(old_parent);
+        }
+
+        return leaf;
+    }
+
+    void Bvh::remove(uint32_t leaf)
+    {
+        leaf_count--;
+        if (leaf == root)
+        {
+            root = Null;
+            release(leaf);
+            return;
+        }
+
+        // The sibling takes the parent's place
+        const auto parent  = nodes[leaf].parent;
+        const auto grand   = nodes[parent].parent;
+        const auto sibling = (nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left);
+
+        nodes[sibling].parent = grand;
+        if (grand == Null)
+            root = sibling;
+        else
+            (nodes[grand].left == parent ? nodes[grand].left : nodes[grand].right) = sibling;
+
+        internal_area -= area(nodes[parent].box);
+        release(parent);
+        release(leaf);
+
+        if (grand != Null) refit(grand);
+    }
+
+    bool Bvh::update(uint32_t leaf, const BoundingBox& box)
+    {
+        if (same(nodes[leaf].box, box)) return false;
+
+        nodes[leaf].box = box;
+        refit(nodes[leaf].parent);
+        return true;
+    }
+
+    void Bvh::refit(uint32_t node)
+    {
+        while (node != Null)
+        {
+            auto& n = nodes[node];
+            const auto box = merge(nodes[n.left].box, nodes[n.right].box);
+            if (same(box, n.box)) break;
+
+            internal_area += area(box) - area(n.box);
+            n.box = box;
+            node = n.parent;
+        }
+    }
+
+    void Bvh::clear()
+    {
+        nodes.clear();
+        root = free_list = Null;
+        leaf_count = 0;
+        internal_area = built_cost = 0.0;
+    }
+
+    void Bvh::rebuild()
+    {
+        using namespace mn;
+
+        // Leaves keep their nodes (and so their handles), everything else goes back on the free list
+        leaves.clear();
+        free_list = Null;
+        for (uint32_t n = static_cast<uint32_t>(nodes.size()); n-- > 0;)
+        {
+            if (nodes[n].leaf() && nodes[n].item != Null)
+                leaves.push_back(n);
+            else
+                release(n);
+        }
+
+        internal_area = 0.0;
+        root = Null;
+        if (leaves.empty()) return;
+
+        centroids.resize(nodes.size());
+        for (const auto leaf : leaves)
+            centroids[leaf] = (nodes[leaf].box.min + nodes[leaf].box.max) * 0.5f;
+
+        root = build(0, leaves.size());
+        nodes[root].parent = Null;
+
+        const double root_area = area(nodes[root].box);
+        built_cost = (root_area > 0.0 ? internal_area / root_area : 0.0);
+    }
+
+    uint32_t Bvh::build(std::size_t first, std::size_t last)
+    {
+        using namespace mn;
+
+        if (last - first == 1) return leaves[first];
+
+        Math::Vec3f lo = centroids[leaves[first]], hi = lo;
+        for (std::size_t i = first; i < last; i++)
+        {
+            lo = Math::min(lo, centroids[leaves[i]]);
+            hi = Math::max(hi, centroids[leaves[i]]);
+        }
+
+        const auto extent = hi - lo;
+        const int a = (Math::x(extent) >= Math::y(extent) && Math::x(extent) >= Math::z(extent)) ? 0 : (Math::y(extent) >= Math::z(extent) ? 1 : 2);
+        const float min = axis(lo, a), size = axis(extent, a);
+
+        std::size_t mid = first;
+        if (size > 0.f)
+        {
+            // Bin the centroids along the widest axis and split where the surface area heuristic is lowest
+            constexpr int Bins = 16;
+            struct Bin
+            {
+                BoundingBox box;
+                std::size_t count = 0;
+            };
+
+            std::array<Bin, Bins> bins;
+            const auto bin_of = [&](uint32_t leaf)
+            {
+                return std::min(static_cast<int>((axis(centroids[leaf], a) - min) / size * Bins), Bins - 1);
+            };
+
+            for (std::size_t i = first; i < last; i++)
+            {
+                auto& bin = bins[bin_of(leaves[i])];
+                bin.box = (bin.count ? merge(bin.box, nodes[leaves[i]].box) : nodes[leaves[i]].box);
+                bin.count++;
+            }
+
+            // Cost of everything left of each split, then sweep back from the right
+            std::array<double, Bins - 1> left_cost;
+            BoundingBox box;
+            std::size_t count = 0;
+            for (int b = 0; b < Bins - 1; b++)
+            {
+                if (bins[b].count) box = (count ? merge(box, bins[b].box) : bins[b].box);
+                count += bins[b].count;
+                left_cost[b] = (count ? area(box) * count : 0.0);
+            }
+
+            double best = std::numeric_limits<double>::max();
+            int split = -1;
+            count = 0;
+            for (int b = Bins - 1; b > 0; b--)
+            {
+                if (bins[b].count) box = (count ? merge(box, bins[b].box) : bins[b].box);
+                count += bins[b].count;
+
+                const auto left_count = (last - first) - count;
+                if (!count || !left_count) continue;
+
+                const double cost = left_cost[b - 1] + area(box) * count;
+                if (cost < best)
+                {
+                    best  = cost;
+                    split = b;
+                }
+            }
+
+            if (split > 0)
+                mid = std::partition(leaves.begin() + first, leaves.begin() + last, [&](uint32_t leaf) { return bin_of(leaf) < split; }) - leaves.begin();
+        }
+
+        // Everything on one spot, or the bins couldn't tell them apart, halve by count
+        if (mid == first || mid == last)
+        {
+            mid = first + (last - first) / 2;
+            std::nth_element(leaves.begin() + first, leaves.begin() + mid, leaves.begin() + last,
+                [&](uint32_t l, uint32_t r) { return axis(centroids[l], a) < axis(centroids[r], a); });
+        }
+
+        const auto left  = build(first, mid);
+        const auto right = build(mid, last);
+
+        const auto node = allocate();
+        nodes[node].left  = left;
+        nodes[node].right = right;
+        nodes[node].box   = merge(nodes[left].box, nodes[right].box);
+        nodes[left].parent = nodes[right].parent = node;
+        internal_area += area(nodes[node].box);
+
+        return node;
+    }
+
+    float Bvh::degradation() const
+    {
+        if (root == Null || built_cost <= 0.0) return 1.f;
+
+        const double root_area = area(nodes[root].box);
+        return (root_area > 0.0 ? static_cast<float>(internal_area / root_area / built_cost) : 1.f);
+    }
+
+    std::size_t Bvh::query(const Frustum& frustum, std::vector<uint32_t>& items, std::vector<std::pair<uint32_t, uint32_t>>& stack) const
+    {
+        using namespace mn;
+
+        if (root == Null) return 0;
+
+        constexpr uint32_t AllPlanes = (1U << 6) - 1;
+        const float near_limit = frustum.near_distance + 1.f;
+
+        std::size_t visited = 0;
+        stack.clear();
+        stack.push_back({ root, AllPlanes });
+        while (!stack.empty())
+        {
+            auto [ node, planes ] = stack.back();
+            stack.pop_back();
+
+            const auto& n = nodes[node];
+
+            // Under a node entirely inside, everything is taken without testing
+            if (!planes)
+            {
+                if (n.leaf())
+                    items.push_back(n.item);
+                else
+                {
+                    stack.push_back({ n.right, 0 });
+                    stack.push_back({ n.left, 0 });
+                }
+                continue;
+            }
+
+            visited++;
+
+            // Leaves get the exact per box test, so a walk finds the same items culling every box would
+            if (n.leaf())
+            {
+                if (!CullingStage::cull(frustum, n.box)) items.push_back(n.item);
+                continue;
+            }
+
+            // The per mesh test never culls what the camera is in or right next to, so neither
+            // can a node holding it
+            const auto closest = Math::min(Math::max(frustum.position, n.box.min), n.box.max);
+            const bool near = Math::length(closest - frustum.position) <= near_limit;
+
+            bool outside = false;
+            for (uint32_t p = 0; p < 6 && !near; p++)
+            {
+                if (!(planes & (1U << p))) continue;
+
+                const auto& plane = frustum.planes[p];
+                const Math::Vec3f positive{
+                    Math::x(plane) >= 0 ? Math::x(n.box.max) : Math::x(n.box.min),
+                    Math::y(plane) >= 0 ? Math::y(n.box.max) : Math::y(n.box.min),
+                    Math::z(plane) >= 0 ? Math::z(n.box.max) : Math::z(n.box.min)
+                };
+                const Math::Vec3f negative{
+                    Math::x(plane) >= 0 ? Math::x(n.box.min) : Math::x(n.box.max),
+                    Math::y(plane) >= 0 ? Math::y(n.box.min) : Math::y(n.box.max),
+                    Math::z(plane) >= 0 ? Math::z(n.box.min) : Math::z(n.box.max)
+                };
+
+                if (Math::inner(Math::xyz(plane), positive) + Math::w(plane) < 0)
+                {
+                    outside = true;
+                    break;
+                }
+
+                // Entirely on the inner side, the children don't need this plane
+                if (Math::inner(Math::xyz(plane), negative) + Math::w(plane) >= 0)
+                    planes &= ~(1U << p);
+            }
+
+            if (outside) continue;
+
+            stack.push_back({ n.right, planes });
+            stack.push_back({ n.left, planes });
+        }
+
+        return visited;
+    }
+
+    std::size_t Bvh::allocated() const
+    {
+        return nodes.capacity() * sizeof(Node) + leaves.capacity() * sizeof(uint32_t) + centroids.capacity() * sizeof(mn::Math::Vec3f);
+    }
+}
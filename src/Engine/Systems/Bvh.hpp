@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Culling.hpp"
+
+#include <midnight/midnight.hpp>
+
+#include <utility>
+#include <vector>
+
+namespace Engine::System
+{
+    // Bounding volume hierarchy over world space boxes, one leaf per item. Leaves can be inserted,
+    // removed and moved one at a time (moving refits the ancestors), or the whole tree can be rebuilt
+    // top down with the binned surface area heuristic. Leaf handles stay valid across rebuilds
+    struct Bvh
+    {
+        static constexpr uint32_t Null = ~0U;
+
+        // Returns the leaf handle for item
+        uint32_t insert(uint32_t item, const BoundingBox& box);
+        void remove(uint32_t leaf);
+
+        // The leaf's box changed, the ancestors grow or shrink to fit again. False if it was the same box
+        bool update(uint32_t leaf, const BoundingBox& box);
+
+        void rebuild();
+        void clear();
+
+        // Expected traversal cost of the tree against what it was right after the last rebuild.
+        // Insertions and refits only ever make it climb
+        float degradation() const;
+
+        // Appends every item CullingStage::cull keeps. A subtree entirely inside is taken whole
+        // without testing further down, one entirely outside is dropped in one test.
+        // stack is scratch space. Returns the number of nodes visited
+        std::size_t query(const Frustum& frustum, std::vector<uint32_t>& items, std::vector<std::pair<uint32_t, uint32_t>>& stack) const;
+
+        std::size_t size() const { return leaf_count; }
+        std::size_t allocated() const;
+
+    private:
+        struct Node
+        {
+            BoundingBox box;
+            uint32_t parent = Null;
+            // Leaves have no children and carry an item, free nodes chain through parent
+            uint32_t left = Null, right = Null;
+            uint32_t item = Null;
+
+            bool leaf() const { return left == Null; }
+        };
+
+        uint32_t allocate();
+        void release(uint32_t node);
+
+        // Recomputes boxes from node up to the root, stopping as soon as one doesn't change
+        void refit(uint32_t node);
+
+        // Builds a subtree over leaves[first, last) and returns its root
+        uint32_t build(std::size_t first, std::size_t last);
+
+        std::vector<Node> nodes;
+        uint32_t root = Null, free_list = Null;
+        std::size_t leaf_count = 0;
+
+        // Surface area summed over the internal nodes, and that sum over the root's area right after the last rebuild
+        double internal_area = 0.0, built_cost = 0.0;
+
+        // Scratch for rebuild()
+        std::vector<uint32_t> leaves;
+        std::vector<mn::Math::Vec3f> centroids;
+    };
+}
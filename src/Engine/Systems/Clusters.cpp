@@ -0,0 +1,263 @@
+#include "Clusters.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace Engine::System
+{
+    namespace
+    {
+        float component(const mn::Math::Vec4f& v, int k)
+        {
+            using namespace mn;
+            return (k == 0 ? Math::x(v) : k == 1 ? Math::y(v) : k == 2 ? Math::z(v) : Math::w(v));
+        }
+
+        constexpr std::size_t Batch = 8;
+    }
+
+    void LightClusters::setup(const mn::Math::Mat4<float>& view_projection, mn::Math::Vec2f near_far, Dimensions dimensions)
+    {
+        using namespace mn;
+
+        dims       = Dimensions{ std::max(dimensions.x, 1U), std::max(dimensions.y, 1U), std::max(dimensions.z, 1U) };
+        near_plane = Math::x(near_far);
+        far_plane  = Math::y(near_far);
+        count      = 0;
+        light_x.clear(); light_y.clear(); light_z.clear(); light_range.clear();
+
+        // Each clip component is a plane over world space, read off the images of the basis vectors
+        const std::array<Math::Vec4f, 4> columns = {
+            view_projection * Math::Vec4f{ 1.f, 0.f, 0.f, 0.f },
+            view_projection * Math::Vec4f{ 0.f, 1.f, 0.f, 0.f },
+            view_projection * Math::Vec4f{ 0.f, 0.f, 1.f, 0.f },
+            view_projection * Math::Vec4f{ 0.f, 0.f, 0.f, 1.f }
+        };
+        const auto row = [&](int k)
+        {
+            return Math::Vec4f{ component(columns[0], k), component(columns[1], k), component(columns[2], k), component(columns[3], k) };
+        };
+
+        const auto clip_x = row(0), clip_y = row(1);
+        depth       = row(3);
+        depth_scale = Math::length(Math::xyz(depth));
+
+        // ndc x = t is the plane clip x - t clip w = 0, through the camera
+        plane_x.clear(); plane_y.clear(); plane_z.clear(); plane_d.clear();
+        const auto boundary = [&](const Math::Vec4f& clip, uint32_t i, uint32_t n)
+        {
+            const float t = -1.f + 2.f * static_cast<float>(i) / static_cast<float>(n);
+            const auto plane  = clip - depth * t;
+            const float scale = 1.f / std::max(Math::length(Math::xyz(plane)), 1e-12f);
+            plane_x.push_back(Math::x(plane) * scale);
+            plane_y.push_back(Math::y(plane) * scale);
+            plane_z.push_back(Math::z(plane) * scale);
+            plane_d.push_back(Math::w(plane) * scale);
+        };
+
+        for (uint32_t i = 0; i <= dims.x; i++) boundary(clip_x, i, dims.x);
+        for (uint32_t i = 0; i <= dims.y; i++) boundary(clip_y, i, dims.y);
+
+        slice_scale = static_cast<float>(dims.z) / std::log(far_plane / near_plane);
+        slice_bias  = -std::log(near_plane) * slice_scale;
+
+        slices.clear();
+        for (uint32_t k = 1; k < dims.z; k++)
+            slices.push_back(std::exp((static_cast<float>(k) - slice_bias) / slice_scale));
+    }
+
+    void LightClusters::push(const mn::Math::Vec3f& position, float range)
+    {
+        using namespace mn;
+
+        light_x.push_back(Math::x(position));
+        light_y.push_back(Math::y(position));
+        light_z.push_back(Math::z(position));
+        light_range.push_back(range);
+        count++;
+    }
+
+    void LightClusters::binScalar(std::size_t first, std::size_t last)
+    {
+        using namespace mn;
+
+        for (std::size_t l = first; l < last; l++)
+        {
+            const float cx = light_x[l], cy = light_y[l], cz = light_z[l], r = light_range[l];
+            const auto distance = [&](std::size_t p) { return plane_x[p] * cx + plane_y[p] * cy + plane_z[p] * cz + plane_d[p]; };
+
+            bool visible = true;
+
+            // The sphere is entirely past a boundary when it's more than r away from it, so counting
+            // the boundaries it's entirely past gives the first tile, and the ones it reaches the last
+            const auto axis = [&](std::size_t base, uint32_t n, uint16_t& lo, uint16_t& hi)
+            {
+                visible &= (distance(base) >= -r) && (distance(base + n) < r);
+                lo = hi = 0;
+                for (std::size_t i = 1; i < n; i++)
+                {
+                    const float s = distance(base + i);
+                    lo += (s >= r);
+                    hi += (s >= -r);
+                }
+            };
+
+            Box box;
+            axis(0, dims.x, box.x0, box.x1);
+            axis(dims.x + 1, dims.y, box.y0, box.y1);
+
+            const float w  = Math::x(depth) * cx + Math::y(depth) * cy + Math::z(depth) * cz + Math::w(depth);
+            const float wr = r * depth_scale;
+            visible &= (w + wr >= near_plane) && (w - wr <= far_plane);
+
+            box.z0 = box.z1 = 0;
+            for (const float start : slices)
+            {
+                box.z0 += (w - wr >= start);
+                box.z1 += (w + wr >= start);
+            }
+
+            if (!visible) box.x0 = 1, box.x1 = 0;
+            boxes[l] = box;
+        }
+    }
+
+    void LightClusters::run([[maybe_unused]] bool scalar)
+    {
+        using namespace mn;
+
+        boxes.resize(count);
+        std::size_t l = 0;
+
+#if defined(__AVX2__)
+        if (!scalar)
+        {
+            // Pad out to a whole batch, the padding lanes are never read back
+            const std::size_t padded = (count + Batch - 1) / Batch * Batch;
+            for (auto* v : { &light_x, &light_y, &light_z, &light_range })
+                v->resize(padded, 0.f);
+
+            const auto near_limit = _mm256_set1_ps(near_plane);
+            const auto far_limit  = _mm256_set1_ps(far_plane);
+            const auto dx = _mm256_set1_ps(Math::x(depth)), dy = _mm256_set1_ps(Math::y(depth));
+            const auto dz = _mm256_set1_ps(Math::z(depth)), dw = _mm256_set1_ps(Math::w(depth));
+
+            for (; l + Batch <= count; l += Batch)
+            {
+                const auto cx = _mm256_loadu_ps(&light_x[l]), cy = _mm256_loadu_ps(&light_y[l]), cz = _mm256_loadu_ps(&light_z[l]);
+                const auto r  = _mm256_loadu_ps(&light_range[l]);
+                const auto neg_r = _mm256_sub_ps(_mm256_setzero_ps(), r);
+
+                const auto distance = [&](std::size_t p)
+                {
+                    return _mm256_add_ps(
+                        _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane_x[p]), cx), _mm256_mul_ps(_mm256_set1_ps(plane_y[p]), cy)),
+                        _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane_z[p]), cz), _mm256_set1_ps(plane_d[p])));
+                };
+
+                // Compare masks are -1 per lane, subtracting them counts
+                auto visible = _mm256_castps_si256(_mm256_cmp_ps(r, r, _CMP_EQ_OQ));
+                const auto axis = [&](std::size_t base, uint32_t n, __m256i& lo, __m256i& hi)
+                {
+                    visible = _mm256_and_si256(visible, _mm256_castps_si256(_mm256_and_ps(
+                        _mm256_cmp_ps(distance(base), neg_r, _CMP_GE_OQ), _mm256_cmp_ps(distance(base + n), r, _CMP_LT_OQ))));
+
+                    lo = hi = _mm256_setzero_si256();
+                    for (std::size_t i = 1; i < n; i++)
+                    {
+                        const auto s = distance(base + i);
+                        lo = _mm256_sub_epi32(lo, _mm256_castps_si256(_mm256_cmp_ps(s, r, _CMP_GE_OQ)));
+                        hi = _mm256_sub_epi32(hi, _mm256_castps_si256(_mm256_cmp_ps(s, neg_r, _CMP_GE_OQ)));
+                    }
+                };
+
+                __m256i x0, x1, y0, y1;
+                axis(0, dims.x, x0, x1);
+                axis(dims.x + 1, dims.y, y0, y1);
+
+                const auto w  = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, cx), _mm256_mul_ps(dy, cy)), _mm256_add_ps(_mm256_mul_ps(dz, cz), dw));
+                const auto wr = _mm256_mul_ps(r, _mm256_set1_ps(depth_scale));
+                const auto w_min = _mm256_sub_ps(w, wr), w_max = _mm256_add_ps(w, wr);
+                visible = _mm256_and_si256(visible, _mm256_castps_si256(_mm256_and_ps(
+                    _mm256_cmp_ps(w_max, near_limit, _CMP_GE_OQ), _mm256_cmp_ps(w_min, far_limit, _CMP_LE_OQ))));
+
+                auto z0 = _mm256_setzero_si256(), z1 = _mm256_setzero_si256();
+                for (const float start : slices)
+                {
+                    const auto s = _mm256_set1_ps(start);
+                    z0 = _mm256_sub_epi32(z0, _mm256_castps_si256(_mm256_cmp_ps(w_min, s, _CMP_GE_OQ)));
+                    z1 = _mm256_sub_epi32(z1, _mm256_castps_si256(_mm256_cmp_ps(w_max, s, _CMP_GE_OQ)));
+                }
+
+                alignas(32) int32_t lanes[7][Batch];
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[0]), x0);
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[1]), x1);
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[2]), y0);
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[3]), y1);
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[4]), z0);
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[5]), z1);
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[6]), visible);
+
+                for (std::size_t i = 0; i < Batch; i++)
+                {
+                    boxes[l + i] = Box{
+                        static_cast<uint16_t>(lanes[6][i] ? lanes[0][i] : 1), static_cast<uint16_t>(lanes[6][i] ? lanes[1][i] : 0),
+                        static_cast<uint16_t>(lanes[2][i]), static_cast<uint16_t>(lanes[3][i]),
+                        static_cast<uint16_t>(lanes[4][i]), static_cast<uint16_t>(lanes[5][i])
+                    };
+                }
+            }
+        }
+#endif
+
+        // Scalar fallback, and the tail
+        binScalar(l, count);
+
+        // Count what lands in each cluster, lay the lists out back to back, then fill them in light order
+        const std::size_t row = dims.x, layer = std::size_t(dims.x) * dims.y;
+        cells.assign(layer * dims.z, GLSL::Cluster{ 0, 0 });
+        visible_count = 0;
+
+        const auto each_cluster = [&](const Box& box, auto&& f)
+        {
+            for (uint32_t z = box.z0; z <= box.z1; z++)
+                for (uint32_t y = box.y0; y <= box.y1; y++)
+                    for (uint32_t x = box.x0; x <= box.x1; x++)
+                        f(cells[x + y * row + z * layer]);
+        };
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (boxes[i].x0 > boxes[i].x1) continue;
+            visible_count++;
+            each_cluster(boxes[i], [](GLSL::Cluster& cell) { cell.count++; });
+        }
+
+        uint32_t offset = 0;
+        for (auto& cell : cells)
+        {
+            cell.offset = offset;
+            offset += cell.count;
+            cell.count = 0;
+        }
+
+        light_indices.resize(offset);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (boxes[i].x0 > boxes[i].x1) continue;
+            each_cluster(boxes[i], [&](GLSL::Cluster& cell) { light_indices[cell.offset + cell.count++] = static_cast<uint32_t>(i); });
+        }
+    }
+
+    std::size_t LightClusters::allocated() const
+    {
+        return (plane_x.capacity() + plane_y.capacity() + plane_z.capacity() + plane_d.capacity() + slices.capacity()) * sizeof(float) +
+               (light_x.capacity() + light_y.capacity() + light_z.capacity() + light_range.capacity()) * sizeof(float) +
+               boxes.capacity() * sizeof(Box) + cells.capacity() * sizeof(GLSL::Cluster) + light_indices.capacity() * sizeof(uint32_t);
+    }
+}
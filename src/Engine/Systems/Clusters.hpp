@@ -0,0 +1,82 @@
+#pragma once
+
+#include "ShaderTypes.hpp"
+
+#include <midnight/midnight.hpp>
+
+#include <span>
+#include <vector>
+
+namespace Engine::System
+{
+    // Clustered light culling on the CPU. A camera's view frustum is cut into x * y screen tiles and
+    // z depth slices (spaced exponentially between the near and far planes), and every light's sphere
+    // is binned into the clusters it reaches. The lights are tested 8 (AVX2) or 1 at a time against the
+    // tile and slice boundary planes, which gives each one a box of clusters, and the boxes are then
+    // turned into a list of light indices per cluster. The lighting pass finds a fragment's cluster
+    // from its clip position the same way
+    struct LightClusters
+    {
+        struct Dimensions
+        {
+            uint32_t x = 16, y = 9, z = 24;
+        };
+
+        // Starts a frame for a camera, the lights pushed after this are binned against its frustum
+        void setup(const mn::Math::Mat4<float>& view_projection, mn::Math::Vec2f near_far, Dimensions dimensions);
+
+        // World space sphere the light reaches, the light's index is the order it was pushed in
+        void push(const mn::Math::Vec3f& position, float range);
+
+        // scalar skips the AVX2 batches, so they can be checked against the plain loop
+        void run(bool scalar = false);
+
+        Dimensions dimensions() const { return dims; }
+
+        // A fragment with clip position c lands in slice floor(log(c.w) * slice_scale + slice_bias)
+        float sliceScale() const { return slice_scale; }
+        float sliceBias()  const { return slice_bias; }
+
+        // Indexed x + y * dimensions().x + z * dimensions().x * dimensions().y, the offsets are into indices()
+        std::span<const GLSL::Cluster> clusters() const { return cells; }
+        std::span<const uint32_t> indices() const { return light_indices; }
+
+        // Lights that reach at least one cluster
+        std::size_t visible() const { return visible_count; }
+
+        std::size_t allocated() const;
+
+    private:
+        // Clusters [x0, x1] x [y0, y1] x [z0, z1] a light reaches, x0 > x1 when it misses the frustum
+        struct Box
+        {
+            uint16_t x0, x1, y0, y1, z0, z1;
+        };
+
+        void binScalar(std::size_t first, std::size_t last);
+
+        Dimensions dims;
+        float near_plane = 0.f, far_plane = 0.f;
+        float slice_scale = 0.f, slice_bias = 0.f;
+
+        // Tile boundary planes, normalized and facing +x/+y on screen. dims.x + 1 of them across from
+        // the -x edge, then dims.y + 1 from the -y edge
+        std::vector<float> plane_x, plane_y, plane_z, plane_d;
+
+        // Clip w as a function of world position, and how far it moves per unit of distance
+        mn::Math::Vec4f depth;
+        float depth_scale = 1.f;
+
+        // Depth where each slice after the first starts
+        std::vector<float> slices;
+
+        // The lights, SoA and padded to a whole batch
+        std::size_t count = 0;
+        std::vector<float> light_x, light_y, light_z, light_range;
+
+        std::vector<Box> boxes;
+        std::vector<GLSL::Cluster> cells;
+        std::vector<uint32_t> light_indices;
+        std::size_t visible_count = 0;
+    };
+}
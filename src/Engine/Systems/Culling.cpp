@@ -0,0 +1,348 @@
+#include "Culling.hpp"
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace Engine::System
+{
+    Frustum Frustum::fromCamera(const Component::Transform& transform, const Component::Camera& camera)
+    {
+        using namespace mn;
+
+        Frustum frustum;
+
+        const auto viewMatrix = camera.createViewMatrix(transform);
+        const auto invView = Math::inv(viewMatrix);
+        const auto camera_pos_4 = invView * Math::Vec4f{ 0.f, 0.f, 0.f, 1.f };
+
+        const auto position = Math::xyz(camera_pos_4);
+        frustum.position = position;
+
+        // Get camera forward, right, and up vectors based on the rotation
+        const auto right_4 = (invView * Math::Vec4f{ 1.f, 0.f, 0.f, 1.f} - camera_pos_4);
+        const auto right = Math::normalized( Math::xyz(right_4) );
+
+        const auto up_4 = (invView * Math::Vec4f{ 0.f, 1.f, 0.f, 1.f} - camera_pos_4);
+        const auto up = Math::normalized( Math::xyz(up_4) );
+
+        const auto forward_4 = (invView * Math::Vec4f{ 0.f, 0.f, -1.f, 1.f} - camera_pos_4);
+        const auto forward = Math::normalized( Math::xyz(forward_4) );
+
+        // Calculate near and far distances
+        float nearDist = Math::x(camera.near_far);
+        float farDist  = Math::y(camera.near_far);
+        frustum.near_distance = nearDist;
+
+        // Calculate half dimensions of near and far planes based on FOV and aspect ratio
+        float aspectRatio = (float)Math::x(camera.surface->getColorAttachments()[0].size) / (float)Math::y(camera.surface->getColorAttachments()[0].size);
+        float nearHeight = 2.0f * tanf(camera.FOV.asRadians() / 2.0f) * nearDist;
+        float nearWidth = nearHeight * aspectRatio;
+
+        // Calculate centers of near and far planes
+        Math::Vec3f nearCenter = position + forward * nearDist;
+        Math::Vec3f farCenter  = position + forward * farDist;
+
+        auto& frustumPlanes = frustum.planes;
+
+        // Near plane
+        frustumPlanes[0] = Math::Vec4f({ Math::x(forward), Math::y(forward), Math::z(forward), -Math::inner(forward, nearCenter) });
+
+        // Far plane
+        frustumPlanes[1] = Math::Vec4f({ -Math::x(forward), -Math::y(forward), -Math::z(forward), Math::inner(forward, farCenter) });
+
+        // Left plane
+        Math::Vec3f leftEdgeNear = (nearCenter - (right * (nearWidth / 2.0f))) - position;
+        Math::Vec3f leftNormal = Math::normalized(Math::outer(up, leftEdgeNear));
+        frustumPlanes[2] = Math::Vec4f({ Math::x(leftNormal), Math::y(leftNormal), Math::z(leftNormal), -Math::inner(leftNormal, nearCenter) });
+
+        // Right plane
+        Math::Vec3f rightEdgeNear = (nearCenter + (right * (nearWidth / 2.0f))) - position;
+        Math::Vec3f rightNormal = Math::normalized(Math::outer(rightEdgeNear, up));
+        frustumPlanes[3] = Math::Vec4f({ Math::x(rightNormal), Math::y(rightNormal), Math::z(rightNormal), -Math::inner(rightNormal, nearCenter) });
+
+        // Top plane
+        Math::Vec3f topEdgeNear = (nearCenter + (up * (nearHeight / 2.0f))) - position;
+        Math::Vec3f topNormal = Math::normalized(Math::outer(right, topEdgeNear));
+        frustumPlanes[4] = Math::Vec4f({ Math::x(topNormal), Math::y(topNormal), Math::z(topNormal), -Math::inner(topNormal, nearCenter) });
+
+        // Bottom plane
+        Math::Vec3f bottomEdgeNear = (nearCenter - (up * (nearHeight / 2.0f))) - position;
+        Math::Vec3f bottomNormal = Math::normalized(Math::outer(bottomEdgeNear, right));
+        frustumPlanes[5] = Math::Vec4f({ Math::x(bottomNormal), Math::y(bottomNormal), Math::z(bottomNormal), -Math::inner(bottomNormal, nearCenter) });
+
+        return frustum;
+    }
+
+    void CullingStage::clear()
+    {
+        count = 0;
+        min_x.clear(); min_y.clear(); min_z.clear();
+        max_x.clear(); max_y.clear(); max_z.clear();
+        force.clear();
+    }
+
+    std::size_t CullingStage::push(const BoundingBox& aabb, const mn::Math::Mat4<float>& model, bool always_visible)
+    {
+        using namespace mn;
+
+        const auto world = worldBounds(aabb, model);
+        min_x.push_back(Math::x(world.min)); min_y.push_back(Math::y(world.min)); min_z.push_back(Math::z(world.min));
+        max_x.push_back(Math::x(world.max)); max_y.push_back(Math::y(world.max)); max_z.push_back(Math::z(world.max));
+
+        if (force.size() < count / 64 + 1) force.push_back(0);
+        if (always_visible) force[count / 64] |= (uint64_t(1) << (count % 64));
+
+        return count++;
+    }
+
+    const std::vector<uint64_t>& CullingStage::run(const Frustum& frustum)
+    {
+        using namespace mn;
+
+        const std::size_t words = (count + 63) / 64;
+        mask.assign(words, 0);
+        force.resize(words, 0);
+
+        // Pad the SoA arrays out to a full batch so the vector loops never need a tail
+        const std::size_t padded = (count + 15) / 16 * 16;
+        for (auto* v : { &min_x, &min_y, &min_z, &max_x, &max_y, &max_z })
+            v->resize(padded, 0.f);
+
+        std::size_t i = 0;
+
+#if defined(__AVX512F__)
+        {
+            const auto px = _mm512_set1_ps(Math::x(frustum.position));
+            const auto py = _mm512_set1_ps(Math::y(frustum.position));
+            const auto pz = _mm512_set1_ps(Math::z(frustum.position));
+            const auto near_limit = _mm512_set1_ps(frustum.near_distance + 1.f);
+
+            for (; i + 16 <= padded; i += 16)
+            {
+                const auto mnx = _mm512_loadu_ps(&min_x[i]), mny = _mm512_loadu_ps(&min_y[i]), mnz = _mm512_loadu_ps(&min_z[i]);
+                const auto mxx = _mm512_loadu_ps(&max_x[i]), mxy = _mm512_loadu_ps(&max_y[i]), mxz = _mm512_loadu_ps(&max_z[i]);
+
+                // Camera is inside the bounding box
+                __mmask16 decided =
+                    _mm512_cmp_ps_mask(px, mnx, _CMP_GE_OQ) & _mm512_cmp_ps_mask(px, mxx, _CMP_LE_OQ) &
+                    _mm512_cmp_ps_mask(py, mny, _CMP_GE_OQ) & _mm512_cmp_ps_mask(py, mxy, _CMP_LE_OQ) &
+                    _mm512_cmp_ps_mask(pz, mnz, _CMP_GE_OQ) & _mm512_cmp_ps_mask(pz, mxz, _CMP_LE_OQ);
+
+                // Either corner is very close to the near plane
+                const auto dist = [&](__m512 x, __m512 y, __m512 z)
+                {
+                    const auto dx = _mm512_sub_ps(px, x), dy = _mm512_sub_ps(py, y), dz = _mm512_sub_ps(pz, z);
+                    return _mm512_sqrt_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy)), _mm512_mul_ps(dz, dz)));
+                };
+                decided |= _mm512_cmp_ps_mask(dist(mnx, mny, mnz), near_limit, _CMP_LE_OQ);
+                decided |= _mm512_cmp_ps_mask(dist(mxx, mxy, mxz), near_limit, _CMP_LE_OQ);
+
+                __mmask16 culled = 0;
+                for (const auto& plane : frustum.planes)
+                {
+                    const auto nx = _mm512_set1_ps(Math::x(plane)), ny = _mm512_set1_ps(Math::y(plane)), nz = _mm512_set1_ps(Math::z(plane));
+                    const auto d  = _mm512_set1_ps(Math::w(plane));
+
+                    const bool sx = Math::x(plane) >= 0, sy = Math::y(plane) >= 0, sz = Math::z(plane) >= 0;
+                    const auto positive = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(
+                        _mm512_mul_ps(nx, sx ? mxx : mnx), _mm512_mul_ps(ny, sy ? mxy : mny)), _mm512_mul_ps(nz, sz ? mxz : mnz)), d);
+
+                    // Entirely inside one plane says nothing about the others, only outside any one of them decides
+                    const __mmask16 outside = _mm512_cmp_ps_mask(positive, _mm512_setzero_ps(), _CMP_LT_OQ) & ~decided;
+                    culled  |= outside;
+                    decided |= outside;
+                }
+
+                mask[i / 64] |= uint64_t(uint16_t(~culled)) << (i % 64);
+            }
+        }
+#elif defined(__AVX2__)
+        {
+            const auto px = _mm256_set1_ps(Math::x(frustum.position));
+            const auto py = _mm256_set1_ps(Math::y(frustum.position));
+            const auto pz = _mm256_set1_ps(Math::z(frustum.position));
+            const auto near_limit = _mm256_set1_ps(frustum.near_distance + 1.f);
+            const auto zero = _mm256_setzero_ps();
+
+            for (; i + 8 <= padded; i += 8)
+            {
+                const auto mnx = _mm256_loadu_ps(&min_x[i]), mny = _mm256_loadu_ps(&min_y[i]), mnz = _mm256_loadu_ps(&min_z[i]);
+                const auto mxx = _mm256_loadu_ps(&max_x[i]), mxy = _mm256_loadu_ps(&max_y[i]), mxz = _mm256_loadu_ps(&max_z[i]);
+
+                // Camera is inside the bounding box
+                auto decided = _mm256_and_ps(
+                    _mm256_and_ps(
+                        _mm256_and_ps(_mm256_cmp_ps(px, mnx, _CMP_GE_OQ), _mm256_cmp_ps(px, mxx, _CMP_LE_OQ)),
+                        _mm256_and_ps(_mm256_cmp_ps(py, mny, _CMP_GE_OQ), _mm256_cmp_ps(py, mxy, _CMP_LE_OQ))),
+                    _mm256_and_ps(_mm256_cmp_ps(pz, mnz, _CMP_GE_OQ), _mm256_cmp_ps(pz, mxz, _CMP_LE_OQ)));
+
+                // Either corner is very close to the near plane
+                const auto dist = [&](__m256 x, __m256 y, __m256 z)
+                {
+                    const auto dx = _mm256_sub_ps(px, x), dy = _mm256_sub_ps(py, y), dz = _mm256_sub_ps(pz, z);
+                    return _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz)));
+                };
+                decided = _mm256_or_ps(decided, _mm256_cmp_ps(dist(mnx, mny, mnz), near_limit, _CMP_LE_OQ));
+                decided = _mm256_or_ps(decided, _mm256_cmp_ps(dist(mxx, mxy, mxz), near_limit, _CMP_LE_OQ));
+
+                auto culled = zero;
+                for (const auto& plane : frustum.planes)
+                {
+                    const auto nx = _mm256_set1_ps(Math::x(plane)), ny = _mm256_set1_ps(Math::y(plane)), nz = _mm256_set1_ps(Math::z(plane));
+                    const auto d  = _mm256_set1_ps(Math::w(plane));
+
+                    const bool sx = Math::x(plane) >= 0, sy = Math::y(plane) >= 0, sz = Math::z(plane) >= 0;
+                    const auto positive = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+                        _mm256_mul_ps(nx, sx ? mxx : mnx), _mm256_mul_ps(ny, sy ? mxy : mny)), _mm256_mul_ps(nz, sz ? mxz : mnz)), d);
+
+                    // Entirely inside one plane says nothing about the others, only outside any one of them decides
+                    const auto outside = _mm256_andnot_ps(decided, _mm256_cmp_ps(positive, zero, _CMP_LT_OQ));
+                    culled  = _mm256_or_ps(culled, outside);
+                    decided = _mm256_or_ps(decided, outside);
+                }
+
+                mask[i / 64] |= uint64_t(~_mm256_movemask_ps(culled) & 0xFF) << (i % 64);
+            }
+        }
+#endif
+
+        // Scalar fallback
+        for (; i < count; i++)
+        {
+            const BoundingBox world{
+                .min = { min_x[i], min_y[i], min_z[i] },
+                .max = { max_x[i], max_y[i], max_z[i] }
+            };
+            if (!cull(frustum, world))
+                mask[i / 64] |= (uint64_t(1) << (i % 64));
+        }
+
+        // Drop the padding lanes and force in everything that should not be culled
+        for (std::size_t w = 0; w < words; w++)
+            mask[w] |= force[w];
+        if (count % 64)
+            mask[words - 1] &= (uint64_t(1) << (count % 64)) - 1;
+
+        return mask;
+    }
+
+    BoundingBox CullingStage::worldBounds(const BoundingBox& aabb, const mn::Math::Mat4<float>& model)
+    {
+        using namespace mn;
+
+        // Compute the 8 corners of the AABB in local space
+        std::array<Math::Vec4f, 8> corners = {
+            Math::Vec4f({ Math::x(aabb.min), Math::y(aabb.min), Math::z(aabb.min), 1.f }),
+            Math::Vec4f({ Math::x(aabb.max), Math::y(aabb.min), Math::z(aabb.min), 1.f }),
+            Math::Vec4f({ Math::x(aabb.min), Math::y(aabb.max), Math::z(aabb.min), 1.f }),
+            Math::Vec4f({ Math::x(aabb.max), Math::y(aabb.max), Math::z(aabb.min), 1.f }),
+            Math::Vec4f({ Math::x(aabb.min), Math::y(aabb.min), Math::z(aabb.max), 1.f }),
+            Math::Vec4f({ Math::x(aabb.max), Math::y(aabb.min), Math::z(aabb.max), 1.f }),
+            Math::Vec4f({ Math::x(aabb.min), Math::y(aabb.max), Math::z(aabb.max), 1.f }),
+            Math::Vec4f({ Math::x(aabb.max), Math::y(aabb.max), Math::z(aabb.max), 1.f }),
+        };
+
+        // Transform corners by model matrix to get world-space AABB
+        for (auto& corner : corners)
+            corner = model * corner;
+
+        BoundingBox world;
+        world.min = world.max = Math::xyz(corners[0]);
+        for (const auto& corner : corners)
+        {
+            world.min = Math::min(world.min, Math::xyz(corner));
+            world.max = Math::max(world.max, Math::xyz(corner));
+        }
+
+        return world;
+    }
+
+    bool CullingStage::cull(const Frustum& frustum, const BoundingBox& worldAABB)
+    {
+        using namespace mn;
+
+        const auto& position = frustum.position;
+
+        if (Math::x(position) >= Math::x(worldAABB.min) && Math::x(position) <= Math::x(worldAABB.max) &&
+            Math::y(position) >= Math::y(worldAABB.min) && Math::y(position) <= Math::y(worldAABB.max) &&
+            Math::z(position) >= Math::z(worldAABB.min) && Math::z(position) <= Math::z(worldAABB.max))
+        {
+            // Camera is inside the bounding box, don't cull the object
+            return false;
+        }
+
+        if (Math::length(position - worldAABB.min) <= frustum.near_distance + 1.f ||
+            Math::length(position - worldAABB.max) <= frustum.near_distance + 1.f)
+        {
+            return false; // Don't cull if the object is very close to the near plane
+        }
+
+        for (const auto& plane : frustum.planes)
+        {
+            auto normal = Math::xyz(plane);
+            float d = Math::w(plane);
+
+            // Calculate positive vertex for plane-AABB test
+            Math::Vec3f positive = worldAABB.min;
+
+            if (Math::x(normal) >= 0) Math::x(positive) = Math::x(worldAABB.max);
+            if (Math::y(normal) >= 0) Math::y(positive) = Math::y(worldAABB.max);
+            if (Math::z(normal) >= 0) Math::z(positive) = Math::z(worldAABB.max);
+
+            // Check if the positive vertex is outside the plane. Being inside one plane
+            // settles nothing, the others still get their say
+            if (Math::inner(normal, positive) + d < 0)
+                return true;
+        }
+
+        // If no planes exclude the AABB, it is inside the frustum
+        return false;
+    }
+    bool CullingStage::cullSphere(const Frustum& frustum, const mn::Math::Vec3f& center, float radius)
+    {
+        using namespace mn;
+
+        // The planes are normalized, so this is the signed distance to each of them
+        for (const auto& plane : frustum.planes)
+            if (Math::inner(Math::xyz(plane), center) + Math::w(plane) < -radius)
+                return true;
+
+        return false;
+    }
+
+    MeshletStats CullingStage::cullMeshlets(std::span<const Model::BoundedMesh::Meshlet> meshlets, const mn::Math::Mat4<float>& model, 
+        float scale, bool cone_culling, const Frustum& frustum, std::span<uint8_t> visible)
+    {
+        using namespace mn;
+
+        // The cones were built in object space, so bring the camera there rather than every cone out.
+        // Backfacing is preserved by any transform that doesn't mirror, non uniform scale included
+        const auto camera = Math::xyz(Math::inv(model) * Math::Vec4f{ Math::x(frustum.position), Math::y(frustum.position), Math::z(frustum.position), 1.f });
+
+        MeshletStats stats{ .tested = meshlets.size() };
+        for (std::size_t m = 0; m < meshlets.size(); m++)
+        {
+            const auto& meshlet = meshlets[m];
+
+            const auto center = model * Math::Vec4f{ Math::x(meshlet.center), Math::y(meshlet.center), Math::z(meshlet.center), 1.f };
+            bool culled = cullSphere(frustum, Math::xyz(center), meshlet.radius * scale);
+
+            // The camera is behind every triangle once it is inside the cone mirrored behind the apex
+            if (!culled && cone_culling)
+            {
+                const auto to_apex = meshlet.cone_apex - camera;
+                culled = Math::inner(to_apex, meshlet.cone_axis) >= meshlet.cone_cutoff * Math::length(to_apex);
+            }
+
+            visible[m] = !culled;
+            if (culled)
+            {
+                stats.culled++;
+                stats.triangles += meshlet.count / 3;
+            }
+        }
+
+        return stats;
+    }
+}
\ No newline at end of file
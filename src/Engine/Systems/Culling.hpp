@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../Component.hpp"
+
+#include <midnight/midnight.hpp>
+
+#include <array>
+#include <span>
+#include <vector>
+
+namespace Engine::System
+{
+    // The six planes of a camera frustum (normals point inward), built once per camera per frame
+    struct Frustum
+    {
+        mn::Math::Vec3f position;
+        float near_distance;
+        std::array<mn::Math::Vec4f, 6> planes;
+
+        static Frustum fromCamera(const Component::Transform& transform, const Component::Camera& camera);
+    };
+
+    // What meshlet culling did, over one instance or a whole frame
+    struct MeshletStats
+    {
+        std::size_t tested = 0, culled = 0, triangles = 0;
+    };
+
+    // Batched frustum culling over world-space bounds stored as SoA arrays.
+    // Boxes are pushed during the model query, then tested 16 (AVX-512), 8 (AVX2)
+    // or 1 (scalar) at a time against a frustum, producing a visibility bitmask
+    struct CullingStage
+    {
+        void clear();
+
+        // Transforms the aabb by the model matrix and appends the world bounds, returns the box index
+        std::size_t push(const BoundingBox& aabb, const mn::Math::Mat4<float>& model, bool always_visible = false);
+
+        // Bit i of the result is set when box i is visible
+        const std::vector<uint64_t>& run(const Frustum& frustum);
+
+        bool visible(std::size_t index) const { return (mask[index / 64] >> (index % 64)) & 1; }
+        std::size_t size() const { return count; }
+
+        static BoundingBox worldBounds(const BoundingBox& aabb, const mn::Math::Mat4<float>& model);
+
+        // Scalar test of a single world-space box, returns true if the box should be culled
+        static bool cull(const Frustum& frustum, const BoundingBox& world_aabb);
+
+        // Same for a world-space sphere
+        static bool cullSphere(const Frustum& frustum, const mn::Math::Vec3f& center, float radius);
+
+        // Tests the meshlets of one instance drawn with model, visible[i] is set for the ones that survive.
+        // scale is the model's largest axis scale, and the cone test is only valid when it doesn't mirror
+        static MeshletStats cullMeshlets(std::span<const Model::BoundedMesh::Meshlet> meshlets, const mn::Math::Mat4<float>& model, 
+            float scale, bool cone_culling, const Frustum& frustum, std::span<uint8_t> visible);
+
+    private:
+        std::size_t count = 0;
+        std::vector<float> min_x, min_y, min_z, max_x, max_y, max_z;
+        std::vector<uint64_t> force, mask;
+    };
+}
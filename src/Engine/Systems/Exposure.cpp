@@ -0,0 +1,103 @@
+#include "Exposure.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+
+namespace Engine::System
+{
+    float meterColor(const mn::Math::Vec3f& color, const AutoExposure& settings)
+    {
+        using namespace mn;
+
+        const float luminance = 0.2125f * Math::x(color) + 0.7154f * Math::y(color) + 0.0721f * Math::z(color);
+        if (luminance < 0.005f) return -1.f;
+
+        return std::clamp((std::log2(luminance) - settings.min_log_luminance) / settings.log_luminance_range, 0.f, 1.f);
+    }
+
+    uint32_t histogramBin(float metered)
+    {
+        constexpr auto Bins = GLSL::HistogramBins;
+        if (metered < 0.f) return 0;
+        return 1 + std::min(static_cast<uint32_t>(metered * static_cast<float>(Bins - 1)), Bins - 2);
+    }
+
+    void meterHistogram(std::span<const float> rgba, uint32_t width, uint32_t height, std::span<HistogramTexel> histogram, const AutoExposure& settings)
+    {
+        constexpr auto Bins = GLSL::HistogramBins, Rows = GLSL::HistogramRows, Size = GLSL::MeterSize;
+        assert(histogram.size() == Bins * Rows && rgba.size() >= std::size_t(width) * height * 4);
+
+        // The texel the pass fetches for metered texel i of Size across
+        const auto texel = [](uint32_t i, uint32_t size)
+        {
+            const float at = (static_cast<float>(i) + 0.5f) / static_cast<float>(Size) * static_cast<float>(size);
+            return std::min(static_cast<uint32_t>(at), size - 1);
+        };
+
+        // The pass has each bin go over its rows on its own, here every texel is metered once and
+        // goes straight to its bin. Summed in the same order either way
+        std::fill(histogram.begin(), histogram.end(), HistogramTexel{});
+        for (uint32_t y = 0; y < Size; y++)
+        {
+            auto* row = &histogram[(y / (Size / Rows)) * Bins];
+            for (uint32_t x = 0; x < Size; x++)
+            {
+                const auto* pixel = &rgba[(std::size_t(texel(y, height)) * width + texel(x, width)) * 4];
+                const float metered = meterColor(mn::Math::Vec3f{ pixel[0], pixel[1], pixel[2] }, settings);
+
+                auto& bin = row[histogramBin(metered)];
+                bin.count += 1.f;
+                bin.mean  += std::max(metered, 0.f);
+            }
+        }
+
+        for (auto& bin : histogram)
+            bin.mean = (bin.count > 0.f ? bin.mean / bin.count : 0.f);
+    }
+
+    ExposureState adaptExposure(std::span<const HistogramTexel> histogram, const ExposureState& previous, float delta_time, const AutoExposure& settings)
+    {
+        constexpr auto Bins = GLSL::HistogramBins, Rows = GLSL::HistogramRows;
+        assert(histogram.size() == Bins * Rows);
+
+        // Each bin's count and summed log luminance, bin 0 (too dark) left out
+        std::array<float, Bins> counts{}, sums{};
+        float lit = 0.f;
+        for (uint32_t bin = 1; bin < Bins; bin++)
+        {
+            for (uint32_t row = 0; row < Rows; row++)
+            {
+                const auto& texel = histogram[bin + row * Bins];
+                counts[bin] += texel.count;
+                sums[bin]   += texel.count * texel.mean;
+            }
+            lit += counts[bin];
+        }
+
+        // The part of each bin between the two percentiles counts, at the bin's own mean
+        const float low = lit * settings.low_percentile, high = lit * settings.high_percentile;
+        float below = 0.f, weighted = 0.f, kept = 0.f;
+        for (uint32_t bin = 1; bin < Bins; bin++)
+        {
+            const float take = std::max(std::min(below + counts[bin], high) - std::max(below, low), 0.f);
+            if (take > 0.f)
+            {
+                weighted += sums[bin] / counts[bin] * take;
+                kept += take;
+            }
+            below += counts[bin];
+        }
+
+        // Nothing lit, hold on to whatever we had
+        if (kept <= 0.f) return previous;
+
+        const float target = std::exp2(weighted / kept * settings.log_luminance_range + settings.min_log_luminance);
+        const float luminance = (previous.luminance > 0.f ?
+            previous.luminance + (target - previous.luminance) * (1.f - std::exp(-delta_time * settings.adaptation_rate)) :
+            target);
+
+        return ExposureState{ .luminance = luminance, .exposure = settings.key / luminance };
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "ShaderTypes.hpp"
+
+#include <midnight/midnight.hpp>
+
+#include <span>
+
+namespace Engine::System
+{
+    // How auto exposure reads the scene. Log2 luminance from min_log_luminance to
+    // min_log_luminance + log_luminance_range is sorted into the histogram (anything outside is
+    // clamped to it). The darkest low_percentile and the brightest 1 - high_percentile of what's lit
+    // are left out of the average, so a bright sky or a black corner doesn't swing it. The average
+    // moves towards each frame's at adaptation_rate per second, and is mapped to key before the
+    // camera's own exposure is applied. Off, only the camera's is used
+    struct AutoExposure
+    {
+        bool enabled = true;
+        float min_log_luminance   = -8.f;
+        float log_luminance_range = 12.f;
+        float low_percentile      = 0.1f;
+        float high_percentile     = 0.95f;
+        float adaptation_rate     = 1.1f;
+        float key                 = 0.5f;
+    };
+
+    // CPU reference of the auto exposure passes, doing what histogram.fragment.glsl and
+    // adaptation.fragment.glsl do in the same order. The GPU keeps the histogram and the state in
+    // half floats, so the two only agree to about three digits
+
+    // One texel of the histogram image: how many metered texels fell in the bin, and the mean of
+    // their log luminance (0 to 1 over the metered range)
+    struct HistogramTexel
+    {
+        float count = 0.f, mean = 0.f;
+    };
+
+    // What an adaptation image holds, the luminance is 0 until a frame with anything lit in it
+    struct ExposureState
+    {
+        float luminance = 0.f, exposure = 1.f;
+    };
+
+    // Where a linear RGB colour's log luminance falls in the metered range, negative when it's
+    // too dark to count at all
+    float meterColor(const mn::Math::Vec3f& color, const AutoExposure& settings);
+
+    // The histogram bin a meterColor() result goes in, 0 for too dark
+    uint32_t histogramBin(float metered);
+
+    // Meters a tightly packed width x height RGBA image into the HistogramBins x HistogramRows
+    // histogram, indexed bin + row * HistogramBins
+    void meterHistogram(std::span<const float> rgba, uint32_t width, uint32_t height, std::span<HistogramTexel> histogram, const AutoExposure& settings);
+
+    // Reduces the histogram into the state delta_time seconds after the previous one
+    ExposureState adaptExposure(std::span<const HistogramTexel> histogram, const ExposureState& previous, float delta_time, const AutoExposure& settings);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace Engine::System
+{
+    // Marks a mesh that hasn't been given a LOD level yet
+    constexpr uint8_t NoLevel = 0xFF;
+
+    // What a mesh's level is picked from, for one camera this frame
+    struct LodQuery
+    {
+        // Pixels on screen one unit of object space error covers at the mesh's distance
+        float pixels_per_error;
+        // Most pixels of error allowed, and the band around it (as a fraction) that the level drawn
+        // last frame is kept inside
+        float threshold, hysteresis;
+        // Forced level, -1 to pick one
+        int override_level = -1;
+    };
+
+    // Picks the coarsest level whose error stays under the threshold (past the last LOD is the full
+    // mesh), but sticks with previous, what this camera drew last frame, while it's inside the
+    // hysteresis band. previous is updated to the pick, null leaves the band out. A level that isn't
+    // built yet gets requested, and the next finer one that is stands in for it. LOD is anything with
+    // size(), level(l) giving its count and error, and request(l), like Model::BoundedMesh::LOD
+    template<typename LOD>
+    uint32_t selectLevel(LOD* lods, const LodQuery& query, uint8_t* previous)
+    {
+        const auto full = static_cast<uint32_t>(lods ? lods->size() : 0);
+        const auto usable = [&](uint32_t level) { return (level >= full || lods->level(level).count > 0); };
+
+        if (query.override_level >= 0)
+        {
+            auto level = std::min(static_cast<uint32_t>(query.override_level), full);
+            if (!usable(level)) lods->request(level);
+            while (!usable(level)) level++;
+            return level;
+        }
+
+        const auto pixels = [&](uint32_t level) { return (level < full ? lods->level(level).error * query.pixels_per_error : 0.f); };
+
+        uint32_t level = full;
+        for (uint32_t l = 0; l < full; l++)
+            if (pixels(l) <= query.threshold)
+            {
+                if (!usable(l))
+                {
+                    lods->request(l);
+                    continue;
+                }
+                level = l;
+                break;
+            }
+
+        if (!previous) return level;
+
+        if (*previous != NoLevel && *previous != level && *previous <= full && usable(*previous))
+        {
+            const bool fine_enough   = pixels(*previous) <= query.threshold * (1.f + query.hysteresis);
+            const bool coarser_is_ok = (level < *previous) && pixels(level) <= query.threshold * (1.f - query.hysteresis);
+            if (fine_enough && !coarser_is_ok) level = *previous;
+        }
+
+        *previous = static_cast<uint8_t>(level);
+        return level;
+    }
+}
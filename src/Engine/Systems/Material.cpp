@@ -4,29 +4,98 @@
 
 namespace Engine::System
 {
-    DiffuseMaterial::DiffuseMaterial(ResourceManager& res) :
+    MaterialTable::MaterialTable() :
         layout(std::make_shared<mn::Graphics::Descriptor::Layout>([]()
         {
             using namespace mn::Graphics;
             DescriptorLayoutBuilder layout_builder;
-            layout_builder.addBinding(Descriptor::Layout::Binding{ .type = Descriptor::Layout::Binding::Sampler, .count = 2 });
-            layout_builder.addVariableBinding(Descriptor::Layout::Binding::Image, 4);
+            layout_builder.addBinding(Descriptor::Layout::Binding{ .type = Descriptor::Layout::Binding::Sampler, .count = 1 });
+            layout_builder.addVariableBinding(Descriptor::Layout::Binding::Image, MaxTextures);
             return layout_builder.build();
         }()))
-    {   
+    {
         using namespace mn::Graphics;
 
         auto descriptor_pool = Descriptor::Pool::make();
-        default_desc = descriptor_pool->allocateDescriptor(layout);
+        set = descriptor_pool->allocateDescriptor(layout);
+
+        auto& device = Backend::Instance::get()->getDevice();
+        set->update<Descriptor::Layout::Binding::Sampler>(0, { device->getSampler(Backend::Sampler::Linear) });
+
+        rows.resize(MaxMaterials);
+        addMaterial(GLSL::MaterialData{ .albedo = GLSL::NoTexture });
+    }
+
+    std::shared_ptr<MaterialTable> MaterialTable::get(ResourceManager& res)
+    {
+        if (!res.exists<MaterialTable>("materials"))
+            return res.create<MaterialTable>("materials").value;
+        return res.get<MaterialTable>("materials").value;
+    }
+
+    uint32_t MaterialTable::textureIndex(const std::shared_ptr<mn::Graphics::Texture>& texture)
+    {
+        if (auto it = texture_indices.find(texture.get()); it != texture_indices.end())
+            return it->second;
+
+        MIDNIGHT_ASSERT(textures.size() < MaxTextures, "Out of bindless texture slots");
+        textures.push_back(texture);
+
+        const auto index = static_cast<uint32_t>(textures.size() - 1);
+        texture_indices[texture.get()] = index;
+        return index;
+    }
+
+    uint32_t MaterialTable::addMaterial(const GLSL::MaterialData& material, TextureCache::Handle albedo)
+    {
+        std::lock_guard lock(mutex);
+        MIDNIGHT_ASSERT(material_count < MaxMaterials, "Out of material rows");
+
+        rows[material_count] = material;
+        if (albedo) pending.push_back(PendingRow{ .row = material_count, .albedo = std::move(albedo) });
+        return material_count++;
+    }
+
+    void MaterialTable::update()
+    {
+        std::lock_guard lock(mutex);
+        std::erase_if(pending, [this](const PendingRow& p)
+        {
+            if (p.albedo->failed()) return true;
+            if (!p.albedo->resident()) return false;
+            rows[p.row].albedo = textureIndex(p.albedo->texture());
+            return true;
+        });
+
+        // One write for everything added this frame. midnight's update() always starts at the
+        // first element, so the slots before are written again with what they already hold, but
+        // only on frames that added any
+        if (textures.size() > written)
+        {
+            using namespace mn::Graphics;
+
+            std::vector<std::shared_ptr<Image>> images;
+            images.reserve(textures.size());
+            for (const auto& t : textures) images.push_back(t->get_image());
+            set->update<Descriptor::Layout::Binding::Image>(1, images);
+            written = textures.size();
+        }
+    }
+
+    DiffuseMaterial::DiffuseMaterial(ResourceManager& res) :
+        table(MaterialTable::get(res)),
+        textures(TextureCache::get(res))
+    {   
+        using namespace mn::Graphics;
 
         std::shared_ptr<Shader> vertex, fragment;
         if (!res.exists<Shader>("vertex.glsl"))
-            vertex = res.create<Shader>("vertex.glsl", RES_DIR "/shaders/vertex.glsl", ShaderType::Vertex).value;
+            vertex = res.create<Shader>("vertex.glsl", SHADER_DIR "/vertex.glsl", ShaderType::Vertex).value;
         else
             vertex = res.get<Shader>("vertex.glsl").value;
 
         if (!res.exists<Shader>("diffuse.fragment.glsl"))
-            fragment = res.create<Shader>("diffuse.fragment.glsl", RES_DIR "/shaders/diffuse.fragment.glsl", ShaderType::Fragment).value;
+            fragment = res.create<Shader>("diffuse.fragment.glsl", SHADER_DIR "/diffuse.fragment.glsl", ShaderType::Fragment).value;
         else
             fragment = res.get<Shader>("diffuse.fragment.glsl").value;
 
@@ -35,59 +104,35 @@ namespace Engine::System
             PipelineBuilder::fromLua(RES_DIR, "/shaders/main.lua")
                     .addShader(vertex)
                     .addShader(fragment)
-                    .addDescriptorLayout(layout)
+                    .addDescriptorLayout(table->layout)
                     .setPushConstantObject<Renderer::PushConstant>()
                     .build());
     }
 
     Material::Instance
-    DiffuseMaterial::resolveMaterial(const std::filesystem::path& base_path, aiMaterial* material) const 
+    DiffuseMaterial::resolveMaterial(const std::filesystem::path& base_path, const Description& material) const 
     {
-        using namespace mn::Graphics;
-
-        const auto count = material->GetTextureCount(aiTextureType_DIFFUSE);
-        if (!count) return { .set = default_desc, .pipeline = pipeline };
+        if (material.diffuse.empty()) return Instance{ .pipeline = pipeline, .table = table };
         
-        for (uint32_t i = 0; i < count; i++)
-        {
-            aiString path;
-            MIDNIGHT_ASSERT(material->GetTexture(aiTextureType_DIFFUSE, i, &path) == aiReturn_SUCCESS, "Error loading material");
-            const auto complete_path = base_path.parent_path().string() + "/" + std::string(path.C_Str());
-            
-            // Load the texture
-            textures.push_back(
-                std::make_shared<Texture>(complete_path)
-            );
-
-            break;
-        }
-
-        // Create the descriptor set
-        auto descriptor_pool = Descriptor::Pool::make();
-        auto descriptor = descriptor_pool->allocateDescriptor(layout);
-
-        // Update the descriptor set
-        //   Assign the sampler to 0
-        //   Assign textures.back() to 1
-        auto& device = Backend::Instance::get()->getDevice();
-        descriptor->update<Descriptor::Layout::Binding::Sampler>(0, { device->getSampler(Backend::Sampler::Linear)  });
-        descriptor->update<Descriptor::Layout::Binding::Image>  (1, { textures.back()->get_image()                  });
+        // Shared with every other material using the same image, loads in the background
+        const auto albedo = textures->load(base_path.parent_path() / material.diffuse);
 
-        return Instance{ .set = descriptor, .pipeline = pipeline };
+        return Instance{ .pipeline = pipeline, .table = table, .index = table->addMaterial(GLSL::MaterialData{ .albedo = GLSL::NoTexture }, albedo) };
     }
 
-    ColorMaterial::ColorMaterial(ResourceManager& res)
+    ColorMaterial::ColorMaterial(ResourceManager& res) :
+        table(MaterialTable::get(res))
     {
         using namespace mn::Graphics;
 
         std::shared_ptr<Shader> vertex, fragment;
         if (!res.exists<Shader>("vertex.glsl"))
-            vertex = res.create<Shader>("vertex.glsl", RES_DIR "/shaders/vertex.glsl", ShaderType::Vertex).value;
+            vertex = res.create<Shader>("vertex.glsl", SHADER_DIR "/vertex.glsl", ShaderType::Vertex).value;
         else
             vertex = res.get<Shader>("vertex.glsl").value;
 
         if (!res.exists<Shader>("color.fragment.glsl"))
-            fragment = res.create<Shader>("color.fragment.glsl", RES_DIR "/shaders/color.fragment.glsl", ShaderType::Fragment).value;
+            fragment = res.create<Shader>("color.fragment.glsl", SHADER_DIR "/color.fragment.glsl", ShaderType::Fragment).value;
         else
             fragment = res.get<Shader>("color.fragment.glsl").value;
 
@@ -96,29 +141,32 @@ namespace Engine::System
             mn::Graphics::PipelineBuilder::fromLua(RES_DIR, "/shaders/main.lua")
                     .addShader(vertex)
                     .addShader(fragment)
+                    // Doesn't sample anything, but sharing the layout keeps the table bound across pipeline switches
+                    .addDescriptorLayout(table->layout)
                     .setPushConstantObject<Renderer::PushConstant>()
                     .setBackfaceCull(false)
                     .build());
     }
 
     Material::Instance
-    ColorMaterial::resolveMaterial(const std::filesystem::path& base_path, aiMaterial* material) const
+    ColorMaterial::resolveMaterial(const std::filesystem::path& base_path, const Description& material) const
     {
-        return Instance{ .set = nullptr, .pipeline = pipeline };
+        return Instance{ .pipeline = pipeline, .table = table };
     }
 
-    LineMaterial::LineMaterial(ResourceManager& res)
+    LineMaterial::LineMaterial(ResourceManager& res) :
+        table(MaterialTable::get(res))
     {
         using namespace mn::Graphics;
 
         std::shared_ptr<Shader> vertex, fragment;
         if (!res.exists<Shader>("vertex.glsl"))
-            vertex = res.create<Shader>("vertex.glsl", RES_DIR "/shaders/vertex.glsl", ShaderType::Vertex).value;
+            vertex = res.create<Shader>("vertex.glsl", SHADER_DIR "/vertex.glsl", ShaderType::Vertex).value;
         else
             vertex = res.get<Shader>("vertex.glsl").value;
 
         if (!res.exists<Shader>("color.fragment.glsl"))
-            fragment = res.create<Shader>("color.fragment.glsl", RES_DIR "/shaders/color.fragment.glsl", ShaderType::Fragment).value;
+            fragment = res.create<Shader>("color.fragment.glsl", SHADER_DIR "/color.fragment.glsl", ShaderType::Fragment).value;
         else
             fragment = res.get<Shader>("color.fragment.glsl").value;
 
@@ -127,6 +175,7 @@ namespace Engine::System
             mn::Graphics::PipelineBuilder::fromLua(RES_DIR, "/shaders/main.lua")
                     .addShader(vertex)
                     .addShader(fragment)
+                    .addDescriptorLayout(table->layout)
                     .setPushConstantObject<Renderer::PushConstant>()
                     .setBackfaceCull(false)
                     .setTopology(Topology::Lines)
@@ -134,8 +183,8 @@ namespace Engine::System
     }
 
     Material::Instance
-    LineMaterial::resolveMaterial(const std::filesystem::path& base_path, aiMaterial* material) const 
+    LineMaterial::resolveMaterial(const std::filesystem::path& base_path, const Description& material) const 
     {
-        return Instance{ .set = nullptr, .pipeline = pipeline };
+        return Instance{ .pipeline = pipeline, .table = table };
     }
 }
\ No newline at end of file
@@ -1,59 +1,118 @@
 #pragma once
 
 #include <midnight/midnight.hpp>
-#include <assimp/scene.h>
 
 #include "../ResourceManager.hpp"
+#include "../TextureCache.hpp"
+#include "ShaderTypes.hpp"
 
+#include <filesystem>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 
 namespace Engine::System
 {
+    // Shared by every material pipeline: one descriptor set holding a sampler and a bindless
+    // array of all the loaded textures, and a GPU buffer with one row per resolved material.
+    // Lives in the resource manager under "materials"
+    struct MaterialTable
+    {
+        static constexpr uint32_t MaxTextures  = 4096;
+        static constexpr uint32_t MaxMaterials = 4096;
+
+        MaterialTable();
+
+        // Returns the row the shaders index. The albedo only gets filled in by update() once
+        // the texture is resident, until then (or for good if it failed) the row draws untextured
+        uint32_t addMaterial(const GLSL::MaterialData& material, TextureCache::Handle albedo = nullptr);
+
+        // Called between frames on the main thread, so the descriptor set is only written there
+        void update();
+
+        static std::shared_ptr<MaterialTable> get(ResourceManager& res);
+
+        std::shared_ptr<mn::Graphics::Descriptor::Layout> layout;
+        std::shared_ptr<mn::Graphics::Descriptor> set;
+
+        // Fixed size so the address pushed to the shaders never changes
+        mn::Graphics::TypeBuffer<GLSL::MaterialData> rows;
+
+        // Row 0, untextured
+        static constexpr uint32_t Default = 0;
+
+    private:
+        // Slot in the bindless array, the texture is only added the first time. The descriptor is
+        // written by update() once the frame's new textures are all in
+        uint32_t textureIndex(const std::shared_ptr<mn::Graphics::Texture>& texture);
+
+        struct PendingRow
+        {
+            uint32_t row;
+            TextureCache::Handle albedo;
+        };
+
+        std::mutex mutex;
+        std::vector<std::shared_ptr<mn::Graphics::Texture>> textures;
+        std::unordered_map<const mn::Graphics::Texture*, uint32_t> texture_indices;
+        std::vector<PendingRow> pending;
+        std::size_t written = 0;
+        uint32_t material_count = 0;
+    };
+
     // Should be loaded in the resource manager
     struct Material
     {
         struct Instance
         {
             std::shared_ptr<mn::Graphics::Pipeline> pipeline;
-            std::shared_ptr<mn::Graphics::Descriptor> set;
+            std::shared_ptr<MaterialTable> table;
+            uint32_t index = MaterialTable::Default;
+        };
+
+        // What a model file says about a mesh's material, paths are relative to the model file.
+        // Pulled out of the aiMaterial on import and stored as is in baked files
+        struct Description
+        {
+            std::string diffuse;
         };
 
         virtual Instance 
-        resolveMaterial(const std::filesystem::path& base_path, aiMaterial* material) const = 0;
+        resolveMaterial(const std::filesystem::path& base_path, const Description& material) const = 0;
     };
 
     struct DiffuseMaterial : Material
     {
         std::shared_ptr<mn::Graphics::Pipeline> pipeline;
-
-        std::shared_ptr<mn::Graphics::Descriptor::Layout> layout;
-        std::shared_ptr<mn::Graphics::Descriptor> default_desc;
+        std::shared_ptr<MaterialTable> table;
+        std::shared_ptr<TextureCache> textures;
 
         DiffuseMaterial(ResourceManager& res);
 
         Instance
-        resolveMaterial(const std::filesystem::path& base_path, aiMaterial* material) const override;
-
-        mutable std::vector<std::shared_ptr<mn::Graphics::Texture>> textures;
+        resolveMaterial(const std::filesystem::path& base_path, const Description& material) const override;
     };
 
     struct ColorMaterial : Material
     {
         std::shared_ptr<mn::Graphics::Pipeline> pipeline;
+        std::shared_ptr<MaterialTable> table;
 
         ColorMaterial(ResourceManager& res);
 
         Instance
-        resolveMaterial(const std::filesystem::path& base_path, aiMaterial* material) const override;
+        resolveMaterial(const std::filesystem::path& base_path, const Description& material) const override;
     };
 
     struct LineMaterial : Material
     {
         std::shared_ptr<mn::Graphics::Pipeline> pipeline;
+        std::shared_ptr<MaterialTable> table;
 
         LineMaterial(ResourceManager& res);
 
         Instance
-        resolveMaterial(const std::filesystem::path& base_path, aiMaterial* material) const override;
+        resolveMaterial(const std::filesystem::path& base_path, const Description& material) const override;
     };
 }
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include "Occlusion.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace Engine::System
+{
+    namespace
+    {
+        // A x + B y + C, positive on the inner side of the edge from a to b
+        struct Edge
+        {
+            float a, b, c;
+
+            static Edge between(const mn::Math::Vec4f& from, const mn::Math::Vec4f& to)
+            {
+                using namespace mn;
+
+                const float a = Math::y(from) - Math::y(to);
+                const float b = Math::x(to) - Math::x(from);
+                return Edge{ a, b, -(a * Math::x(from) + b * Math::y(from)) };
+            }
+        };
+    }
+
+    void OcclusionBuffer::resize(uint32_t width, uint32_t height)
+    {
+        width  = (width  + TileSize - 1) / TileSize * TileSize;
+        height = (height + TileSize - 1) / TileSize * TileSize;
+        _grew = false;
+        if (width == _width && height == _height) return;
+
+        _width  = width;
+        _height = height;
+        if (depth.capacity() < std::size_t(width) * height) _grew = true;
+        depth.resize(std::size_t(width) * height);
+        tiles.resize(std::size_t(width / TileSize) * (height / TileSize));
+    }
+
+    void OcclusionBuffer::clear(const mn::Math::Mat4<float>& view_projection, float near_plane)
+    {
+        this->view_projection = view_projection;
+        this->near_plane = near_plane;
+        triangle_count = 0;
+        std::fill(depth.begin(), depth.end(), 0.f);
+        std::fill(tiles.begin(), tiles.end(), 0.f);
+    }
+
+    void OcclusionBuffer::rasterize(std::span<const mn::Math::Vec3f> positions, std::span<const uint32_t> indices, const mn::Math::Mat4<float>& model)
+    {
+        using namespace mn;
+
+        if (!_width || !_height) return;
+
+        // Every vertex goes to the screen once, the triangles share them
+        const auto transform = model * view_projection;
+        if (projected.capacity() < positions.size()) _grew = true;
+        projected.resize(positions.size());
+        for (std::size_t i = 0; i < positions.size(); i++)
+        {
+            const auto clip = transform * Math::Vec4f{ Math::x(positions[i]), Math::y(positions[i]), Math::z(positions[i]), 1.f };
+            const float w = Math::w(clip);
+            if (w < near_plane)
+            {
+                projected[i] = { 0.f, 0.f, 0.f, 1.f };
+                continue;
+            }
+
+            const float inv_w = 1.f / w;
+            projected[i] = {
+                (Math::x(clip) * inv_w * 0.5f + 0.5f) * _width,
+                (Math::y(clip) * inv_w * 0.5f + 0.5f) * _height,
+                inv_w,
+                0.f
+            };
+        }
+
+        for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            const auto& a = projected[indices[i]];
+            const auto& b = projected[indices[i + 1]];
+            const auto& c = projected[indices[i + 2]];
+            if (Math::w(a) > 0.f || Math::w(b) > 0.f || Math::w(c) > 0.f) continue;
+
+            rasterizeTriangle(a, b, c);
+        }
+    }
+
+    void OcclusionBuffer::rasterizeTriangle(const mn::Math::Vec4f& a, const mn::Math::Vec4f& b_in, const mn::Math::Vec4f& c_in)
+    {
+        using namespace mn;
+
+        // Both windings are drawn, a wall seen from behind hides things just as well
+        float area = (Math::x(b_in) - Math::x(a)) * (Math::y(c_in) - Math::y(a)) - (Math::x(c_in) - Math::x(a)) * (Math::y(b_in) - Math::y(a));
+        if (area == 0.f || !std::isfinite(area)) return;
+
+        const auto& b = (area > 0.f ? b_in : c_in);
+        const auto& c = (area > 0.f ? c_in : b_in);
+        area = std::abs(area);
+
+        // Pixels whose centers fall inside the triangle's bounds
+        const auto first = [](float lo) { return static_cast<int>(std::ceil(lo - 0.5f)); };
+        const auto last  = [](float hi) { return static_cast<int>(std::floor(hi - 0.5f)); };
+        const int x0 = std::max(first(std::min({ Math::x(a), Math::x(b), Math::x(c) })), 0);
+        const int x1 = std::min(last(std::max({ Math::x(a), Math::x(b), Math::x(c) })), static_cast<int>(_width) - 1);
+        const int y0 = std::max(first(std::min({ Math::y(a), Math::y(b), Math::y(c) })), 0);
+        const int y1 = std::min(last(std::max({ Math::y(a), Math::y(b), Math::y(c) })), static_cast<int>(_height) - 1);
+        if (x0 > x1 || y0 > y1) return;
+
+        triangle_count++;
+
+        // Each edge is the barycentric weight of the opposite corner, times the area, so the
+        // inverse depth is a plane over the screen too
+        const auto e0 = Edge::between(b, c), e1 = Edge::between(c, a), e2 = Edge::between(a, b);
+        const Edge z{
+            (e0.a * Math::z(a) + e1.a * Math::z(b) + e2.a * Math::z(c)) / area,
+            (e0.b * Math::z(a) + e1.b * Math::z(b) + e2.b * Math::z(c)) / area,
+            (e0.c * Math::z(a) + e1.c * Math::z(b) + e2.c * Math::z(c)) / area
+        };
+
+        // Rows start on a multiple of 8, the buffer width is one too
+        const int start = x0 & ~7;
+
+#if defined(__AVX2__)
+        const auto zero  = _mm256_setzero_ps();
+        const auto lanes = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+        const auto plane = [](const Edge& e, __m256 px, float py)
+        {
+            return _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(e.a), px), _mm256_set1_ps(e.b * py + e.c));
+        };
+
+        for (int y = y0; y <= y1; y++)
+        {
+            const float py = y + 0.5f;
+            float* row = &depth[std::size_t(y) * _width];
+            for (int x = start; x <= x1; x += 8)
+            {
+                const auto px = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), lanes);
+                const auto inside = _mm256_and_ps(
+                    _mm256_and_ps(_mm256_cmp_ps(plane(e0, px, py), zero, _CMP_GE_OQ), _mm256_cmp_ps(plane(e1, px, py), zero, _CMP_GE_OQ)),
+                    _mm256_cmp_ps(plane(e2, px, py), zero, _CMP_GE_OQ));
+                if (_mm256_testz_ps(inside, inside)) continue;
+
+                const auto stored = _mm256_loadu_ps(row + x);
+                const auto nearer = _mm256_max_ps(stored, plane(z, px, py));
+                _mm256_storeu_ps(row + x, _mm256_blendv_ps(stored, nearer, inside));
+            }
+        }
+#else
+        for (int y = y0; y <= y1; y++)
+        {
+            const float py = y + 0.5f;
+            float* row = &depth[std::size_t(y) * _width];
+            for (int x = start; x <= x1; x++)
+            {
+                const float px = x + 0.5f;
+                if (e0.a * px + e0.b * py + e0.c < 0.f ||
+                    e1.a * px + e1.b * py + e1.c < 0.f ||
+                    e2.a * px + e2.b * py + e2.c < 0.f) continue;
+
+                row[x] = std::max(row[x], z.a * px + z.b * py + z.c);
+            }
+        }
+#endif
+    }
+
+    void OcclusionBuffer::finish()
+    {
+        const uint32_t tiles_x = _width / TileSize;
+        for (uint32_t ty = 0; ty < _height / TileSize; ty++)
+            for (uint32_t tx = 0; tx < tiles_x; tx++)
+            {
+                float farthest = std::numeric_limits<float>::max();
+                for (uint32_t y = ty * TileSize; y < (ty + 1) * TileSize; y++)
+                {
+                    const float* row = &depth[std::size_t(y) * _width + tx * TileSize];
+                    farthest = std::min(farthest, *std::min_element(row, row + TileSize));
+                }
+                tiles[ty * tiles_x + tx] = farthest;
+            }
+    }
+
+    bool OcclusionBuffer::occluded(const BoundingBox& aabb, const mn::Math::Mat4<float>& model) const
+    {
+        using namespace mn;
+
+        if (!triangle_count) return false;
+
+        const auto transform = model * view_projection;
+
+        float min_x = std::numeric_limits<float>::max(), max_x = std::numeric_limits<float>::lowest();
+        float min_y = min_x, max_y = max_x;
+        float nearest = 0.f;
+        for (int corner = 0; corner < 8; corner++)
+        {
+            const Math::Vec4f position{
+                (corner & 1 ? Math::x(aabb.max) : Math::x(aabb.min)),
+                (corner & 2 ? Math::y(aabb.max) : Math::y(aabb.min)),
+                (corner & 4 ? Math::z(aabb.max) : Math::z(aabb.min)),
+                1.f
+            };
+            const auto clip = transform * position;
+
+            // Reaching past the near plane, it's right in front of the camera
+            if (Math::w(clip) < near_plane) return false;
+
+            const float inv_w = 1.f / Math::w(clip);
+            const float x = (Math::x(clip) * inv_w * 0.5f + 0.5f) * _width;
+            const float y = (Math::y(clip) * inv_w * 0.5f + 0.5f) * _height;
+            min_x = std::min(min_x, x); max_x = std::max(max_x, x);
+            min_y = std::min(min_y, y); max_y = std::max(max_y, y);
+            nearest = std::max(nearest, inv_w);
+        }
+
+        // A flat occluder's own box sits right at its depth, a hair of slack keeps rounding from hiding it
+        nearest *= 1.001f;
+
+        // Off screen is the frustum's call
+        if (max_x < 0.f || max_y < 0.f || min_x > _width || min_y > _height) return false;
+
+        const auto tile = [](float v, uint32_t size)
+        {
+            return static_cast<uint32_t>(std::clamp(v, 0.f, static_cast<float>(size - 1))) / TileSize;
+        };
+
+        const uint32_t tiles_x = _width / TileSize;
+        for (uint32_t ty = tile(min_y, _height); ty <= tile(max_y, _height); ty++)
+            for (uint32_t tx = tile(min_x, _width); tx <= tile(max_x, _width); tx++)
+                if (tiles[ty * tiles_x + tx] <= nearest) return false;
+
+        return true;
+    }
+}
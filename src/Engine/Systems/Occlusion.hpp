@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../Model.hpp"
+
+#include <midnight/midnight.hpp>
+
+#include <span>
+#include <vector>
+
+namespace Engine::System
+{
+    // Software occlusion culling in the spirit of masked occlusion culling, entirely on the CPU.
+    // Occluder triangles are rasterized 8 pixels at a time (AVX2, or scalar) into a small buffer
+    // that keeps the nearest inverse depth per pixel, and every TileSize x TileSize tile remembers the
+    // farthest value it holds. A box is occluded when every tile under its screen rectangle is
+    // covered by something nearer than the box's nearest corner
+    struct OcclusionBuffer
+    {
+        static constexpr uint32_t TileSize = 8;
+
+        // Both get rounded up to whole tiles
+        void resize(uint32_t width, uint32_t height);
+
+        // Empties the buffer for a new frame seen through view_projection
+        void clear(const mn::Math::Mat4<float>& view_projection, float near_plane);
+
+        // Object space triangles, placed by model. Triangles reaching behind the near plane are
+        // skipped, leaving them out only ever occludes less
+        void rasterize(std::span<const mn::Math::Vec3f> positions, std::span<const uint32_t> indices, const mn::Math::Mat4<float>& model);
+
+        // Builds the tiles, once every occluder is in
+        void finish();
+
+        // Whether the object space box, placed by model, is hidden behind the occluders
+        bool occluded(const BoundingBox& aabb, const mn::Math::Mat4<float>& model) const;
+
+        uint32_t width()  const { return _width; }
+        uint32_t height() const { return _height; }
+
+        // Triangles that made it into the buffer since clear()
+        std::size_t triangles() const { return triangle_count; }
+
+        // Set when resize() or rasterize() had to allocate since the last resize()
+        bool grew() const { return _grew; }
+
+    private:
+        void rasterizeTriangle(const mn::Math::Vec4f& a, const mn::Math::Vec4f& b, const mn::Math::Vec4f& c);
+
+        uint32_t _width = 0, _height = 0;
+        mn::Math::Mat4<float> view_projection;
+        float near_plane = 0.f;
+        std::size_t triangle_count = 0;
+        bool _grew = false;
+
+        // Inverse w, so bigger is nearer and 0 is nothing drawn
+        std::vector<float> depth, tiles;
+
+        // Screen x, y, inverse w of the occluder being drawn, and whether it sits behind the near plane
+        std::vector<mn::Math::Vec4f> projected;
+    };
+}
@@ -2,10 +2,19 @@
 
 #include "../../Util/DataRep.hpp"
 
+#include "LodSelection.hpp"
 #include "Material.hpp"
+#include "../InstancePacking.hpp"
+#include "../VertexPacking.hpp"
+#include "../../Util/RadixSort.hpp"
 
 #include <imgui.h>
-#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <span>
 
 namespace Engine::System
 {
@@ -42,19 +51,27 @@ namespace Engine::System
         else
             hdr_surface->getColorAttachments()[0].rebuild<Image::Color>(Image::R16G16B16A16_SFLOAT, size);
 
+        // Fixed size and outlive resizes, the exposure just carries on adapting
+        if (!histogram)
+        {
+            const auto image = [](mn::Math::Vec2u image_size)
+            {
+                return std::make_shared<Image>(
+                    ImageFactory()
+                        .addAttachment<Image::Color>(Image::R16G16B16A16_SFLOAT, image_size)
+                        .build()
+                );
+            };
+
+            histogram  = image({ GLSL::HistogramBins, GLSL::HistogramRows });
+            adaptation = { image({ 1, 1 }), image({ 1, 1 }) };
+        }
+
         this->size = size;
     }
 
     Renderer::Renderer(flecs::world _world) : 
         world{_world},
-        model_query(_world.query_builder<const Component::Model, const Component::Transform>()
-            .cached()
-            .order_by<Component::Model>(
-                [](flecs::entity_t e1, const Component::Model *d1, flecs::entity_t e2, const Component::Model *d2) {
-                    return (d1->model.value.get() > d2->model.value.get()) - (d1->model.value.get() < d2->model.value.get());
-                }
-            )
-            .build()),
         camera_query(_world.query_builder<const Component::Camera>()
             .cached()
             .build()),
@@ -84,7 +101,7 @@ namespace Engine::System
         {
             DescriptorLayoutBuilder layout_builder;
             layout_builder.addBinding(Descriptor::Layout::Binding{ .type = Descriptor::Layout::Binding::Sampler, .count = 2 });
-            layout_builder.addVariableBinding(Descriptor::Layout::Binding::Image, 4);
+            layout_builder.addVariableBinding(Descriptor::Layout::Binding::Image, GLSL::CameraImages * MaxCameras);
             return layout_builder.build();
         }());
 
@@ -101,7 +118,7 @@ namespace Engine::System
             [](mn::Graphics::PipelineBuilder builder)
             {
                 return builder
-                    .addShader(RES_DIR "/shaders/quad.fragment.glsl", mn::Graphics::ShaderType::Fragment)
+                    .addShader(SHADER_DIR "/quad.fragment.glsl", mn::Graphics::ShaderType::Fragment)
                     .addAttachmentFormat(mn::Graphics::Image::R16G16B16A16_SFLOAT)
                     .setPushConstantObject<GBufferPush>()
                     .build();
@@ -112,13 +129,168 @@ namespace Engine::System
             [](mn::Graphics::PipelineBuilder builder)
             {
                 return builder
-                    .addShader(RES_DIR "/shaders/hdr.fragment.glsl", mn::Graphics::ShaderType::Fragment)
+                    .addShader(SHADER_DIR "/hdr.fragment.glsl", mn::Graphics::ShaderType::Fragment)
                     .addAttachmentFormat(mn::Graphics::Image::B8G8R8A8_UNORM)
                     .setDepthFormat(mn::Graphics::Image::DF32_SU8)
                     .setPushConstantObject<HDRPush>()
                     .build();
             }(quad_builder)
         );
+
+        histogram_pipeline = std::make_shared<mn::Graphics::Pipeline>(
+            [](mn::Graphics::PipelineBuilder builder)
+            {
+                return builder
+                    .addShader(SHADER_DIR "/histogram.fragment.glsl", mn::Graphics::ShaderType::Fragment)
+                    .addAttachmentFormat(mn::Graphics::Image::R16G16B16A16_SFLOAT)
+                    .setPushConstantObject<ExposurePush>()
+                    .build();
+            }(quad_builder)
+        );
+
+        adaptation_pipeline = std::make_shared<mn::Graphics::Pipeline>(
+            [](mn::Graphics::PipelineBuilder builder)
+            {
+                return builder
+                    .addShader(SHADER_DIR "/adaptation.fragment.glsl", mn::Graphics::ShaderType::Fragment)
+                    .addAttachmentFormat(mn::Graphics::Image::R16G16B16A16_SFLOAT)
+                    .setPushConstantObject<ExposurePush>()
+                    .build();
+            }(quad_builder)
+        );
+
+        // Hand out instance slots as entities pick up a Model and Transform, and flag them
+        // for upload whenever either one is set or marked modified
+        observers.push_back(world.observer<const Component::Model, const Component::Transform>()
+            .event(flecs::OnAdd)
+            .event(flecs::OnSet)
+            .each([this](flecs::entity e, const Component::Model&, const Component::Transform&)
+            {
+                markDirty(e);
+            }));
+
+        observers.push_back(world.observer<const Component::Model, const Component::Transform>()
+            .event(flecs::OnRemove)
+            .each([this](flecs::entity e, const Component::Model&, const Component::Transform&)
+            {
+                releaseSlot(e);
+            }));
+
+        watchTag<Component::Hidden>();
+        watchTag<Component::DontCull>();
+        watchTag<Component::Static>();
+        watchTag<Component::Occluder>();
+    }
+
+    template<typename Tag>
+    void Renderer::watchTag()
+    {
+        // The tag is still there while OnRemove runs, the upload reads it once it's gone
+        observers.push_back(world.observer<const Component::Model, const Component::Transform>()
+            .template with<Tag>()
+            .event(flecs::OnAdd)
+            .event(flecs::OnRemove)
+            .each([this](flecs::entity e, const Component::Model&, const Component::Transform&)
+            {
+                if (entity_slots.contains(e.id())) markDirty(e);
+            }));
+    }
+
+    Renderer::~Renderer()
+    {
+        // The observers capture this, so they can't outlive us
+        for (auto& observer : observers)
+            observer.destruct();
+    }
+
+    void Renderer::markDirty(flecs::entity e)
+    {
+        auto [ it, inserted ] = entity_slots.try_emplace(e.id(), 0);
+        if (inserted)
+        {
+            if (free_slots.empty())
+            {
+                it->second = static_cast<uint32_t>(slot_entities.size());
+                slot_entities.push_back(0);
+                slot_dirty.push_back(0);
+                slots.emplace_back();
+            }
+            else
+            {
+                it->second = free_slots.back();
+                free_slots.pop_back();
+            }
+        }
+
+        const auto slot = it->second;
+        slot_entities[slot] = e.id();
+        if (!slot_dirty[slot])
+        {
+            slot_dirty[slot] = 1;
+            dirty_slots.push_back(slot);
+        }
+    }
+
+    void Renderer::releaseSlot(flecs::entity e)
+    {
+        const auto it = entity_slots.find(e.id());
+        if (it == entity_slots.end()) return;
+
+        // The slot may still be queued for upload, the upload skips slots nobody owns
+        unplace(it->second);
+        slots[it->second].resource.reset();
+        slot_entities[it->second] = 0;
+        free_slots.push_back(it->second);
+        entity_slots.erase(it);
+    }
+
+    void Renderer::unplace(uint32_t slot) const
+    {
+        auto& state = slots[slot];
+        switch (state.placement)
+        {
+        case Placement::Static:
+            static_bvh.remove(state.leaf);
+            static_dirty = true;
+            break;
+        case Placement::Dynamic:
+            dynamic_bvh.remove(state.leaf);
+            break;
+        case Placement::Unculled:
+            // The last one fills the hole
+            unculled_slots[state.leaf] = unculled_slots.back();
+            slots[unculled_slots[state.leaf]].leaf = state.leaf;
+            unculled_slots.pop_back();
+            break;
+        case Placement::None:
+            break;
+        }
+
+        state.placement = Placement::None;
+        state.leaf      = Bvh::Null;
+    }
+
+    void Renderer::place(uint32_t slot, Placement placement) const
+    {
+        auto& state = slots[slot];
+        switch (placement)
+        {
+        case Placement::Static:
+            state.leaf = static_bvh.insert(slot, state.bounds);
+            static_dirty = true;
+            break;
+        case Placement::Dynamic:
+            state.leaf = dynamic_bvh.insert(slot, state.bounds);
+            break;
+        case Placement::Unculled:
+            state.leaf = static_cast<uint32_t>(unculled_slots.size());
+            unculled_slots.push_back(slot);
+            break;
+        case Placement::None:
+            break;
+        }
+
+        state.placement = placement;
     }
 
     void Renderer::render(mn::Graphics::RenderFrame& rf) const
@@ -144,33 +316,38 @@ namespace Engine::System
         using namespace mn;
         using namespace mn::Graphics;
 
-        struct ModelRep
-        {
-            std::size_t offset, count;
-            std::shared_ptr<TypeBuffer<Mesh::Vertex>> vertex;
-            std::shared_ptr<TypeBuffer<uint32_t>> index;
-            std::size_t index_offset, index_count;
-            System::Material::Instance material;
-            BoundingBox aabb;
-            bool lit;
-        };
+        // Everything allocated for this frame alone comes out of the arena
+        frame_arena.reset();
+        const auto allocations_start = Util::allocationCount();
 
-        std::vector<ModelRep> offsets;
+        // Anything past MaxCameras has no room in the gbuffer descriptor or the per-slot camera masks,
+        // those cameras are left out (and it's said once, not every frame)
+        const auto camera_limit = std::min<std::size_t>(camera_query.count(), MaxCameras);
+        if ((camera_query.count() > MaxCameras) != too_many_cameras)
+        {
+            too_many_cameras = !too_many_cameras;
+            if (too_many_cameras)
+                std::cout << "Renderer: " << camera_query.count() << " cameras, only the first " << MaxCameras << " are drawn\n";
+        }
 
         // Resize our GPU buffers
-        scene_data.resize(camera_query.count()); 
-        light_data.resize(light_query.count());
+        if (scene_data.size() != camera_limit) scene_data.resize(camera_limit);
+        if (light_data.size() != light_query.count())  light_data.resize(light_query.count());
 
         // Create as many gbuffers as we need this frame to accomodate for all the cameras
-        if (gbuffers.size() < camera_query.count())
-            gbuffers.resize(camera_query.count());
+        if (gbuffers.size() < camera_limit)
+        {
+            gbuffers.resize(camera_limit);
+            descriptor_dirty = true;
+        }
 
         // we can keep handle the descriptor set here as well
         // go through the unique models and push the texture
 
         total_instance_count = 0;
-        std::unordered_map<
-            std::shared_ptr<Model::BoundedMesh>, std::vector<InstanceData>> instance_data;
+
+        if (!thread_pool || thread_pool->size() != std::max<std::size_t>(settings.worker_count, 1))
+            thread_pool = std::make_shared<Util::ThreadPool>(std::max<std::size_t>(settings.worker_count, 1));
 
         auto flecs_block = profiler->beginBlock("FlecsBlock");
 
@@ -178,230 +355,866 @@ namespace Engine::System
         {
             Component::Transform transform;
             Component::Camera camera;
+            Frustum frustum;
+            mn::Math::Mat4<float> view_projection;
+            mn::Math::Vec2u size;
+
+            // Pixels covered by one unit of error one unit away from the camera
+            float pixels_per_unit;
         };
 
-        std::vector<CameraRep> cameras;
-        std::vector<std::shared_ptr<Graphics::Image>> camera_images;
+        std::pmr::vector<CameraRep> cameras(&frame_arena);
+        std::pmr::vector<std::shared_ptr<Graphics::Image>> camera_images(&frame_arena);
+        cameras.reserve(camera_limit);
+        camera_images.reserve(camera_limit);
 
         auto camera_query_block = profiler->beginBlock("CameraQuery");
         std::size_t it = 0;
         camera_query.each(
             [this, &rf, &it, &camera_images, &cameras](flecs::entity e, const Component::Camera& camera)
             {
+                if (it == MaxCameras) return;
+
                 const auto& attach = camera.surface->getColorAttachments()[0];
 
                 if (gbuffers[it].size != attach.size)
+                {
                     gbuffers[it].rebuild(attach.size);
+                    descriptor_dirty = true;
+                }
+
+                const auto& transform = *e.get<Component::Transform>();
 
+                auto& scene = scene_data[it++];
+                scene.view            = camera.createViewMatrix(transform);
+                scene.projection      = Math::perspective((float)Math::x(attach.size) / (float)Math::y(attach.size), camera.FOV, camera.near_far);
+                scene.view_projection = scene.view * scene.projection;
+                scene.camera_position = transform.position;
+
+                // The frustum planes only depend on the camera, so build them once for the frame
                 camera_images.push_back(camera.surface);
                 cameras.push_back(CameraRep{
-                    .transform = *e.get<Component::Transform>(),
-                    .camera    = camera
+                    .transform       = transform,
+                    .camera          = camera,
+                    .frustum         = Frustum::fromCamera(transform, camera),
+                    .view_projection = scene.view_projection,
+                    .size            = attach.size,
+                    .pixels_per_unit = Math::y(attach.size) / (2.f * std::tan(static_cast<float>(camera.FOV.asRadians()) * 0.5f))
                 });
-
-                scene_data[it  ].view = camera.createViewMatrix(*e.get<Component::Transform>());
-                scene_data[it++].projection = Math::perspective((float)Math::x(attach.size) / (float)Math::y(attach.size), camera.FOV, camera.near_far);
             });
         profiler->endBlock(camera_query_block, "CameraQuery");
 
-        assert(cameras.size() == 1);
+        const auto camera_count = cameras.size();
+
+        // Memory the BVHs and their walks hold on to, growing it means this frame wasn't steady yet
+        const auto bvh_memory = [this]()
+        {
+            std::size_t bytes = static_bvh.allocated() + dynamic_bvh.allocated();
+            bytes += (unculled_slots.capacity() + visible_slots.capacity()) * sizeof(uint32_t) + slot_cameras.capacity() * sizeof(uint16_t);
+            for (const auto& view : bvh_views)
+                bytes += view.slots.capacity() * sizeof(uint32_t) + view.stack.capacity() * sizeof(view.stack[0]);
+            return bytes;
+        };
+        const auto bvh_memory_start = bvh_memory();
+
+        // Per-mesh tables are indexed by BoundedMesh::id, so they only grow when new meshes are created
+        const std::size_t mesh_count = Model::BoundedMesh::idCount();
+        if (camera_views.size() < camera_count) camera_views.resize(camera_count);
+        for (std::size_t c = 0; c < camera_count; c++)
+            if (camera_views[c].mesh_buckets.size() < mesh_count)
+            {
+                camera_views[c].mesh_buckets.resize(mesh_count);
+                camera_views[c].frame_meshes.reserve(mesh_count);
+            }
+
+        // Bring the persistent instance table up to date. Only the slots of entities whose Transform
+        // or Model changed since last frame are recomputed and written
+        const auto upload_block = profiler->beginBlock("SceneUpload");
+        {
+            const auto mark_all = [this]()
+            {
+                for (uint32_t slot = 0; slot < slot_entities.size(); slot++)
+                    if (slot_entities[slot] && !slot_dirty[slot])
+                    {
+                        slot_dirty[slot] = 1;
+                        dirty_slots.push_back(slot);
+                    }
+            };
+
+            // The LOD hysteresis is kept per camera, so a new camera count resizes every slot's state
+            if (settings.full_upload || camera_count != last_shape.cameras) mark_all();
+
+            if (brother_buffer.size() < slot_entities.size())
+            {
+                // Resizing doesn't promise to keep the old contents, so everything goes up again
+                brother_buffer.resize(std::max(slot_entities.size(), brother_buffer.size() * 2));
+                mark_all();
+            }
+
+            constexpr std::size_t Batch = 256;
+            thread_pool->parallel_for((dirty_slots.size() + Batch - 1) / Batch,
+                [&](std::size_t b, std::size_t)
+                {
+                    const auto end = std::min(dirty_slots.size(), (b + 1) * Batch);
+                    for (std::size_t i = b * Batch; i < end; i++)
+                    {
+                        const auto slot = dirty_slots[i];
+                        slot_dirty[slot] = 0;
+
+                        const flecs::entity e(world, slot_entities[slot]);
+                        if (!slot_entities[slot] || !e.is_alive()) continue;
+
+                        const auto& transform = *e.get<Component::Transform>();
+                        const auto& model     = *e.get<Component::Model>();
+
+                        //const auto normal    = Math::rotation<float>(transform.rotation);
+                        const auto normal    = (transform.rotation_matrix ? *transform.rotation_matrix : Math::rotationUsingQuaternion<float>(transform.rotation));
+                        const auto model_mat = Math::scale(transform.scale) * normal * Math::translation(transform.position);
+
+                        auto& state = slots[slot];
+                        state.resource     = model.model.value;
+                        state.occluder     = e.has<Component::Occluder>();
+                        state.dont_cull    = e.has<Component::DontCull>();
+                        state.model        = model_mat;
+                        state.scale        = std::max({ std::abs(Math::x(transform.scale)), std::abs(Math::y(transform.scale)), std::abs(Math::z(transform.scale)) });
+                        state.cone_culling = (Math::x(transform.scale) * Math::y(transform.scale) * Math::z(transform.scale) > 0.f);
+                        state.lod_bias     = model.lod_bias;
+                        state.lod_override = model.lod_override;
+
+                        // The hysteresis state is per mesh and camera, start over if either count changed
+                        const auto lod_states = (model.model.value ? model.model.value->getMeshes().size() * camera_count : 0);
+                        if (state.lods.size() != lod_states) state.lods.assign(lod_states, NoLevel);
+
+                        // Still loading, nothing to draw until the scene swaps the model in
+                        if (!model.model.value || model.model.value->getMeshes().empty() || e.has<Component::Hidden>())
+                            state.wanted = Placement::None;
+                        else
+                        {
+                            const auto& meshes = model.model.value->getMeshes();
+                            state.bounds = CullingStage::worldBounds(meshes[0]->aabb, model_mat);
+                            for (std::size_t m = 1; m < meshes.size(); m++)
+                            {
+                                const auto bounds = CullingStage::worldBounds(meshes[m]->aabb, model_mat);
+                                state.bounds.min = Math::min(state.bounds.min, bounds.min);
+                                state.bounds.max = Math::max(state.bounds.max, bounds.max);
+                            }
+
+                            state.wanted = 
+                                state.dont_cull ? Placement::Unculled :
+                                e.has<Component::Static>() ? Placement::Static : 
+                                Placement::Dynamic;
+                        }
+
+                        brother_buffer[slot] = InstanceData{
+                            .rotation = toQuaternion(normal),
+                            .position = transform.position,
+                            .flags    = (model.lit ? GLSL::InstanceLit : 0u),
+                            .scale    = transform.scale
+                        };
+                    }
+                });
+
+            // The trees aren't thread safe, so the slots move between them here. Refits only touch the
+            // path up from the leaf, the static tree is rebuilt whole once this is done
+            for (const auto slot : dirty_slots)
+            {
+                if (!slot_entities[slot]) continue;
+
+                auto& state = slots[slot];
+                if (state.wanted != state.placement)
+                {
+                    unplace(slot);
+                    place(slot, state.wanted);
+                }
+                else if (state.placement == Placement::Static)
+                    static_dirty |= static_bvh.update(state.leaf, state.bounds);
+                else if (state.placement == Placement::Dynamic)
+                    dynamic_bvh.update(state.leaf, state.bounds);
+            }
+
+            if (static_dirty)
+            {
+                static_bvh.rebuild();
+                static_dirty = false;
+                bvh_stats.rebuilds++;
+            }
+
+            if (dynamic_bvh.degradation() > settings.bvh_rebuild_threshold)
+            {
+                dynamic_bvh.rebuild();
+                bvh_stats.rebuilds++;
+            }
+
+            uploaded_instances = dirty_slots.size();
+            dirty_slots.clear();
+        }
+        profiler->endBlock(upload_block, "SceneUpload");
+
+        // Each camera walks the trees on its own, then the slots any of them found are gathered once,
+        // remembering which cameras found each
+        const auto culling_block = profiler->beginBlock("Culling");
+        if (bvh_views.size() < camera_count) bvh_views.resize(camera_count);
+        if (slot_cameras.size() < slots.size()) slot_cameras.resize(slots.size(), 0);
 
-        const auto model_query_block = profiler->beginBlock("ModelQuery"); 
-        model_query.each(
-            [&](flecs::entity e, const Component::Model& model, const Component::Transform& transform)
+        thread_pool->parallel_for(camera_count,
+            [&](std::size_t c, std::size_t)
             {
-                if (e.has<Component::Hidden>()) return;
+                auto& view = bvh_views[c];
+                view.slots.clear();
+                view.visited  = static_bvh.query(cameras[c].frustum, view.slots, view.stack);
+                view.visited += dynamic_bvh.query(cameras[c].frustum, view.slots, view.stack);
+            });
+
+        visible_slots.clear();
+        bvh_stats.visited = 0;
+        for (std::size_t c = 0; c < camera_count; c++)
+        {
+            for (const auto slot : bvh_views[c].slots)
+            {
+                if (!slot_cameras[slot]) visible_slots.push_back(slot);
+                slot_cameras[slot] |= uint16_t(1U << c);
+            }
+            bvh_stats.visited += bvh_views[c].visited;
+        }
+
+        const auto all_cameras = static_cast<uint16_t>((1U << camera_count) - 1);
+        for (const auto slot : unculled_slots)
+        {
+            if (!slot_cameras[slot]) visible_slots.push_back(slot);
+            slot_cameras[slot] = all_cameras;
+        }
+
+        // Hand each worker a contiguous range of those slots so that concatenating their results in
+        // worker order keeps the order the trees gave them in. The meshes of every slot still get
+        // their own frustum test, the trees only bound whole instances
+        const auto worker_count = std::min(thread_pool->size(), std::max<std::size_t>(visible_slots.size(), 1));
+        if (workers.size() < worker_count) workers.resize(worker_count);
 
-                //const auto normal    = Math::rotation<float>(transform.rotation);
-                const auto normal    = (transform.rotation_matrix ? *transform.rotation_matrix : Math::rotationUsingQuaternion<float>(transform.rotation));
-                const auto model_mat = Math::scale(transform.scale) * normal * Math::translation(transform.position);
-                for (const auto& mesh : model.model.value->getMeshes())
+        thread_pool->parallel_for(worker_count,
+            [&](std::size_t w, std::size_t)
+            {
+                auto& worker = workers[w];
+                worker.culling.clear();
+                worker.candidates.clear();
+                if (worker.views.size() < camera_count) worker.views.resize(camera_count);
+
+                const std::size_t begin = visible_slots.size() * w / worker_count;
+                const std::size_t end   = visible_slots.size() * (w + 1) / worker_count;
+                for (std::size_t i = begin; i < end; i++)
                 {
-                    if (e.has<Component::DontCull>() || !cull(mesh->aabb, model_mat, cameras[0].transform, cameras[0].camera))
+                    const auto slot   = visible_slots[i];
+                    const auto& state = slots[slot];
+                    const auto& meshes = state.resource->getMeshes();
+                    for (uint32_t m = 0; m < meshes.size(); m++)
                     {
-                        instance_data[mesh].push_back(InstanceData{
-                            .model  = model_mat,
-                            .normal = normal,
-                            .lit    = model.lit
+                        worker.culling.push(meshes[m]->aabb, state.model, state.dont_cull);
+                        worker.candidates.push_back(Worker::Candidate{
+                            .mesh       = meshes[m].get(),
+                            .slot       = slot,
+                            .mesh_index = m,
+                            .occluder   = state.occluder,
+                            .always_visible = state.dont_cull
                         });
-                        total_instance_count++;
+                    }
+                }
+
+                for (std::size_t c = 0; c < camera_count; c++)
+                {
+                    auto& view = worker.views[c];
+                    view.mask = worker.culling.run(cameras[c].frustum);
+
+                    // Only the meshes of slots this camera's walk found
+                    if (camera_count > 1)
+                        for (std::size_t i = 0; i < worker.candidates.size(); i++)
+                            if (!((slot_cameras[worker.candidates[i].slot] >> c) & 1))
+                                view.mask[i / 64] &= ~(uint64_t(1) << (i % 64));
+
+                    // Whatever is big enough on screen could occlude, the picks are made once every worker is done
+                    view.occluders.clear();
+                    if (!settings.occlusion_culling) continue;
+
+                    const auto& camera = cameras[c];
+                    for (std::size_t i = 0; i < worker.candidates.size(); i++)
+                    {
+                        const auto& candidate = worker.candidates[i];
+                        if (!view.visible(i)) continue;
+                        if (candidate.occluder)
+                        {
+                            view.occluders.push_back({ std::numeric_limits<float>::max(), static_cast<uint32_t>(i) });
+                            continue;
+                        }
+                        if (!settings.auto_occluders) continue;
+
+                        const auto& aabb  = candidate.mesh->aabb;
+                        const auto& slot  = slots[candidate.slot];
+                        const auto center = slot.model * Math::Vec4f{
+                            (Math::x(aabb.min) + Math::x(aabb.max)) * 0.5f,
+                            (Math::y(aabb.min) + Math::y(aabb.max)) * 0.5f,
+                            (Math::z(aabb.min) + Math::z(aabb.max)) * 0.5f,
+                            1.f
+                        };
+                        const float distance = Math::length(Math::xyz(center) - camera.transform.position);
+                        const float radius   = Math::length(aabb.max - aabb.min) * 0.5f * slot.scale;
+                        const float size     = 2.f * radius * camera.pixels_per_unit / (std::max(distance, 1e-3f) * Math::y(camera.size));
+                        if (size >= settings.occluder_min_size)
+                            view.occluders.push_back({ size, static_cast<uint32_t>(i) });
                     }
                 }
             });
-        profiler->endBlock(model_query_block, "ModelQuery"); 
-        
-        const auto instance_copy = profiler->beginBlock("InstanceCopy");
 
-        if (brother_buffer.size() < total_instance_count)
-            brother_buffer.resize(total_instance_count);
+        for (const auto slot : visible_slots) slot_cameras[slot] = 0;
+        const bool bvh_grew = (bvh_memory() != bvh_memory_start);
+        profiler->endBlock(culling_block, "Culling");
 
-        it = 0;
-        for (auto& [ model, matrices ] : instance_data)
+        // Each camera draws its occluders into its own depth buffer, then everything its frustum kept
+        // is tested against it and counted per mesh
+        bool occlusion_grew = false;
+        const auto occlusion_block = profiler->beginBlock("Occlusion");
         {
-            if (!matrices.size()) continue;
+            const bool occlusion = settings.occlusion_culling;
+            if (occlusion)
+            {
+                if (occluder_picks.size() < camera_count) occluder_picks.resize(camera_count);
+                if (occlusion_buffers.size() < camera_count) occlusion_buffers.resize(camera_count);
+                if (occluder_meshes.size() < mesh_count) occluder_meshes.resize(mesh_count);
+
+                // Tagged occluders first, then the biggest on screen. The geometry is decoded here, on
+                // one thread, since the cameras share it
+                for (std::size_t c = 0; c < camera_count; c++)
+                {
+                    auto& picks = occluder_picks[c];
+                    const auto capacity = picks.capacity();
+                    picks.clear();
+                    for (uint32_t w = 0; w < worker_count; w++)
+                        for (const auto& [ size, i ] : workers[w].views[c].occluders)
+                            picks.push_back(OccluderPick{ .size = size, .worker = w, .candidate = i, .mesh = nullptr });
+
+                    const auto count = std::min(picks.size(), settings.max_occluders);
+                    std::partial_sort(picks.begin(), picks.begin() + count, picks.end(),
+                        [](const auto& a, const auto& b) { return a.size > b.size; });
+                    picks.erase(picks.begin() + count, picks.end());
+
+                    for (auto& pick : picks)
+                    {
+                        const auto& candidate = workers[pick.worker].candidates[pick.candidate];
+                        bool built = false;
+                        pick.mesh = occluderMesh(*candidate.mesh, candidate.occluder, built);
+                        occlusion_grew |= built;
+                    }
+                    occlusion_grew |= (picks.capacity() != capacity);
+                }
+
+                thread_pool->parallel_for(camera_count,
+                    [&](std::size_t c, std::size_t)
+                    {
+                        const auto& camera = cameras[c];
+                        const auto height  = settings.occlusion_height;
+                        auto& buffer = occlusion_buffers[c];
+
+                        buffer.resize(height * Math::x(camera.size) / std::max(Math::y(camera.size), 1U), height);
+                        buffer.clear(camera.view_projection, Math::x(camera.camera.near_far));
+                        for (const auto& pick : occluder_picks[c])
+                            if (pick.mesh)
+                                buffer.rasterize(pick.mesh->positions, pick.mesh->indices, slots[workers[pick.worker].candidates[pick.candidate].slot].model);
+                        buffer.finish();
+                    });
+
+                for (std::size_t c = 0; c < camera_count; c++)
+                    occlusion_grew |= occlusion_buffers[c].grew();
+            }
+
+            thread_pool->parallel_for(worker_count * camera_count,
+                [&](std::size_t job, std::size_t)
+                {
+                    const auto c = job % camera_count;
+                    auto& worker = workers[job / camera_count];
+                    auto& view   = worker.views[c];
 
-            // Here we sort the matrices based off distance from camera 
-            std::vector<std::pair<InstanceData, float>> distances;
-            for (auto& matrix : matrices)
+                    for (const auto& [ id, mesh ] : view.meshes) view.mesh_counts[id] = 0;
+                    view.meshes.clear();
+                    if (view.mesh_counts.size() < mesh_count)
+                    {
+                        view.mesh_counts.resize(mesh_count, 0);
+                        view.mesh_cursors.resize(mesh_count, 0);
+                        view.meshes.reserve(mesh_count);
+                    }
+
+                    view.occluded = 0;
+                    for (std::size_t i = 0; i < worker.candidates.size(); i++)
+                    {
+                        if (!view.visible(i)) continue;
+
+                        const auto& candidate = worker.candidates[i];
+                        if (occlusion && !candidate.always_visible && occlusion_buffers[c].occluded(candidate.mesh->aabb, slots[candidate.slot].model))
+                        {
+                            view.mask[i / 64] &= ~(uint64_t(1) << (i % 64));
+                            view.occluded++;
+                            continue;
+                        }
+
+                        const auto* mesh = candidate.mesh;
+                        if (!view.mesh_counts[mesh->id]++) view.meshes.push_back({ mesh->id, mesh });
+                    }
+                });
+
+            occlusion_stats = OcclusionStats{};
+            for (std::size_t c = 0; c < camera_count && occlusion; c++)
             {
-                const auto d1 = matrix.model * Math::Vec4f{0.f, 0.f, 0.f, 1.f};
-                const auto distance = Math::length(Math::Vec3f{Math::x(d1), Math::y(d1), Math::z(d1)} - cameras[0].transform.position);
-                distances.push_back({ matrix, distance });
+                for (const auto& pick : occluder_picks[c]) occlusion_stats.occluders += (pick.mesh != nullptr);
+                occlusion_stats.triangles += occlusion_buffers[c].triangles();
             }
+            for (std::size_t w = 0; w < worker_count; w++)
+                for (std::size_t c = 0; c < camera_count; c++)
+                    occlusion_stats.occluded += workers[w].views[c].occluded;
+        }
+        profiler->endBlock(occlusion_block, "Occlusion");
+
+        std::size_t candidate_count = 0;
+        for (std::size_t w = 0; w < worker_count; w++)
+            candidate_count += workers[w].candidates.size();
+
+        // Distances are quantized to 16 bits over [0, far] so the per-mesh sort can be a radix sort.
+        // The LOD level goes in the bits above so each level comes out as one run (finest first
+        // when drawing front to back). Back to front flips both
+        constexpr uint32_t DepthBits = 16;
+        constexpr uint32_t LevelBits = 8;
+        constexpr uint32_t DepthMax  = (1U << DepthBits) - 1;
+        constexpr uint32_t LevelMax  = (1U << LevelBits) - 1;
+        const bool back_to_front = (settings.sort_order == SortOrder::BackToFront);
+
+        const auto sort_key = [&](uint32_t level, float distance, float far_plane)
+        {
+            const auto depth = static_cast<uint32_t>(std::clamp(distance / far_plane, 0.f, 1.f) * DepthMax);
+            return back_to_front ?
+                (level << DepthBits) | (DepthMax - depth) :
+                ((LevelMax - level) << DepthBits) | depth;
+        };
 
-            std::sort(distances.begin(), distances.end(), [](const auto& mat1, const auto& mat2)
-            { return mat1.second < mat2.second; });
-            
-            for (std::size_t i = 0; i < distances.size(); i++)
-                brother_buffer[it + i] = distances[i].first;
-
-            const std::pair<float, std::optional<float>> lod_ranges[] = {
-                { 35.f, std::nullopt },
-                { 30.f, 35.f },
-                { 25.f, 30.f },
-                { 20.f, 25.f },
-                { 10.f, 20.f },
-                {  0.f, 10.f }
+        const auto key_level = [&](uint32_t key)
+        {
+            return (back_to_front ? key >> DepthBits : LevelMax - (key >> DepthBits));
+        };
+
+        // See selectLevel, the hysteresis state is kept per camera and mesh in the slot
+        const auto select_level = [&](const Model::BoundedMesh& mesh, Slot& slot, uint32_t mesh_index, std::size_t camera, float distance)
+        {
+            const float near_plane = Math::x(cameras[camera].camera.near_far);
+            const LodQuery query{
+                .pixels_per_error = slot.scale * cameras[camera].pixels_per_unit / std::max(distance, near_plane),
+                .threshold        = settings.lod_pixel_error * std::exp2(settings.lod_bias + slot.lod_bias),
+                .hysteresis       = settings.lod_hysteresis,
+                .override_level   = slot.lod_override
             };
 
-            const auto get_range = [&lod_ranges](float distance)
+            const auto meshes_per_camera = slot.lods.size() / camera_count;
+            auto* previous = (mesh_index < meshes_per_camera ? &slot.lods[camera * meshes_per_camera + mesh_index] : nullptr);
+            return selectLevel(mesh.lods.get(), query, previous);
+        };
+
+        // Lay each camera's visible instances out mesh by mesh (in order of first appearance), and within a
+        // mesh worker by worker, then let every worker scatter its instances into place
+        const auto merge_block = profiler->beginBlock("InstanceMerge");
+        {
+            for (std::size_t c = 0; c < camera_count; c++)
             {
-                for (std::size_t i = 0; i < 6; i++)
-                {
-                    if (lod_ranges[i].second)
+                auto& camera_view = camera_views[c];
+                for (const auto id : camera_view.frame_meshes) camera_view.mesh_buckets[id].count = 0;
+                camera_view.frame_meshes.clear();
+
+                for (std::size_t w = 0; w < worker_count; w++)
+                    for (const auto& [ id, mesh ] : workers[w].views[c].meshes)
                     {
-                        if (distance < *lod_ranges[i].second && distance >= lod_ranges[i].first)
-                            return i;
+                        auto& bucket = camera_view.mesh_buckets[id];
+                        if (!bucket.count)
+                        {
+                            bucket.mesh = mesh;
+                            camera_view.frame_meshes.push_back(id);
+                        }
+                        bucket.count += workers[w].views[c].mesh_counts[id];
                     }
-                    else
+
+                camera_view.offset = total_instance_count;
+                for (const auto id : camera_view.frame_meshes)
+                {
+                    auto& bucket = camera_view.mesh_buckets[id];
+                    bucket.offset = total_instance_count;
+                    total_instance_count += bucket.count;
+
+                    auto cursor = bucket.offset;
+                    for (std::size_t w = 0; w < worker_count; w++)
                     {
-                        if (distance >= lod_ranges[i].first)
-                            return i;
+                        workers[w].views[c].mesh_cursors[id] = cursor;
+                        cursor += workers[w].views[c].mesh_counts[id];
                     }
                 }
-                return std::size_t(0);
-            };
+                camera_view.count = total_instance_count - camera_view.offset;
+            }
 
-            std::optional<std::size_t> current_index;
-            for (int i = 0; i < distances.size(); i++)   
-            {
-                const auto index = get_range(distances[i].second);
-                if (!current_index || (current_index && *current_index != index))
+            // Sized by the candidate count so that visibility changes alone never reallocate
+            if (visible_instances.size() < candidate_count * camera_count)
+                visible_instances.resize(candidate_count * camera_count);
+
+            thread_pool->parallel_for(worker_count * camera_count,
+                [&](std::size_t job, std::size_t)
                 {
-                    if (index < model->lods.lod_offsets.size())
+                    const auto c = job % camera_count;
+                    auto& worker = workers[job / camera_count];
+                    auto& view   = worker.views[c];
+                    const auto& camera = cameras[c];
+
+                    for (std::size_t i = 0; i < worker.candidates.size(); i++)
                     {
-                        offsets.push_back(ModelRep{ 
-                            .offset = it + i, 
-                            .vertex = model->mesh->vertex, 
-                            .index = model->lods.lod, 
-                            .index_offset = model->lods.lod_offsets[index].offset, 
-                            .index_count = model->lods.lod_offsets[index].count,
-                            .material = model->material,
-                            .aabb = model->aabb
-                        });
+                        if (!view.visible(i)) continue;
+
+                        const auto& candidate = worker.candidates[i];
+                        const auto& aabb = candidate.mesh->aabb;
+                        auto& slot = slots[candidate.slot];
+
+                        // Measure from the middle of the mesh, and for the LOD from the closest its bounding sphere gets
+                        const auto d1 = slot.model * Math::Vec4f{
+                            (Math::x(aabb.min) + Math::x(aabb.max)) * 0.5f,
+                            (Math::y(aabb.min) + Math::y(aabb.max)) * 0.5f,
+                            (Math::z(aabb.min) + Math::z(aabb.max)) * 0.5f,
+                            1.f
+                        };
+                        const auto distance = Math::length(Math::Vec3f{Math::x(d1), Math::y(d1), Math::z(d1)} - camera.transform.position);
+                        const auto radius   = Math::length(aabb.max - aabb.min) * 0.5f * slot.scale;
+
+                        const auto level = select_level(*candidate.mesh, slot, candidate.mesh_index, c, distance - radius);
+                        visible_instances[view.mesh_cursors[candidate.mesh->id]++] = { 
+                            sort_key(level, distance, Math::y(camera.camera.near_far)), 
+                            candidate.slot 
+                        };
                     }
+                });
+        }
+        profiler->endBlock(merge_block, "InstanceMerge");
+        
+        const auto instance_copy = profiler->beginBlock("InstanceCopy");
+
+        if (instance_buffer.size() < total_instance_count)
+            instance_buffer.resize(total_instance_count);
+
+        // Ranges given back FramesInFlight frames ago are free to reuse from here on. Then grab the pool
+        // buffers once, a load growing them mid frame doesn't touch the ranges drawn here
+        geometry_pool->nextFrame();
+        const auto pool_binding = geometry_pool->binding();
+        const auto pool_indices = geometry_pool->indices();
+        auto& pool = pool_buffers[pool_frame++ % PoolHistory];
+        pool = PoolBuffers{ .vertices = geometry_pool->vertices(), .colors = geometry_pool->colors() };
+
+        // Every (camera, mesh) pair owns a disjoint range of instance_buffer, so they can be sorted and written in parallel
+        std::pmr::vector<std::pair<uint32_t, uint32_t>> frame_meshes(&frame_arena);
+        {
+            std::size_t mesh_total = 0;
+            for (std::size_t c = 0; c < camera_count; c++) mesh_total += camera_views[c].frame_meshes.size();
+            frame_meshes.reserve(mesh_total);
+            for (uint32_t c = 0; c < camera_count; c++)
+                for (const auto id : camera_views[c].frame_meshes) frame_meshes.push_back({ c, id });
+        }
+
+        // Radix sort ping-pongs through a scratch buffer, one per thread big enough for the largest mesh
+        if (sort_scratch.size() < thread_pool->size()) sort_scratch.resize(thread_pool->size());
+        if (meshlet_scratch.size() < thread_pool->size()) meshlet_scratch.resize(thread_pool->size());
+        std::size_t largest_bucket = 0, largest_meshlets = 0;
+        for (const auto& [ c, id ] : frame_meshes)
+        {
+            largest_bucket   = std::max(largest_bucket, camera_views[c].mesh_buckets[id].count);
+            largest_meshlets = std::max(largest_meshlets, camera_views[c].mesh_buckets[id].mesh->meshlets.size());
+        }
+        for (std::size_t t = 0; t < thread_pool->size(); t++)
+        {
+            if (sort_scratch[t].size() < largest_bucket) sort_scratch[t].resize(largest_bucket);
+            if (meshlet_scratch[t].size() < largest_meshlets) meshlet_scratch[t].resize(largest_meshlets);
+        }
+
+        // A partly culled instance takes a draw per surviving range, so the number of draws a mesh
+        // needs can change with nothing else in the scene changing
+        std::atomic<bool> reps_grew{false};
+        std::atomic<std::size_t> meshlets_tested{0}, meshlets_culled{0}, triangles_culled{0};
+
+        thread_pool->parallel_for(frame_meshes.size(),
+            [&](std::size_t b, std::size_t thread)
+            {
+                const auto& camera = cameras[frame_meshes[b].first];
+                auto& bucket = camera_views[frame_meshes[b].first].mesh_buckets[frame_meshes[b].second];
+                const auto* model = bucket.mesh;
+                const auto base   = bucket.offset;
+                const auto* lods  = model->lods.get();
+                const auto level_count = (lods ? lods->size() : 0);
+
+                // Here we sort the instances by LOD level, then distance from camera 
+                const auto distances = std::span(visible_instances).subspan(bucket.offset, bucket.count);
+                Util::radixSort(distances, std::span(sort_scratch[thread]), DepthBits + LevelBits,
+                    [](const SortItem& item) { return item.key; });
+                
+                for (std::size_t i = 0; i < distances.size(); i++)
+                    instance_buffer[base + i] = distances[i].slot;
+
+                // At least one run per LOD level plus the full mesh
+                bucket.reps.clear();
+                bucket.reps.reserve(level_count + 1);
+                const auto capacity = bucket.reps.capacity();
+
+                const auto push_rep = [&](std::size_t first, std::size_t count, std::size_t index_offset, std::size_t index_count)
+                {
+                    bucket.reps.push_back(ModelRep{ 
+                        .offset = base + first, 
+                        .count = count,
+                        .vertex = pool_binding, 
+                        .index = pool_indices, 
+                        .index_offset = index_offset, 
+                        .index_count = index_count,
+                        .material = model->material,
+                        .aabb = model->aabb,
+                        .color = model->color,
+                        .color_offset = (model->geometry.color_count ? 
+                            static_cast<int32_t>(model->geometry.color_offset) - static_cast<int32_t>(model->geometry.vertex_offset) : 
+                            GLSL::NoColorStream)
+                    });
+                };
+
+                // Then we take the LOD runs and push the offsets to partition this sub-field
+                // modulating the index_offset and index_count variables
+                const bool split_meshlets = settings.meshlet_culling && model->meshlets.size() > 1;
+                MeshletStats stats;
+                for (std::size_t first = 0; first < distances.size();)
+                {
+                    const std::size_t level = key_level(distances[first].key);
+                    auto last = first + 1;
+                    while (last < distances.size() && key_level(distances[last].key) == level) last++;
+
+                    const auto base_offset = model->geometry.index_offset;
+                    const auto lod = (level < level_count ? lods->level(level) : Model::BoundedMesh::LOD::Level{});
+
+                    // Levels are only ever added while the frame runs, so what the merge picked is still there
+                    if (lod.count)
+                        push_rep(first, last - first, lod.offset, lod.count);
+                    else if (!split_meshlets)
+                        push_rep(first, last - first, base_offset, model->index_count);
                     else
                     {
-                        offsets.push_back(ModelRep{ 
-                            .offset = it + i, 
-                            .vertex = model->mesh->vertex, 
-                            .index = model->mesh->index, 
-                            .index_offset = 0, 
-                            .index_count = model->mesh->index->size(),
-                            .material = model->material,
-                            .aabb = model->aabb
-                        });
+                        // Instances that keep every meshlet still go out as one instanced draw, the
+                        // rest draw what survived one instance at a time
+                        const auto visible = std::span(meshlet_scratch[thread]).first(model->meshlets.size());
+                        auto whole = first;
+                        for (auto i = first; i < last; i++)
+                        {
+                            const auto& slot = slots[distances[i].slot];
+                            const auto result = CullingStage::cullMeshlets(model->meshlets, slot.model, slot.scale, slot.cone_culling, camera.frustum, visible);
+                            stats.tested    += result.tested;
+                            stats.culled    += result.culled;
+                            stats.triangles += result.triangles;
+                            if (!result.culled) continue;
+
+                            if (whole < i) push_rep(whole, i - whole, base_offset, model->index_count);
+                            whole = i + 1;
+
+                            // Neighbouring meshlets are neighbours in the index buffer too
+                            const auto& meshlets = model->meshlets;
+                            for (std::size_t m = 0; m < meshlets.size();)
+                            {
+                                if (!visible[m])
+                                {
+                                    m++;
+                                    continue;
+                                }
+
+                                auto end = m + 1;
+                                while (end < meshlets.size() && visible[end]) end++;
+                                push_rep(i, 1, base_offset + meshlets[m].offset, meshlets[end - 1].offset + meshlets[end - 1].count - meshlets[m].offset);
+                                m = end;
+                            }
+                        }
+
+                        if (whole < last) push_rep(whole, last - whole, base_offset, model->index_count);
                     }
 
-                    current_index = index;
+                    first = last;
                 }
-            }
 
-            it += matrices.size();
+                if (bucket.reps.capacity() != capacity) reps_grew = true;
+                if (stats.tested)
+                {
+                    meshlets_tested  += stats.tested;
+                    meshlets_culled  += stats.culled;
+                    triangles_culled += stats.triangles;
+                }
+            });
 
-            // Then we take the LOD cutoffs and push the offsets to partition this sub-field
-            // modulating the index_offset and index_count variables
+        meshlet_stats = MeshletStats{
+            .tested    = meshlets_tested,
+            .culled    = meshlets_culled,
+            .triangles = triangles_culled
+        };
+
+        // One list of draws per camera, back to back
+        std::pmr::vector<std::pair<std::size_t, std::size_t>> camera_reps(&frame_arena);
+        camera_reps.reserve(camera_count);
+
+        std::size_t rep_count = 0;
+        for (const auto& [ c, id ] : frame_meshes) rep_count += camera_views[c].mesh_buckets[id].reps.size();
+
+        std::pmr::vector<ModelRep> offsets(&frame_arena);
+        offsets.reserve(rep_count);
+        for (std::size_t c = 0; c < camera_count; c++)
+        {
+            const auto first = offsets.size();
+            for (const auto id : camera_views[c].frame_meshes)
+                offsets.insert(offsets.end(), camera_views[c].mesh_buckets[id].reps.begin(), camera_views[c].mesh_buckets[id].reps.end());
+            camera_reps.push_back({ first, offsets.size() });
         }
+
         profiler->endBlock(instance_copy, "InstanceCopy");
 
+        const auto binning_block = profiler->beginBlock("LightBinning");
+
+        // Memory the light grids hold on to, like the BVHs growing it means this frame wasn't steady yet
+        if (light_clusters.size() < camera_count) light_clusters.resize(camera_count);
+        const auto cluster_memory = [this]()
+        {
+            std::size_t bytes = 0;
+            for (const auto& grid : light_clusters)
+                bytes += grid.allocated();
+            return bytes;
+        };
+        const auto cluster_memory_start = cluster_memory();
+
+        for (std::size_t c = 0; c < camera_count; c++)
+            light_clusters[c].setup(cameras[c].view_projection, cameras[c].camera.near_far, settings.light_clusters);
+
         it = 0;
         light_query.each(
             [&](const Component::Light& light, const Component::Transform& transform)
             {
                 light_data[it  ].position  = transform.position;
                 light_data[it  ].intensity = light.intensity;
-                light_data[it++].color    = light.color;
+                light_data[it  ].range     = light.range;
+                light_data[it++].color     = light.color;
+
+                for (std::size_t c = 0; c < camera_count; c++)
+                    light_clusters[c].push(transform.position, light.range);
             });
 
-        profiler->endBlock(flecs_block, "FlecsBlock");
+        thread_pool->parallel_for(camera_count, [&](std::size_t c, std::size_t) { light_clusters[c].run(); });
 
-        const auto desc_write = profiler->beginBlock("DescWrite");
+        // Every camera's clusters go after the earlier cameras', and its lists after theirs
+        clusters_per_camera = (camera_count ? light_clusters[0].clusters().size() : 0);
+        std::array<uint32_t, MaxCameras> index_bases{};
+        std::size_t index_count = 0;
+        for (std::size_t c = 0; c < camera_count; c++)
+        {
+            index_bases[c] = static_cast<uint32_t>(index_count);
+            index_count += light_clusters[c].indices().size();
+        }
 
-        // Should probably set this per model
-        std::vector<std::shared_ptr<Graphics::Backend::Sampler>> samplers;
-        std::vector<std::shared_ptr<Graphics::Image>> images;
-        
-        for (auto& gb : gbuffers)
+        bool clusters_grew = false;
+        if (cluster_data.size() < clusters_per_camera * camera_count)
         {
-            images.push_back(gb.gbuffer);
-            images.push_back(gb.hdr_surface);
+            cluster_data.resize(clusters_per_camera * camera_count);
+            clusters_grew = true;
         }
-        
+        if (cluster_light_data.size() < index_count)
         {
-            auto& device = Graphics::Backend::Instance::get()->getDevice();
-            samplers.push_back(device->getSampler(Graphics::Backend::Sampler::Nearest));
-            samplers.push_back(device->getSampler(Graphics::Backend::Sampler::Linear));
+            cluster_light_data.resize(std::max(index_count, cluster_light_data.size() * 2));
+            clusters_grew = true;
         }
-        
-        gbuffer_descriptor->update<Graphics::Descriptor::Layout::Binding::Sampler>(0, samplers);
-        gbuffer_descriptor->update<Graphics::Descriptor::Layout::Binding::Image  >(1, images);
 
-        profiler->endBlock(desc_write, "DescWrite");
+        std::array<std::size_t, MaxCameras> cluster_max{};
+        thread_pool->parallel_for(camera_count,
+            [&](std::size_t c, std::size_t)
+            {
+                const auto clusters = light_clusters[c].clusters();
+                const auto indices  = light_clusters[c].indices();
+                const auto first    = c * clusters_per_camera;
 
-        // For now we only support one camera
-        // In the future we may need to allocate instance buffers for each camera
-        // Then create yet another buffer that contains pointers to each of these buffers
-        // We can then index into it with scene_index
-        assert(camera_query.count() == 1);
+                for (std::size_t i = 0; i < clusters.size(); i++)
+                {
+                    cluster_data[first + i] = GLSL::Cluster{ clusters[i].offset + index_bases[c], clusters[i].count };
+                    cluster_max[c] = std::max<std::size_t>(cluster_max[c], clusters[i].count);
+                }
 
-        const auto cmd_record = profiler->beginBlock("CmdRecord");
+                for (std::size_t i = 0; i < indices.size(); i++)
+                    cluster_light_data[index_bases[c] + i] = indices[i];
+            });
 
-        for (uint32_t j = 0; j < camera_query.count(); j++)
+        cluster_stats = ClusterStats{};
+        for (std::size_t c = 0; c < camera_count; c++)
         {
-            if (instance_buffer.size() < total_instance_count)
-                instance_buffer.resize(total_instance_count);
+            cluster_stats.visible = std::max(cluster_stats.visible, light_clusters[c].visible());
+            cluster_stats.max     = std::max(cluster_stats.max, cluster_max[c]);
+        }
+        cluster_stats.indices = index_count;
+        clusters_grew |= (cluster_memory() != cluster_memory_start);
 
-            for (int i = 0; i < total_instance_count; i++)
-                instance_buffer[i] = i;
+        profiler->endBlock(binning_block, "LightBinning");
 
-            for (uint32_t i = 0; i < offsets.size(); i++)
-            {
-                int instances = ( i == offsets.size() - 1 ?
-                    brother_buffer.size() - offsets[i].offset :
-                    offsets[i + 1].offset - offsets[i].offset
-                );
+        profiler->endBlock(flecs_block, "FlecsBlock");
 
-                offsets[i].count = instances;
+        const auto desc_write = profiler->beginBlock("DescWrite");
 
-                /*
-                std::size_t index = 0;
-                while (index < instances)
-                {
-                    // Cull here
-                    bool within_view = true;
+        // The descriptor only references the gbuffer images, so it only needs rewriting when they change
+        if (descriptor_dirty)
+        {
+            // Should probably set this per model
+            samplers.clear();
+            images.clear();
 
-                    //   If within view, index++
-                    if (within_view) index++;
-                    //   else, swap with offsets[i].offset + instances, then instances--
-                    else
-                    {
-                        std::swap(instance_buffer[index], instance_buffer[offsets[i].offset + instances - 1]);
-                        instances--;
-                    }
-                }
-                offsets[i].count = index;*/
+            for (auto& gb : gbuffers)
+            {
+                images.push_back(gb.gbuffer);
+                images.push_back(gb.hdr_surface);
+                images.push_back(gb.histogram);
+                images.push_back(gb.adaptation[0]);
+                images.push_back(gb.adaptation[1]);
             }
+            
+            {
+                auto& device = Graphics::Backend::Instance::get()->getDevice();
+                samplers.push_back(device->getSampler(Graphics::Backend::Sampler::Nearest));
+                samplers.push_back(device->getSampler(Graphics::Backend::Sampler::Linear));
+            }
+            
+            gbuffer_descriptor->update<Graphics::Descriptor::Layout::Binding::Sampler>(0, samplers);
+            gbuffer_descriptor->update<Graphics::Descriptor::Layout::Binding::Image  >(1, images);
 
+            descriptor_dirty = false;
+        }
+
+        profiler->endBlock(desc_write, "DescWrite");
+
+        // Once the shape of the scene stops changing, and nothing had to grow to fit it, preparing a
+        // frame should not touch the heap at all
+        {
+            const FrameShape shape{
+                .entities   = entity_slots.size(),
+                .slots      = slot_entities.size(),
+                .candidates = candidate_count,
+                .meshes     = mesh_count,
+                .cameras    = cameras.size(),
+                .lights     = light_data.size()
+            };
+
+            render_allocations = Util::allocationCount() - allocations_start;
+            const bool steady = (shape == last_shape) && !frame_arena.grew() && !reps_grew && !occlusion_grew && !bvh_grew && !clusters_grew;
+            assert((!steady || !render_allocations) && "Heap allocation in steady-state render preparation");
+            last_shape = shape;
+        }
+
+        const auto cmd_record = profiler->beginBlock("CmdRecord");
+
+        // Seconds since the last frame, nothing to adapt over on the first one
+        const auto now = std::chrono::steady_clock::now();
+        const float frame_time = (last_frame == std::chrono::steady_clock::time_point{} ? 0.f : std::chrono::duration<float>(now - last_frame).count());
+        last_frame = now;
+
+        // The instance table itself only changed for the dirty slots, the draw order is rewritten every frame
+        upload_bytes = uploaded_instances * sizeof(InstanceData) + total_instance_count * sizeof(uint32_t);
+
+        for (uint32_t j = 0; j < camera_count; j++)
+        {
+            // This camera's draws, each already knows how many instances it covers
+            const auto [ first_rep, last_rep ] = camera_reps[j];
 
             const std::tuple<float, float, float> clear_color = 
             {
@@ -416,55 +1229,7 @@ namespace Engine::System
            
             rf.startRender(gbuffers[j].gbuffer);
 
-            Material::Instance current_material;
-            
-            for (std::size_t i = 0; i < offsets.size(); i++)
-            {
-                if (!offsets[i].count) continue;
-
-                rf.setPushConstant(*offsets[i].material.pipeline, PushConstant {
-                    .scene_index        = j, 
-                    .offset             = static_cast<uint32_t>(offsets[i].offset),
-                    .light_count        = static_cast<uint32_t>(light_data.size()),
-                    .lights             = light_data.getAddress(),
-                    .scene_data         = scene_data.getAddress(),
-                    .instance_indices   = instance_buffer.getAddress(),
-                    .models             = brother_buffer.getAddress(),
-                    .enable_lighting    = 1
-                });
-
-                // Would like to extract the *binding* that happens here and do it one for all meshes, instead of for each mesh
-                // The models are sorted by
-                // VERTEX 0
-                // INDEX 0
-                // INDEX 1
-                // INDEX 2
-                // VERTEX 1
-                // INDEX 0
-                // ...
-                // So we only need to bind the vertex buffer if it has changed
-
-                if (offsets[i].material.pipeline != current_material.pipeline)
-                {
-                    if (offsets[i].material.pipeline)
-                        rf.bind(offsets[i].material.pipeline);
-                    current_material.pipeline = offsets[i].material.pipeline;
-                }
-
-                if (offsets[i].material.set != current_material.set)
-                {
-                    if (offsets[i].material.set)
-                        rf.bind(0, offsets[i].material.pipeline, offsets[i].material.set);
-                    current_material.set = offsets[i].material.set;   
-                }
-
-                rf.drawIndexed(
-                    offsets[i].vertex, 
-                    offsets[i].index, 
-                    offsets[i].count, 
-                    offsets[i].index_offset, 
-                    offsets[i].index_count);
-            }
+            recordDraws(rf, std::span(offsets).subspan(first_rep, last_rep - first_rep), j, pool);
 
             // If draw_bounding_box
             // We need to have a copy of the brother_buffer here and calculate the correct model transform 
@@ -475,9 +1240,19 @@ namespace Engine::System
             rf.clear({ 0.f, 0.f, 0.f }, 0.f, gbuffers[j].hdr_surface);
             rf.startRender(gbuffers[j].hdr_surface);
 
+            const auto& grid = light_clusters[j];
             rf.setPushConstant(*quad_pipeline, GBufferPush {
-                .light_count      = static_cast<uint32_t>(light_data.size()),
                 .lights           = light_data.getAddress(),
+                .clusters         = cluster_data.getAddress(),
+                .cluster_lights   = cluster_light_data.getAddress(),
+                .scene_data       = scene_data.getAddress(),
+                .scene_index      = j,
+                .cluster_offset   = static_cast<uint32_t>(j * clusters_per_camera),
+                .grid_x           = grid.dimensions().x,
+                .grid_y           = grid.dimensions().y,
+                .grid_z           = grid.dimensions().z,
+                .slice_scale      = grid.sliceScale(),
+                .slice_bias       = grid.sliceBias(),
                 .view_pos         = cameras[j].transform.position
             });
 
@@ -488,25 +1263,54 @@ namespace Engine::System
 
             rf.endRender();
 
-            // TODO: Here run a compute shader that goes through all the pixels and atomicAdd's the
-            // brightness / (total pixel count) of each one to a storage buffer within the Gbuffer class
-            // We put a barrier here so the next drawing commands wait on the execution of the compute shader
-            // Once this is completed, *then* we run the hdr shader, which can read from this buffer to get
-            // the L_avg of the scene, which it can then use to calculate the exposure needed to correctly render
-            // the scene
+            // Auto exposure sorts the HDR surface into a luminance histogram, then reduces it into
+            // the adaptation image last frame's isn't in. The tonemap reads the exposure from there,
+            // the CPU never sees any of it. Both are plain fullscreen draws into images, RenderFrame
+            // has no compute dispatch and orders passes through their attachments
+            auto& gbuffer = gbuffers[j];
+            uint32_t adapted = 2;
+            if (settings.auto_exposure.enabled)
+            {
+                const auto& exposure = settings.auto_exposure;
+                const ExposurePush exposure_push{
+                    .scene_index         = j,
+                    .previous            = gbuffer.adapted,
+                    .min_log_luminance   = exposure.min_log_luminance,
+                    .log_luminance_range = exposure.log_luminance_range,
+                    .delta_time          = frame_time,
+                    .adaptation_rate     = exposure.adaptation_rate,
+                    .key                 = exposure.key,
+                    .low_percentile      = exposure.low_percentile,
+                    .high_percentile     = exposure.high_percentile
+                };
+
+                rf.clear({ 0.f, 0.f, 0.f }, 0.f, gbuffer.histogram);
+                rf.startRender(gbuffer.histogram);
+                rf.setPushConstant(*histogram_pipeline, exposure_push);
+                rf.bind(0, histogram_pipeline, gbuffer_descriptor);
+                rf.draw(histogram_pipeline, quad_mesh);
+                rf.endRender();
+
+                adapted = (gbuffer.adapted == 0 ? 1 : 0);
+                rf.clear({ 0.f, 0.f, 0.f }, 0.f, gbuffer.adaptation[adapted]);
+                rf.startRender(gbuffer.adaptation[adapted]);
+                rf.setPushConstant(*adaptation_pipeline, exposure_push);
+                rf.bind(0, adaptation_pipeline, gbuffer_descriptor);
+                rf.draw(adaptation_pipeline, quad_mesh);
+                rf.endRender();
+            }
+            // Starts over from scratch when turned back on
+            gbuffer.adapted = adapted;
 
             // Then we take this image and render onto the camera surface with the HDR shader
-            // The HDR shader should start out doing basic tone mapping
-            // Then, we can integrate further stages like automatic exposure which we can do by extracting
-            // the luminance histogram data using a compute shader
-            // https://bruop.github.io/exposure/
 
             rf.clear({ 0.f, 0.f, 0.f }, 0.f, camera_images[j]);
             rf.startRender(camera_images[j]);
 
             rf.setPushConstant(*hdr_pipeline, HDRPush {
-                .index = j,
-                .exposure = cameras[j].camera.exposure
+                .exposure = cameras[j].camera.exposure,
+                .index    = j,
+                .adapted  = adapted
             });
 
             rf.bind(0, hdr_pipeline, gbuffer_descriptor);
@@ -518,22 +1322,174 @@ namespace Engine::System
         profiler->endBlock(cmd_record, "CmdRecord");
     }
     
+    // Records a camera's draws into rf one after the other, on the render thread. It starts from no
+    // bound state, and only rebinds the pipeline and material table when they change between draws
+    void Renderer::recordDraws(mn::Graphics::RenderFrame& rf, std::span<const ModelRep> offsets, uint32_t scene_index, const PoolBuffers& pool) const
+    {
+        Material::Instance current_material;
+
+        for (std::size_t i = 0; i < offsets.size(); i++)
+        {
+            if (!offsets[i].count) continue;
+
+            const auto& material = offsets[i].material;
+
+            if (material.pipeline != current_material.pipeline)
+            {
+                if (material.pipeline)
+                    rf.bind(material.pipeline);
+                current_material.pipeline = material.pipeline;
+            }
+
+            // Every material pipeline shares the table's layout, so this binds once and stays bound
+            if (material.table != current_material.table)
+            {
+                if (material.table)
+                    rf.bind(0, material.pipeline, material.table->set);
+                current_material.table = material.table;
+            }
+
+            const auto& aabb = offsets[i].aabb;
+            rf.setPushConstant(*material.pipeline, PushConstant {
+                .position_min       = { mn::Math::x(aabb.min), mn::Math::y(aabb.min), mn::Math::z(aabb.min), 0.f },
+                .position_scale     = { 
+                    mn::Math::x(aabb.max) - mn::Math::x(aabb.min), 
+                    mn::Math::y(aabb.max) - mn::Math::y(aabb.min), 
+                    mn::Math::z(aabb.max) - mn::Math::z(aabb.min), 
+                    0.f 
+                },
+                .scene_data         = scene_data.getAddress(),
+                .models             = brother_buffer.getAddress(),
+                .lights             = light_data.getAddress(),
+                .instance_indices   = instance_buffer.getAddress(),
+                .materials          = (material.table ? material.table->rows.getAddress() : 0),
+                .vertices           = (pool.vertices ? pool.vertices->getAddress() : 0),
+                .colors             = (pool.colors ? pool.colors->getAddress() : 0),
+                .scene_index        = scene_index, 
+                .light_count        = static_cast<uint32_t>(light_data.size()),
+                .offset             = static_cast<uint32_t>(offsets[i].offset),
+                .enable_lighting    = 1,
+                .material           = material.index,
+                .color              = offsets[i].color,
+                .color_offset       = offsets[i].color_offset
+            });
+
+            rf.drawIndexed(
+                offsets[i].vertex, 
+                offsets[i].index, 
+                offsets[i].count, 
+                offsets[i].index_offset, 
+                offsets[i].index_count);
+        }
+    }
+    
     void Renderer::drawOverlay() const
     {
         ImGui::Begin("Renderer");
 
         ImGui::SeparatorText("Memory Info");
         ImGui::Text("Cameras: %i", camera_query.count());
+        if (too_many_cameras) ImGui::Text("  Only the first %lu cameras are drawn", MaxCameras);
         ImGui::Text("Lights:  %i", light_query.count());
-        ImGui::Text("Models:  %i", model_query.count());
+        ImGui::Text("Models:  %lu", entity_slots.size());
         ImGui::Text("Render Instance Count: %lu", total_instance_count);
+        ImGui::Text("Instance Slots: %lu (%lu free)", slot_entities.size(), free_slots.size());
+        ImGui::Text("Upload: %lu kB (%lu instances changed)", 
+            Util::convert<Util::Bytes, Util::Kilobytes>(upload_bytes),
+            uploaded_instances
+        );
+        ImGui::Text("Worker Threads: %lu", (thread_pool ? thread_pool->size() : 0));
+        ImGui::Text("Meshlets Culled: %lu / %lu (%s triangles)", 
+            meshlet_stats.culled, 
+            meshlet_stats.tested, 
+            Util::withCommas(meshlet_stats.triangles).c_str()
+        );
+
+        ImGui::Text("Occlusion Culled: %lu (%lu occluders, %s triangles)", 
+            occlusion_stats.occluded, 
+            occlusion_stats.occluders, 
+            Util::withCommas(occlusion_stats.triangles).c_str()
+        );
+
+        ImGui::Text("BVH: %lu static, %lu dynamic, %lu unculled (%lu nodes visited, %.2fx cost, %lu rebuilds)", 
+            static_bvh.size(), 
+            dynamic_bvh.size(), 
+            unculled_slots.size(), 
+            bvh_stats.visited, 
+            dynamic_bvh.degradation(), 
+            bvh_stats.rebuilds
+        );
+
+        ImGui::Text("Light Clusters: %lu lights visible, %lu max per cluster, %.2f average", 
+            cluster_stats.visible, 
+            cluster_stats.max, 
+            (clusters_per_camera && camera_query.count() ? (double)cluster_stats.indices / (double)(clusters_per_camera * camera_query.count()) : 0.0)
+        );
+
+        if (!light_clusters.empty() && light_clusters[0].clusters().size() && ImGui::TreeNode("Lights per Cluster"))
+        {
+            // The first camera's tiles as they sit on screen (Vulkan's clip space has -y at the top),
+            // showing one slice or the busiest slice behind each tile
+            const auto& grid = light_clusters[0];
+            const auto dims = grid.dimensions();
+            const auto clusters = grid.clusters();
+
+            ImGui::SliderInt("Slice", &cluster_view_slice, -1, static_cast<int>(dims.z) - 1);
+            cluster_view_slice = std::clamp(cluster_view_slice, -1, static_cast<int>(dims.z) - 1);
+
+            const auto lights_at = [&](uint32_t x, uint32_t y)
+            {
+                const auto tile = x + y * dims.x;
+                if (cluster_view_slice >= 0)
+                    return clusters[tile + cluster_view_slice * dims.x * dims.y].count;
+
+                uint32_t most = 0;
+                for (uint32_t z = 0; z < dims.z; z++)
+                    most = std::max(most, clusters[tile + z * dims.x * dims.y].count);
+                return most;
+            };
+
+            uint32_t most = 1;
+            for (uint32_t y = 0; y < dims.y; y++)
+                for (uint32_t x = 0; x < dims.x; x++)
+                    most = std::max(most, lights_at(x, y));
+
+            const float cell = 14.f;
+            auto* draw_list = ImGui::GetWindowDrawList();
+            const auto origin = ImGui::GetCursorScreenPos();
+            for (uint32_t y = 0; y < dims.y; y++)
+                for (uint32_t x = 0; x < dims.x; x++)
+                {
+                    const auto count = lights_at(x, y);
+                    const float t = static_cast<float>(count) / static_cast<float>(most);
+                    const ImVec2 min(origin.x + x * cell, origin.y + y * cell);
+                    draw_list->AddRectFilled(min, ImVec2(min.x + cell - 1.f, min.y + cell - 1.f), 
+                        count ? IM_COL32(static_cast<int>(255.f * t), static_cast<int>(200.f * (1.f - t)), 64, 255) : IM_COL32(32, 32, 32, 255));
+                }
+
+            ImGui::Dummy(ImVec2(dims.x * cell, dims.y * cell));
+            ImGui::Text("Most in a tile: %u", most);
+            ImGui::TreePop();
+        }
+
+        const auto pool = geometry_pool->stats();
+        ImGui::Text("Vertex Pool: %lu / %lu (%lu retiring, %.1f%% fragmented)", pool.vertex_used, pool.vertex_capacity, pool.vertex_retired, pool.vertex_fragmentation * 100.f);
+        ImGui::Text("Index Pool: %lu / %lu (%lu retiring, %.1f%% fragmented)", pool.index_used, pool.index_capacity, pool.index_retired, pool.index_fragmentation * 100.f);
+        ImGui::Text("Frame Arena: %lu / %lu kB", 
+            Util::convert<Util::Bytes, Util::Kilobytes>(frame_arena.used()), 
+            Util::convert<Util::Bytes, Util::Kilobytes>(frame_arena.capacity())
+        );
+#ifdef SOLDER_PROOF_COUNT_ALLOCATIONS
+        ImGui::Text("Heap Allocations (prep): %lu", render_allocations);
+#endif
         ImGui::Text("Total GPU Memory: %lu kB", 
-            Util::convert<Util::Bytes, Util::Kilobytes>(brother_buffer.allocated() + instance_buffer.allocated() + scene_data.allocated() + light_data.allocated())
+            Util::convert<Util::Bytes, Util::Kilobytes>(brother_buffer.allocated() + instance_buffer.allocated() + scene_data.allocated() + light_data.allocated() +
+                cluster_data.allocated() + cluster_light_data.allocated())
         );
 
         ImGui::SeparatorText("Execution Timing (over last 5 seconds)");
 
-        std::string names[] = { "FlecsBlock", "InstanceCopy", "ModelQuery", "CameraQuery", "DescWrite", "CmdRecord" };
+        std::string names[] = { "FlecsBlock", "InstanceCopy", "SceneUpload", "Culling", "Occlusion", "InstanceMerge", "LightBinning", "CameraQuery", "DescWrite", "CmdRecord" };
         double total_runtime = 
             profiler->getBlock("FlecsBlock")->getAverageRuntime(5.0) +
             profiler->getBlock("DescWrite")->getAverageRuntime(5.0) + 
@@ -548,7 +1504,7 @@ namespace Engine::System
         ImGui::TableSetColumnIndex(2);
         ImGui::Text("Perc. of Iteration");
 
-        for (int i = 0; i < 6; i++)
+        for (int i = 0; i < std::size(names); i++)
         {
             const auto time = profiler->getBlock(names[i])->getAverageRuntime(5.0);
             ImGui::TableNextRow();
@@ -592,160 +1548,54 @@ namespace Engine::System
         ImGui::End();
     }
 
-    // Me and my buddy ChatGPT wrote this function
-    bool Renderer::cull(const BoundingBox& aabb, const mn::Math::Mat4<float>& model, const Component::Transform& transform, const Component::Camera& camera) const
+    const Renderer::OccluderMesh* Renderer::occluderMesh(const Model::BoundedMesh& mesh, bool tagged, bool& built) const
     {
-        //return false;
-
         using namespace mn;
 
-        const auto viewMatrix = camera.createViewMatrix(transform);
-        const auto invView = Math::inv(viewMatrix);
-        const auto camera_pos_4 = invView * Math::Vec4f{ 0.f, 0.f, 0.f, 1.f };
-
-        auto position = Math::xyz(camera_pos_4);
-
-        // Step 1: Transform AABB to world space
-        BoundingBox worldAABB;
-        // Compute the 8 corners of the AABB in local space
-        std::array<Math::Vec4f, 8> corners = {
-            Math::Vec4f({ Math::x(aabb.min), Math::y(aabb.min), Math::z(aabb.min), 1.f }) * 0.9f,
-            Math::Vec4f({ Math::x(aabb.max), Math::y(aabb.min), Math::z(aabb.min), 1.f }) * 0.9f,
-            Math::Vec4f({ Math::x(aabb.min), Math::y(aabb.max), Math::z(aabb.min), 1.f }) * 0.9f,
-            Math::Vec4f({ Math::x(aabb.max), Math::y(aabb.max), Math::z(aabb.min), 1.f }) * 0.9f,
-            Math::Vec4f({ Math::x(aabb.min), Math::y(aabb.min), Math::z(aabb.max), 1.f }) * 0.9f,
-            Math::Vec4f({ Math::x(aabb.max), Math::y(aabb.min), Math::z(aabb.max), 1.f }) * 0.9f,
-            Math::Vec4f({ Math::x(aabb.min), Math::y(aabb.max), Math::z(aabb.max), 1.f }) * 0.9f,
-            Math::Vec4f({ Math::x(aabb.max), Math::y(aabb.max), Math::z(aabb.max), 1.f }) * 0.9f,
-        };
-        
-        // Transform corners by model matrix to get world-space AABB
-        for (auto& corner : corners)
-            corner = model * corner; // Assuming overloaded * for Mat4 * Vec3f
-
-        // Compute new world AABB from transformed corners
-        worldAABB.min = worldAABB.max = Math::xyz(corners[0]);
-        for (const auto& corner : corners)
-        {
-            worldAABB.min = Math::min(worldAABB.min, Math::xyz(corner));
-            worldAABB.max = Math::max(worldAABB.max, Math::xyz(corner));
-        }
-
-        if (Math::x(position) >= Math::x(worldAABB.min) && Math::x(position) <= Math::x(worldAABB.max) &&
-            Math::y(position) >= Math::y(worldAABB.min) && Math::y(position) <= Math::y(worldAABB.max) &&
-            Math::z(position) >= Math::z(worldAABB.min) && Math::z(position) <= Math::z(worldAABB.max))
-        {
-            // Camera is inside the bounding box, don't cull the object
-            return false;
-        }
-
-        // Step 2: Construct the frustum planes from the camera
-        // Get camera forward, right, and up vectors based on the rotation
-        const auto right_4 = (invView * Math::Vec4f{ 1.f, 0.f, 0.f, 1.f} - camera_pos_4);
-        const auto right = Math::normalized( Math::xyz(right_4) );
-
-        const auto up_4 = (invView * Math::Vec4f{ 0.f, 1.f, 0.f, 1.f} - camera_pos_4);
-        const auto up = Math::normalized( Math::xyz(up_4) );
-
-        const auto forward_4 = (invView * Math::Vec4f{ 0.f, 0.f, -1.f, 1.f} - camera_pos_4);
-        const auto forward = Math::normalized( Math::xyz(forward_4) );
+        // Never a LOD level, simplification only bounds how far the surface moves and not which way,
+        // so a level can cover pixels the real mesh doesn't and hide what's behind them
+        const std::size_t index_offset = mesh.geometry.index_offset, index_count = mesh.index_count;
+        if (!tagged && index_count / 3 > settings.occluder_max_triangles) return nullptr;
 
-        //auto forward = Math::rotateQuaternion(transform.rotation * -1.f, Math::Vec3f({ 0.0f, 0.0f, -1.0f })); // Assuming camera looks down -Z
-        //auto right   = Math::rotateQuaternion(transform.rotation * -1.f, Math::Vec3f({ 1.0f, 0.0f,  0.0f }));
-        //auto up      = Math::rotateQuaternion(transform.rotation * -1.f, Math::Vec3f({ 0.0f, 1.0f,  0.0f }));
+        auto& entry = occluder_meshes[mesh.id];
+        if (!entry.indices.empty() && entry.vertex_offset == mesh.geometry.vertex_offset && entry.index_offset == index_offset && entry.index_count == index_count)
+            return &entry;
 
-        // Calculate near and far distances
-        float nearDist = Math::x(camera.near_far);
-        float farDist  = Math::y(camera.near_far);
+        std::vector<GeometryPool::Vertex> packed(mesh.geometry.vertex_count);
+        std::vector<uint32_t> indices(index_count);
+        geometry_pool->read(mesh.geometry.vertex_offset, packed, index_offset, indices);
 
-        if (Math::length(position - worldAABB.min) <= nearDist + 1.f || 
-            Math::length(position - worldAABB.max) <= nearDist + 1.f)
+        // Only the vertices the triangles use are kept
+        std::vector<uint32_t> remap(packed.size(), std::numeric_limits<uint32_t>::max());
+        std::vector<GeometryPool::Vertex> used;
+        for (auto& index : indices)
         {
-            return false; // Don't cull if the object is very close to the near plane
-        }
-
-        // Calculate half dimensions of near and far planes based on FOV and aspect ratio
-
-        // TODO: For some reason changing the FOV doesn't change the culling...
-        float aspectRatio = (float)Math::x(camera.surface->getColorAttachments()[0].size) / (float)Math::y(camera.surface->getColorAttachments()[0].size); // Assuming 16:9 aspect ratio, adjust if needed
-        float nearHeight = 2.0f * tanf(camera.FOV.asRadians() / 2.0f) * nearDist;
-        float nearWidth = nearHeight * aspectRatio;
-        float farHeight = 2.0f * tanf(camera.FOV.asRadians() / 2.0f) * farDist;
-        float farWidth = farHeight * aspectRatio;
-
-        // Calculate centers of near and far planes
-        Math::Vec3f nearCenter = position + forward * nearDist;
-        Math::Vec3f farCenter  = position + forward * farDist;
-        // Step 3: Define the frustum planes (normal points inward)
-        // Step 3: Define the frustum planes (normal points inward)
-        std::array<Math::Vec4f, 6> frustumPlanes;
-
-        // Near plane
-        frustumPlanes[0] = Math::Vec4f({ Math::x(forward), Math::y(forward), Math::z(forward), -Math::inner(forward, nearCenter) });
-
-        // Far plane
-        frustumPlanes[1] = Math::Vec4f({ -Math::x(forward), -Math::y(forward), -Math::z(forward), Math::inner(forward, farCenter) });
-
-        // Correct Left plane calculation
-        Math::Vec3f leftEdgeNear = (nearCenter - (right * (nearWidth / 2.0f))) - position;  // Vector from camera to the left edge of the near plane
-        Math::Vec3f leftNormal = Math::normalized(Math::outer(up, leftEdgeNear));  // Cross product of the up vector and the left-edge vector
-        frustumPlanes[2] = Math::Vec4f({ Math::x(leftNormal), Math::y(leftNormal), Math::z(leftNormal), -Math::inner(leftNormal, nearCenter) });
-
-        // Correct Right plane calculation
-        Math::Vec3f rightEdgeNear = (nearCenter + (right * (nearWidth / 2.0f))) - position;  // Vector from camera to the right edge of the near plane
-        Math::Vec3f rightNormal = Math::normalized(Math::outer(rightEdgeNear, up));  // Cross product of the right-edge vector and the up vector
-        frustumPlanes[3] = Math::Vec4f({ Math::x(rightNormal), Math::y(rightNormal), Math::z(rightNormal), -Math::inner(rightNormal, nearCenter) });
-
-        // Correct Top plane calculation
-        Math::Vec3f topEdgeNear = (nearCenter + (up * (nearHeight / 2.0f))) - position;  // Vector from camera to the top edge of the near plane
-        Math::Vec3f topNormal = Math::normalized(Math::outer(right, topEdgeNear));  // Cross product of the right vector and the top-edge vector
-        frustumPlanes[4] = Math::Vec4f({ Math::x(topNormal), Math::y(topNormal), Math::z(topNormal), -Math::inner(topNormal, nearCenter) });
-
-        // Correct Bottom plane calculation
-        Math::Vec3f bottomEdgeNear = (nearCenter - (up * (nearHeight / 2.0f))) - position;  // Vector from camera to the bottom edge of the near plane
-        Math::Vec3f bottomNormal = Math::normalized(Math::outer(bottomEdgeNear, right));  // Cross product of the bottom-edge vector and the right vector
-        frustumPlanes[5] = Math::Vec4f({ Math::x(bottomNormal), Math::y(bottomNormal), Math::z(bottomNormal), -Math::inner(bottomNormal, nearCenter) });
-
-
-        // Step 4: Test the AABB against each frustum plane
-        for (const auto& plane : frustumPlanes)
-        {
-            auto normal = Math::xyz(plane);
-            float d = Math::w(plane);
-
-            // Calculate positive and negative vertex for plane-AABB test
-            Math::Vec3f positive = worldAABB.min;
-            Math::Vec3f negative = worldAABB.max;
-
-            if (Math::x(normal) >= 0) {
-                Math::x(positive) = Math::x(worldAABB.max);
-                Math::x(negative) = Math::x(worldAABB.min);
-            }
-            if (Math::y(normal) >= 0) {
-                Math::y(positive) = Math::y(worldAABB.max);
-                Math::y(negative) = Math::y(worldAABB.min);
-            }
-            if (Math::z(normal) >= 0) {
-                Math::z(positive) = Math::z(worldAABB.max);
-                Math::z(negative) = Math::z(worldAABB.min);
-            }
-
-            // Check if the positive vertex is outside the plane
-            if (Math::inner(normal, positive) + d < 0) {
-                // The AABB is outside the frustum
-                return true;
-            }
-
-            if (Math::inner(normal, negative) + d >= 0)
+            if (remap[index] == std::numeric_limits<uint32_t>::max())
             {
-                return false;
+                remap[index] = static_cast<uint32_t>(used.size());
+                used.push_back(packed[index]);
             }
+            index = remap[index];
         }
 
-        // If no planes exclude the AABB, it is inside the frustum
-        return false;
+        const auto vertices = unpackVertices(used, mesh.aabb);
+        entry.positions.resize(vertices.size());
+        std::transform(vertices.begin(), vertices.end(), entry.positions.begin(), [](const auto& vertex) { return vertex.position; });
+        entry.indices       = std::move(indices);
+        entry.vertex_offset = mesh.geometry.vertex_offset;
+        entry.index_offset  = index_offset;
+        entry.index_count   = index_count;
+
+        built = true;
+        return &entry;
     }
 
+    // Me and my buddy ChatGPT wrote this function
+    // Kept as the single-box reference for the batched CullingStage
+    bool Renderer::cull(const BoundingBox& aabb, const mn::Math::Mat4<float>& model, const Component::Transform& transform, const Component::Camera& camera) const
+    {
+        return CullingStage::cull(Frustum::fromCamera(transform, camera), CullingStage::worldBounds(aabb, model));
+    }
 
     /*
     bool Renderer::cull(
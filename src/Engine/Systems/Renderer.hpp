@@ -2,58 +2,87 @@
 
 #include "../Component.hpp"
 #include "../../Util/Profiler.hpp"
+#include "../../Util/ThreadPool.hpp"
+#include "../../Util/FrameArena.hpp"
+#include "Bvh.hpp"
+#include "Clusters.hpp"
+#include "Culling.hpp"
+#include "Exposure.hpp"
+#include "Occlusion.hpp"
+#include "ShaderTypes.hpp"
 
 #include <midnight/midnight.hpp>
 
 #include <flecs.h>
 
+#include <array>
+#include <chrono>
+#include <span>
+#include <thread>
+#include <unordered_map>
+
 namespace Engine::System
 {
     struct Renderer
     {
-        // Each model instance represented in the GPU
-        struct InstanceData
-        {
-            mn::Math::Mat4<float> model, normal;
-            uint32_t lit;
-            uint32_t test[15];
-        };
+        // Each model instance represented in the GPU (position, rotation quaternion, scale and flags)
+        using InstanceData = GLSL::Instance;
 
         // The per-camera data representation in the GPU
-        struct RenderData
-        {
-            mn::Math::Mat4<float> view, projection;
-        };
+        using RenderData = GLSL::SceneData;
 
         // The light information representation in the GPU
-        struct Light
-        {
-            float intensity;
-            mn::Math::Vec3f position, color;
-        };
+        using Light = GLSL::Light;
 
-        // The push constants
+        // The push constants. The xyz of position_min/position_scale dequantize the mesh's positions,
+        // colors[gl_VertexIndex + color_offset] is the vertex colour unless color_offset is NoColorStream
         struct PushConstant
         {
-            mn::Graphics::Buffer::gpu_addr scene_data, models, lights, instance_indices;
-            uint32_t scene_index, light_count, offset, enable_lighting;
+            mn::Math::Vec4f position_min, position_scale;
+            mn::Graphics::Buffer::gpu_addr scene_data, models, lights, instance_indices, materials, vertices, colors;
+            uint32_t scene_index, light_count, offset, enable_lighting, material, color;
+            int32_t color_offset;
+            uint32_t pad; // C++ rounds the struct up to 8 bytes anyway
         };
 
+        // The lighting pass reads its lights through the camera's clusters, which start at cluster_offset
+        // and are laid out grid_x * grid_y * grid_z (see LightClusters)
         struct GBufferPush
         {
-            mn::Graphics::Buffer::gpu_addr lights;
-            uint32_t light_count;
+            mn::Graphics::Buffer::gpu_addr lights, clusters, cluster_lights, scene_data;
+            uint32_t scene_index; // CameraImages * scene_index is the start of the corresponding images in the descriptor
+            uint32_t cluster_offset;
+            uint32_t grid_x, grid_y, grid_z;
+            float slice_scale, slice_bias;
+            uint32_t pad;
             mn::Math::Vec3f view_pos;
             float extra; // Stupid padding C vs. SPIR-V
-            // Should have a scene index variable here, 4 * scene_index is the start of
-            // the corresponding images in the descriptor
         };
 
         struct HDRPush
         {
             float exposure;
             uint32_t index;
-            // We want to read from scene_index * 4 + 3
+            uint32_t adapted; // The adaptation image auto exposure wrote this frame, 2 when it's off
+        };
+
+        // Shared by the two auto exposure passes, histogram.fragment.glsl and adaptation.fragment.glsl.
+        // previous is the adaptation image holding last frame's, 2 when there isn't one
+        struct ExposurePush
+        {
+            uint32_t scene_index;
+            uint32_t previous;
+            float min_log_luminance, log_luminance_range;
+            float delta_time, adaptation_rate, key;
+            float low_percentile, high_percentile;
+        };
+
+        // Order instances are drawn in within each mesh. Front to back lets early depth testing
+        // do its job, back to front is what blending needs
+        enum class SortOrder
+        {
+            FrontToBack,
+            BackToFront
         };
 
         // Renderer settings
@@ -61,6 +90,49 @@ namespace Engine::System
         {
             bool wireframe = false;
             bool bounding_boxes = false;
+            // Threads used to prepare the instance data (including the render thread)
+            std::size_t worker_count = std::max(1U, std::thread::hardware_concurrency());
+            // Only instances whose Transform or Model was set or marked modified<>() are uploaded, so
+            // anything writing through get_mut or a query has to call modified<>() itself. For
+            // debugging a missing modified<>(), full_upload uploads every instance every frame
+            bool full_upload = false;
+            SortOrder sort_order = SortOrder::FrontToBack;
+
+            // LODs are picked so their simplification error covers at most lod_pixel_error pixels
+            // on screen, scaled by 2^lod_bias (higher is coarser). An instance only leaves its current
+            // level once the error is lod_hysteresis (as a fraction) past the threshold
+            float lod_pixel_error = 1.f;
+            float lod_bias = 0.f;
+            float lod_hysteresis = 0.25f;
+
+            // Full detail instances are split into meshlets, and the ones outside the frustum or facing
+            // away from the camera are dropped. The survivors go out as one draw per contiguous range
+            bool meshlet_culling = true;
+
+            // Instances the frustum kept are tested against a small CPU depth buffer of the frame's
+            // occluders. Entities tagged Component::Occluder always go in, and with auto_occluders so
+            // does anything visible spanning occluder_min_size of the screen height, tagged ones first
+            // and at most max_occluders per camera. Occluders are drawn with their full resolution
+            // triangles, a simplified LOD can bulge past the silhouette and hide things that are in
+            // plain view. Meshes over occluder_max_triangles are left out unless tagged
+            bool occlusion_culling = true;
+            bool auto_occluders = true;
+            float occluder_min_size = 0.25f;
+            std::size_t max_occluders = 32;
+            std::size_t occluder_max_triangles = 4096;
+            // Rows in the occlusion buffer, the width follows each camera's aspect ratio
+            uint32_t occlusion_height = 128;
+
+            // Moving instances refit the dynamic BVH in place, which slowly makes it worse to walk.
+            // It's rebuilt once its cost climbs this far past a fresh build's
+            float bvh_rebuild_threshold = 1.5f;
+
+            // Tiles across and down the screen and depth slices each camera's lights are binned into.
+            // The lighting pass only shades a pixel with the lights in its cluster
+            LightClusters::Dimensions light_clusters;
+
+            // How the auto exposure passes meter each camera's HDR image, see AutoExposure
+            AutoExposure auto_exposure;
         } settings;
 
         // Images used to store geometry information
@@ -68,13 +140,24 @@ namespace Engine::System
         {
             mn::Math::Vec2u size;
             std::shared_ptr<mn::Graphics::Image> gbuffer, hdr_surface;
+            // Auto exposure's luminance histogram and the two adaptation images it ping-pongs between.
+            // adapted is the one written last, 2 before the first frame
+            std::shared_ptr<mn::Graphics::Image> histogram;
+            std::array<std::shared_ptr<mn::Graphics::Image>, 2> adaptation;
+            uint32_t adapted = 2;
 
             GBuffer() = default;
 
             void rebuild(mn::Math::Vec2u size);
         };
 
+        // Each camera takes GLSL::CameraImages images in the gbuffer descriptor, which has a fixed upper bound.
+        // Cameras past it aren't drawn
+        static constexpr std::size_t MaxCameras = 16;
+
         Renderer(flecs::world _world);
+        Renderer(const Renderer&) = delete;
+        ~Renderer();
         
         void render(mn::Graphics::RenderFrame& rf) const;
 
@@ -83,28 +166,278 @@ namespace Engine::System
     private:
         flecs::world world;
 
+        // Instance slot bookkeeping, driven by the observers set up in the constructor
+        void markDirty(flecs::entity e);
+        void releaseSlot(flecs::entity e);
+
+        // Has the slot looked at again whenever Tag comes or goes
+        template<typename Tag>
+        void watchTag();
+
+        // The vertex shader pulls vertices and colours through buffer addresses, which don't keep
+        // anything alive, so the renderer holds on to what the last few frames drew from in case
+        // a load grows the pool while they are still in flight
+        struct PoolBuffers
+        {
+            std::shared_ptr<mn::Graphics::TypeBuffer<GeometryPool::Vertex>> vertices;
+            std::shared_ptr<mn::Graphics::TypeBuffer<uint32_t>> colors;
+        };
+
+        static constexpr std::size_t PoolHistory = GeometryPool::FramesInFlight;
+        mutable std::array<PoolBuffers, PoolHistory> pool_buffers;
+        mutable std::size_t pool_frame = 0;
+
+        struct ModelRep;
+        void recordDraws(mn::Graphics::RenderFrame& rf, std::span<const ModelRep> offsets, uint32_t scene_index, const PoolBuffers& pool) const;
+
         bool cull(const BoundingBox& aabb, const mn::Math::Mat4<float>& model, const Component::Transform& transform, const Component::Camera& camera) const;
 
+        // A run of instances in instance_buffer drawn with a single mesh/LOD combination, or one
+        // instance drawing a range of its surviving meshlets
+        struct ModelRep
+        {
+            std::size_t offset, count;
+            std::shared_ptr<mn::Graphics::TypeBuffer<mn::Graphics::Mesh::Vertex>> vertex;
+            std::shared_ptr<mn::Graphics::TypeBuffer<uint32_t>> index;
+            std::size_t index_offset, index_count;
+            System::Material::Instance material;
+            // The vertices are quantized against this
+            BoundingBox aabb;
+            uint32_t color;
+            int32_t color_offset;
+            bool lit;
+        };
+
+        // Scratch space owned by one slice of the visible slots while preparing a frame.
+        // Everything here keeps its capacity between frames
+        struct Worker
+        {
+            struct Candidate
+            {
+                const Model::BoundedMesh* mesh;
+                uint32_t slot, mesh_index;
+                // Tagged Component::Occluder, Component::DontCull
+                bool occluder, always_visible;
+            };
+
+            // What one camera sees of this worker's candidates
+            struct Visibility
+            {
+                std::vector<uint64_t> mask;
+
+                // Visible instance count and write cursor per BoundedMesh::id, plus the meshes
+                // seen in order of first appearance (the id is kept alongside since the mesh
+                // may be gone by the time the counts are reset next frame)
+                std::vector<uint32_t> mesh_counts, mesh_cursors;
+                std::vector<std::pair<uint32_t, const Model::BoundedMesh*>> meshes;
+
+                // Visible candidates that could occlude (with how much of the screen they span),
+                // and how many candidates the occlusion test dropped
+                std::vector<std::pair<float, uint32_t>> occluders;
+                std::size_t occluded = 0;
+
+                bool visible(std::size_t index) const { return (mask[index / 64] >> (index % 64)) & 1; }
+            };
+
+            CullingStage culling;
+            std::vector<Candidate> candidates;
+            std::vector<Visibility> views;
+        };
+
+        // Per-mesh draw state indexed by BoundedMesh::id, persists across frames
+        struct MeshBucket
+        {
+            const Model::BoundedMesh* mesh = nullptr;
+            std::size_t offset = 0, count = 0;
+            std::vector<ModelRep> reps;
+        };
+
         mutable std::size_t total_instance_count;
 
+        mutable std::vector<Worker> workers;
+        mutable std::shared_ptr<Util::ThreadPool> thread_pool;
+
+        // Every mesh's vertices and indices live here, held so it outlives the models during shutdown
+        std::shared_ptr<GeometryPool> geometry_pool = GeometryPool::get();
+
+        // Everything one camera draws, the cameras sit back to back in instance_buffer
+        struct CameraView
+        {
+            std::size_t offset = 0, count = 0;
+            std::vector<MeshBucket> mesh_buckets;
+            std::vector<uint32_t> frame_meshes;
+        };
+
+        mutable std::vector<CameraView> camera_views;
+        // A visible instance waiting to be sorted, key is its LOD level above its quantized distance to the camera
+        struct SortItem
+        {
+            uint32_t key, slot;
+        };
+
+        mutable std::vector<SortItem> visible_instances;
+        mutable std::vector<std::vector<SortItem>> sort_scratch;
+
+        // Which of the BVHs a slot's bounds are in. Unculled slots (DontCull) skip both, and so does
+        // anything hidden or still loading
+        enum class Placement : uint8_t
+        {
+            None, Static, Dynamic, Unculled
+        };
+
+        // CPU side copy of what an instance slot needs for culling and LOD selection
+        struct Slot
+        {
+            // What the instance draws, culling finds it through the BVH rather than the entity
+            std::shared_ptr<Engine::Model> resource;
+            // World bounds over all of its meshes, and where they're kept. leaf is the BVH leaf, or the
+            // index into unculled_slots
+            BoundingBox bounds;
+            Placement placement = Placement::None, wanted = Placement::None;
+            uint32_t leaf = Bvh::Null;
+            // Tagged Component::Occluder, Component::DontCull
+            bool occluder = false, dont_cull = false;
+
+            mn::Math::Mat4<float> model;
+            float scale = 1.f, lod_bias = 0.f;
+            int lod_override = -1;
+
+            // Level each of the model's meshes was drawn at last frame by each camera, for the hysteresis
+            std::vector<uint8_t> lods;
+
+            // Normal cones only survive transforms that don't mirror the mesh
+            bool cone_culling = true;
+        };
+
+        // What meshlet culling did over a frame
+        mutable MeshletStats meshlet_stats;
+        mutable std::vector<std::vector<uint8_t>> meshlet_scratch;
+
+        // Object space positions and triangles of a mesh's full resolution geometry, decoded from the
+        // pool once and kept until the mesh moves in it. Indexed by BoundedMesh::id
+        struct OccluderMesh
+        {
+            std::size_t vertex_offset = 0, index_offset = 0, index_count = 0;
+            std::vector<mn::Math::Vec3f> positions;
+            std::vector<uint32_t> indices;
+        };
+
+        // One occluder a camera draws this frame
+        struct OccluderPick
+        {
+            float size;
+            uint32_t worker, candidate;
+            const OccluderMesh* mesh;
+        };
+
+        struct OcclusionStats
+        {
+            std::size_t occluders = 0, triangles = 0, occluded = 0;
+        };
+
+        mutable std::vector<OccluderMesh> occluder_meshes;
+        mutable std::vector<std::vector<OccluderPick>> occluder_picks;
+        mutable std::vector<OcclusionBuffer> occlusion_buffers;
+        mutable OcclusionStats occlusion_stats;
+
+        // The occluder geometry for mesh, null when it is too heavy to be worth it
+        const OccluderMesh* occluderMesh(const Model::BoundedMesh& mesh, bool tagged, bool& built) const;
+
+        // Moves a slot's bounds out of whatever holds them, and into the holder its placement says
+        void unplace(uint32_t slot) const;
+        void place(uint32_t slot, Placement placement) const;
+
+        mutable Bvh static_bvh, dynamic_bvh;
+        mutable std::vector<uint32_t> unculled_slots;
+        // A static slot changed, the static tree gets rebuilt before culling
+        mutable bool static_dirty = false;
+
+        // Each camera's walk of the trees. The slots any camera found are gathered in visible_slots,
+        // with a bit per camera that found them in slot_cameras (cleared again once culling is done)
+        struct BvhView
+        {
+            std::vector<uint32_t> slots;
+            std::vector<std::pair<uint32_t, uint32_t>> stack;
+            std::size_t visited = 0;
+        };
+
+        struct BvhStats
+        {
+            std::size_t visited = 0, rebuilds = 0;
+        };
+
+        mutable std::vector<BvhView> bvh_views;
+        mutable std::vector<uint32_t> visible_slots;
+        mutable std::vector<uint16_t> slot_cameras;
+        static_assert(MaxCameras <= 16, "slot_cameras has a bit per camera");
+        mutable BvhStats bvh_stats;
+
+        // One light grid per camera. The GPU copies sit back to back, every camera's clusters at
+        // clusters_per_camera * its index, with their offsets moved past the earlier cameras' indices
+        struct ClusterStats
+        {
+            std::size_t visible = 0, max = 0, indices = 0;
+        };
+
+        mutable std::vector<LightClusters> light_clusters;
+        mutable std::size_t clusters_per_camera = 0;
+        mutable ClusterStats cluster_stats;
+        // Depth slice the overlay's heatmap shows, -1 for the busiest slice of each tile
+        mutable int cluster_view_slice = -1;
+
+        // Every entity with a Model and Transform owns one slot in brother_buffer for as long as
+        // it lives. Only the slots marked dirty get recomputed and uploaded
+        std::unordered_map<flecs::entity_t, uint32_t> entity_slots;
+        std::vector<flecs::entity_t> slot_entities;
+        std::vector<uint32_t> free_slots;
+        mutable std::vector<uint32_t> dirty_slots;
+        mutable std::vector<uint8_t> slot_dirty;
+        mutable std::vector<Slot> slots;
+
+        mutable std::size_t upload_bytes = 0, uploaded_instances = 0;
+
+        std::vector<flecs::observer> observers;
+
+        // Backs every container that only lives for one call to render()
+        mutable Util::FrameArena frame_arena;
+
+        // Shape of the last frame, used to tell when we have reached a steady state
+        struct FrameShape
+        {
+            std::size_t entities, slots, candidates, meshes, cameras, lights;
+            bool operator==(const FrameShape&) const = default;
+        };
+
+        mutable FrameShape last_shape{};
+        mutable std::size_t render_allocations = 0;
+
+        mutable bool descriptor_dirty = true;
+        mutable std::vector<std::shared_ptr<mn::Graphics::Backend::Sampler>> samplers;
+        mutable std::vector<std::shared_ptr<mn::Graphics::Image>> images;
+
         mutable std::vector<GBuffer> gbuffers;
+        mutable bool too_many_cameras = false;
 
         std::shared_ptr<Util::Profiler> profiler;
 
         flecs::query<const Component::Camera> camera_query;
         flecs::query<const Component::Light, const Component::Transform> light_query;
-        flecs::query<const Component::Model, const Component::Transform> model_query;
 
         std::shared_ptr<mn::Graphics::Mesh> quad_mesh;
         //std::shared_ptr<Engine::Model> cube_model;
 
         std::shared_ptr<mn::Graphics::Descriptor::Layout> gbuffer_descriptor_layout;
         std::shared_ptr<mn::Graphics::Descriptor> gbuffer_descriptor;
-        std::shared_ptr<mn::Graphics::Pipeline> hdr_pipeline, quad_pipeline;
+        std::shared_ptr<mn::Graphics::Pipeline> hdr_pipeline, quad_pipeline, histogram_pipeline, adaptation_pipeline;
+
+        // For how far auto exposure adapts each frame
+        mutable std::chrono::steady_clock::time_point last_frame{};
 
         mutable mn::Graphics::TypeBuffer<InstanceData> brother_buffer;
         mutable mn::Graphics::TypeBuffer<uint32_t> instance_buffer;
         mutable mn::Graphics::TypeBuffer<RenderData> scene_data;
         mutable mn::Graphics::TypeBuffer<Light> light_data;
+        mutable mn::Graphics::TypeBuffer<GLSL::Cluster> cluster_data;
+        mutable mn::Graphics::TypeBuffer<uint32_t> cluster_light_data;
     };
 }
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <midnight/midnight.hpp>
+
+#include <cstdint>
+
+namespace Engine::System::GLSL
+{
+    using uint = uint32_t;
+    using vec3 = mn::Math::Vec3f;
+    using vec4 = mn::Math::Vec4f;
+    using mat4 = mn::Math::Mat4<float>;
+
+#include <shared.glsl>
+
+    // These have to line up with std430 on the GPU side
+    static_assert(sizeof(Instance)  == 48);
+    static_assert(sizeof(SceneData) == 208);
+    static_assert(sizeof(Light) == 32);
+    static_assert(sizeof(Cluster) == 8);
+    static_assert(sizeof(MaterialData) == 16);
+    static_assert(sizeof(PackedVertex) == 16);
+}
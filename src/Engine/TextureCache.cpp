@@ -0,0 +1,100 @@
+#include "TextureCache.hpp"
+
+#include "../Util/Hash.hpp"
+
+#include <iostream>
+
+namespace Engine
+{
+    TextureCache::TextureCache(std::size_t thread_count) :
+        queue(thread_count)
+    {   }
+
+    std::shared_ptr<TextureCache> TextureCache::get(ResourceManager& res)
+    {
+        if (!res.exists<TextureCache>("textures"))
+            return res.create<TextureCache>("textures").value;
+        return res.get<TextureCache>("textures").value;
+    }
+
+    TextureCache::Handle TextureCache::load(const std::filesystem::path& path)
+    {
+        std::error_code error;
+        auto canonical = std::filesystem::weakly_canonical(path, error);
+        if (error) canonical = path;
+        const auto key = canonical.string();
+
+        std::shared_ptr<Entry> entry;
+        {
+            std::lock_guard lock(mutex);
+            if (auto it = by_path.find(key); it != by_path.end())
+            {
+                path_hits++;
+                return it->second;
+            }
+
+            entry = std::make_shared<Entry>();
+            entry->path = canonical;
+            entry->hash = 0;
+            by_path[key] = entry;
+            unresolved.push_back(entry);
+        }
+
+        // Only the file is touched here, creating the texture uses the device so update() does it
+        queue.push([entry]()
+        {
+            entry->hash = Util::hashFile(entry->path);
+            entry->staged.store(true, std::memory_order_release);
+        });
+
+        return entry;
+    }
+
+    void TextureCache::update(ResourceManager& res)
+    {
+        std::lock_guard lock(mutex);
+
+        std::size_t uploads = 0;
+        std::erase_if(unresolved, [&](const std::shared_ptr<Entry>& entry)
+        {
+            if (!entry->staged.load(std::memory_order_acquire)) return false;
+
+            if (!entry->hash)
+            {
+                std::cout << "Error loading texture " << entry->path.string() << "\n";
+                entry->_failed.store(true, std::memory_order_release);
+                return true;
+            }
+
+            // Same contents as one that's already up, share it
+            if (auto it = by_hash.find(entry->hash); it != by_hash.end())
+            {
+                content_hits++;
+                entry->_texture = it->second->_texture;
+            }
+            else
+            {
+                if (uploads == UploadsPerUpdate) return false;
+                uploads++;
+
+                entry->_texture = std::make_shared<mn::Graphics::Texture>(entry->path.string());
+                by_hash[entry->hash] = entry;
+            }
+
+            entry->ready.store(true, std::memory_order_release);
+            res.insert<mn::Graphics::Texture>(entry->path.string(), entry->_texture);
+            return true;
+        });
+    }
+
+    TextureCache::Stats TextureCache::stats() const
+    {
+        std::lock_guard lock(mutex);
+        return Stats{
+            .textures     = by_hash.size(),
+            .pending      = unresolved.size(),
+            .path_hits    = path_hits,
+            .content_hits = content_hits
+        };
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <midnight/midnight.hpp>
+
+#include "ResourceManager.hpp"
+#include "../Util/TaskQueue.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace Engine
+{
+    // Every texture loaded from disk goes through here. Textures are keyed by canonical path and
+    // by a hash of the file contents, so the same image under two names is only uploaded once.
+    // Handles are handed out right away, still pending. The files are read and hashed on
+    // background threads, the textures themselves are only ever created in update() since that's
+    // where the device gets used. Lives in the resource manager under "textures"
+    struct TextureCache
+    {
+        struct Entry
+        {
+            std::filesystem::path path;
+
+            // Of the file contents, filled in once it's been read
+            uint64_t hash;
+
+            bool resident() const { return ready.load(std::memory_order_acquire); }
+
+            // The file couldn't be read, it never becomes resident
+            bool failed() const { return _failed.load(std::memory_order_acquire); }
+
+            // Null while pending
+            std::shared_ptr<mn::Graphics::Texture> texture() const { return (resident() ? _texture : nullptr); }
+
+        private:
+            friend struct TextureCache;
+            std::shared_ptr<mn::Graphics::Texture> _texture;
+            std::atomic<bool> staged{false}, ready{false}, _failed{false};
+        };
+
+        using Handle = std::shared_ptr<const Entry>;
+
+        struct Stats
+        {
+            std::size_t textures, pending, path_hits, content_hits;
+        };
+
+        // Textures created per update(), so a level full of them doesn't all land in one frame
+        static constexpr std::size_t UploadsPerUpdate = 4;
+
+        // With no threads files are hashed on the calling thread
+        TextureCache(std::size_t thread_count = 2);
+
+        Handle load(const std::filesystem::path& path);
+
+        // Called between frames on the main thread. Creates the textures whose files are done
+        // (or shares one already made from the same contents) and registers them with the resource
+        // manager under their path
+        void update(ResourceManager& res);
+
+        Stats stats() const;
+
+        static std::shared_ptr<TextureCache> get(ResourceManager& res);
+
+    private:
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<Entry>> by_path;
+        std::unordered_map<uint64_t, std::shared_ptr<Entry>> by_hash;
+        std::vector<std::shared_ptr<Entry>> unresolved;
+        std::size_t path_hits = 0, content_hits = 0;
+
+        // Last so its threads are joined before anything above goes away
+        Util::TaskQueue queue;
+    };
+}
@@ -0,0 +1,154 @@
+#include "VertexPacking.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <meshoptimizer.h>
+
+namespace Engine
+{
+    namespace
+    {
+        uint32_t pack2x16(int a, int b)
+        {
+            return (static_cast<uint32_t>(a) & 0xFFFF) | (static_cast<uint32_t>(b) << 16);
+        }
+
+        int unpack16(uint32_t packed, int half)
+        {
+            return static_cast<int>((packed >> (half * 16)) & 0xFFFF);
+        }
+
+        float snorm16(uint32_t packed, int half)
+        {
+            return std::max(static_cast<float>(static_cast<int16_t>(unpack16(packed, half))) / 32767.f, -1.f);
+        }
+
+        // IEEE half to float, same as unpackHalf2x16 does for one half
+        float halfToFloat(uint32_t packed, int which)
+        {
+            const auto bits     = static_cast<uint32_t>(unpack16(packed, which));
+            const float sign    = (bits & 0x8000 ? -1.f : 1.f);
+            const auto exponent = static_cast<int>((bits >> 10) & 0x1F);
+            const auto mantissa = static_cast<float>(bits & 0x3FF);
+
+            if (exponent == 0)  return sign * std::ldexp(mantissa, -24);
+            if (exponent == 31) return sign * (mantissa ? std::numeric_limits<float>::quiet_NaN() : std::numeric_limits<float>::infinity());
+            return sign * std::ldexp(1024.f + mantissa, exponent - 25);
+        }
+
+        // Where x sits between lo and hi, as a unorm. Flat axes all land on lo
+        float normalize(float x, float lo, float hi)
+        {
+            return (hi > lo ? std::clamp((x - lo) / (hi - lo), 0.f, 1.f) : 0.f);
+        }
+
+        // Folds the unit sphere onto the [-1, 1] square, lower hemisphere over the corners
+        mn::Math::Vec2f octEncode(const mn::Math::Vec3f& n)
+        {
+            using namespace mn;
+
+            const float length = std::abs(Math::x(n)) + std::abs(Math::y(n)) + std::abs(Math::z(n));
+            if (length <= 0.f) return { 0.f, 0.f };
+
+            float x = Math::x(n) / length, y = Math::y(n) / length;
+            if (Math::z(n) < 0.f)
+            {
+                const float fx = (1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f);
+                const float fy = (1.f - std::abs(x)) * (y >= 0.f ? 1.f : -1.f);
+                x = fx;
+                y = fy;
+            }
+            return { x, y };
+        }
+
+        mn::Math::Vec3f octDecode(float x, float y)
+        {
+            using namespace mn;
+
+            const float z = 1.f - std::abs(x) - std::abs(y);
+            if (z < 0.f)
+            {
+                const float fx = (1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f);
+                const float fy = (1.f - std::abs(x)) * (y >= 0.f ? 1.f : -1.f);
+                x = fx;
+                y = fy;
+            }
+            return Math::normalized(Math::Vec3f{ x, y, z });
+        }
+    }
+
+    std::vector<PackedVertex> packVertices(std::span<const mn::Graphics::Mesh::Vertex> vertices, const BoundingBox& bounds)
+    {
+        using namespace mn;
+
+        std::vector<PackedVertex> packed(vertices.size());
+        for (std::size_t i = 0; i < vertices.size(); i++)
+        {
+            const auto& vertex = vertices[i];
+            const auto normal  = octEncode(vertex.normal);
+
+            packed[i] = PackedVertex{
+                .position_xy = pack2x16(
+                    meshopt_quantizeUnorm(normalize(Math::x(vertex.position), Math::x(bounds.min), Math::x(bounds.max)), 16),
+                    meshopt_quantizeUnorm(normalize(Math::y(vertex.position), Math::y(bounds.min), Math::y(bounds.max)), 16)),
+                .position_z  = pack2x16(
+                    meshopt_quantizeUnorm(normalize(Math::z(vertex.position), Math::z(bounds.min), Math::z(bounds.max)), 16), 0),
+                .normal      = pack2x16(meshopt_quantizeSnorm(Math::x(normal), 16), meshopt_quantizeSnorm(Math::y(normal), 16)),
+                .tex_coords  = pack2x16(meshopt_quantizeHalf(Math::x(vertex.tex_coords)), meshopt_quantizeHalf(Math::y(vertex.tex_coords)))
+            };
+        }
+
+        return packed;
+    }
+
+    std::vector<mn::Graphics::Mesh::Vertex> unpackVertices(std::span<const PackedVertex> vertices, const BoundingBox& bounds)
+    {
+        using namespace mn;
+
+        const auto extent = bounds.max - bounds.min;
+        const auto unorm  = [](uint32_t packed, int half) { return static_cast<float>(unpack16(packed, half)) / 65535.f; };
+
+        std::vector<Graphics::Mesh::Vertex> unpacked(vertices.size());
+        for (std::size_t i = 0; i < vertices.size(); i++)
+        {
+            const auto& vertex = vertices[i];
+            auto& out = unpacked[i];
+
+            out.position = bounds.min + Math::Vec3f{
+                unorm(vertex.position_xy, 0) * Math::x(extent),
+                unorm(vertex.position_xy, 1) * Math::y(extent),
+                unorm(vertex.position_z,  0) * Math::z(extent)
+            };
+            out.normal     = octDecode(snorm16(vertex.normal, 0), snorm16(vertex.normal, 1));
+            out.color      = { 1.f, 1.f, 1.f, 1.f };
+            out.tex_coords = { halfToFloat(vertex.tex_coords, 0), halfToFloat(vertex.tex_coords, 1) };
+        }
+
+        return unpacked;
+    }
+
+    uint32_t packColor(const mn::Math::Vec4f& color)
+    {
+        using namespace mn;
+
+        const auto channel = [](float c) { return static_cast<uint32_t>(std::lround(std::clamp(c, 0.f, 1.f) * 255.f)); };
+        return channel(Math::x(color)) | (channel(Math::y(color)) << 8) | (channel(Math::z(color)) << 16) | (channel(Math::w(color)) << 24);
+    }
+
+    std::vector<uint32_t> packColors(std::span<const mn::Graphics::Mesh::Vertex> vertices)
+    {
+        std::vector<uint32_t> colors;
+        if (vertices.empty()) return colors;
+
+        const auto first = packColor(vertices[0].color);
+        const bool constant = std::all_of(vertices.begin(), vertices.end(),
+            [first](const auto& vertex) { return packColor(vertex.color) == first; });
+        if (constant) return colors;
+
+        colors.resize(vertices.size());
+        std::transform(vertices.begin(), vertices.end(), colors.begin(), [](const auto& vertex) { return packColor(vertex.color); });
+        return colors;
+    }
+}
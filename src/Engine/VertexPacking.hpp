@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Model.hpp"
+#include "Systems/ShaderTypes.hpp"
+
+#include <span>
+#include <vector>
+
+namespace Engine
+{
+    using PackedVertex = System::GLSL::PackedVertex;
+
+    // Compresses vertices into the geometry pool's layout (see shared.glsl). Positions are
+    // stored relative to bounds, which has to contain every vertex and is what the renderer
+    // hands the vertex shader to dequantize them
+    std::vector<PackedVertex> packVertices(std::span<const mn::Graphics::Mesh::Vertex> vertices, const BoundingBox& bounds);
+
+    // The way back, for CPU work on meshes already in the pool. Colours come out white, they
+    // live in their own stream
+    std::vector<mn::Graphics::Mesh::Vertex> unpackVertices(std::span<const PackedVertex> vertices, const BoundingBox& bounds);
+
+    // RGBA8, same as packUnorm4x8 in GLSL
+    uint32_t packColor(const mn::Math::Vec4f& color);
+
+    // The per-vertex colour stream, empty when every vertex has the same colour (the mesh's
+    // colour is then packColor of the first vertex)
+    std::vector<uint32_t> packColors(std::span<const mn::Graphics::Mesh::Vertex> vertices);
+}
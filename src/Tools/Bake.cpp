@@ -0,0 +1,211 @@
+// solder-bake: converts a directory tree of Assimp-readable models into baked .spm files
+//
+//   solder-bake <input dir> <output dir> [--jobs N] [--force]
+//
+// The output mirrors the input tree. Each file is imported and optimized exactly like
+// Model::loadFromFile does at runtime, just without a window or GPU, and with every LOD level
+// built up front (at runtime they're built on demand). Inputs whose contents and format version
+// match the manifest from the last run are skipped
+
+#include "../Engine/ModelFile.hpp"
+#include "../Util/Hash.hpp"
+#include "../Util/ThreadPool.hpp"
+
+#include <assimp/Importer.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    // Lives in the output directory, one "<hash> <version> <relative path>" line per input
+    constexpr const char* ManifestName = "bake-manifest.txt";
+
+    struct ManifestEntry
+    {
+        uint64_t hash;
+        uint32_t version;
+    };
+
+    std::unordered_map<std::string, ManifestEntry> readManifest(const fs::path& path)
+    {
+        std::unordered_map<std::string, ManifestEntry> manifest;
+        std::ifstream file(path);
+
+        ManifestEntry entry;
+        std::string name;
+        while (file >> std::hex >> entry.hash >> std::dec >> entry.version && std::getline(file >> std::ws, name))
+            manifest[name] = entry;
+        return manifest;
+    }
+
+    bool writeManifest(const fs::path& path, const std::unordered_map<std::string, ManifestEntry>& manifest)
+    {
+        std::ofstream file(path, std::ios::trunc);
+        for (const auto& [ name, entry ] : manifest)
+            file << std::hex << entry.hash << std::dec << " " << entry.version << " " << name << "\n";
+        return static_cast<bool>(file);
+    }
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    int usage()
+    {
+        std::fprintf(stderr, "usage: solder-bake <input dir> <output dir> [--jobs N] [--force]\n");
+        return 2;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    using namespace Engine;
+
+    std::vector<std::string> positional;
+    std::size_t jobs = std::max(std::thread::hardware_concurrency(), 1U);
+    bool force = false;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--force") force = true;
+        else if (arg == "--jobs" && i + 1 < argc) jobs = std::max(std::stoul(argv[++i]), 1UL);
+        else if (arg.starts_with("--")) return usage();
+        else positional.push_back(arg);
+    }
+    if (positional.size() != 2) return usage();
+
+    const fs::path input  = positional[0];
+    const fs::path output = positional[1];
+    if (!fs::is_directory(input))
+    {
+        std::fprintf(stderr, "solder-bake: %s is not a directory\n", input.string().c_str());
+        return 2;
+    }
+    fs::create_directories(output);
+
+    // Anything Assimp can read, except files we baked ourselves
+    std::vector<fs::path> sources;
+    {
+        Assimp::Importer importer;
+        for (const auto& entry : fs::recursive_directory_iterator(input))
+            if (entry.is_regular_file() && !ModelFile::isBaked(entry.path()) && importer.IsExtensionSupported(entry.path().extension().string()))
+                sources.push_back(entry.path());
+    }
+    std::sort(sources.begin(), sources.end());
+
+    const auto manifest_path = output / ManifestName;
+    const auto old_manifest  = (force ? decltype(readManifest(manifest_path)){} : readManifest(manifest_path));
+
+    struct Result
+    {
+        enum { Baked, Skipped, Failed } status;
+        ManifestEntry manifest;
+        std::size_t meshes = 0, vertices = 0, indices = 0;
+        std::uintmax_t source_size = 0, baked_size = 0;
+        double import_ms = 0.0, write_ms = 0.0;
+    };
+    std::vector<Result> results(sources.size());
+
+    std::mutex print_mutex;
+    const auto start = std::chrono::steady_clock::now();
+
+    // One file per job, so each import stays on its own thread
+    Util::ThreadPool pool(std::min(jobs, std::max<std::size_t>(sources.size(), 1)));
+    pool.parallel_for(sources.size(),
+        [&](std::size_t i, std::size_t)
+        {
+            const auto& source  = sources[i];
+            const auto relative = fs::relative(source, input);
+            auto target = output / relative;
+            target.replace_extension(ModelFile::Extension);
+
+            auto& result = results[i];
+            result.manifest    = ManifestEntry{ .hash = Util::hashFile(source), .version = ModelFile::Version };
+            result.source_size = fs::file_size(source);
+
+            const auto old = old_manifest.find(relative.generic_string());
+            if (old != old_manifest.end() && old->second.hash == result.manifest.hash && old->second.version == result.manifest.version && fs::exists(target))
+            {
+                result.status = Result::Skipped;
+                return;
+            }
+
+            const auto import_start = std::chrono::steady_clock::now();
+            auto meshes = ModelFile::import(source, 1, LodSettings{});
+            result.import_ms = millisecondsSince(import_start);
+
+            if (!meshes)
+            {
+                result.status = Result::Failed;
+                std::lock_guard lock(print_mutex);
+                std::fprintf(stderr, "%s: import failed\n", relative.string().c_str());
+                return;
+            }
+
+            // Material paths are relative to the model, which now lives somewhere else
+            for (auto& mesh : *meshes)
+            {
+                if (mesh.material.diffuse.empty()) continue;
+                const auto texture = source.parent_path() / mesh.material.diffuse;
+                mesh.material.diffuse = fs::relative(texture, fs::absolute(target).parent_path()).generic_string();
+            }
+
+            const auto write_start = std::chrono::steady_clock::now();
+            fs::create_directories(target.parent_path());
+            const bool written = ModelFile::write(target, *meshes);
+            result.write_ms = millisecondsSince(write_start);
+
+            result.status = (written ? Result::Baked : Result::Failed);
+            result.meshes = meshes->size();
+            for (const auto& mesh : *meshes)
+            {
+                result.vertices += mesh.vertices.size();
+                result.indices  += mesh.indices.size();
+            }
+            if (written) result.baked_size = fs::file_size(target);
+
+            std::lock_guard lock(print_mutex);
+            if (!written)
+                std::fprintf(stderr, "%s: could not write %s\n", relative.string().c_str(), target.string().c_str());
+            else
+                std::printf("%-48s %4zu meshes %9zu verts %10zu indices  %8ju kB -> %8ju kB  import %8.1f ms  write %6.1f ms\n",
+                    relative.string().c_str(), result.meshes, result.vertices, result.indices,
+                    result.source_size / 1024, result.baked_size / 1024, result.import_ms, result.write_ms);
+        });
+
+    // Failed inputs are left out so they get another go next time
+    auto manifest = old_manifest;
+    std::size_t baked = 0, skipped = 0, failed = 0;
+    std::uintmax_t source_total = 0, baked_total = 0;
+    for (std::size_t i = 0; i < sources.size(); i++)
+    {
+        const auto name = fs::relative(sources[i], input).generic_string();
+        switch (results[i].status)
+        {
+        case Result::Baked:   baked++;   manifest[name] = results[i].manifest; break;
+        case Result::Skipped: skipped++; break;
+        case Result::Failed:  failed++;  manifest.erase(name); break;
+        }
+        source_total += results[i].source_size;
+        baked_total  += results[i].baked_size;
+    }
+
+    if (!writeManifest(manifest_path, manifest))
+        std::fprintf(stderr, "solder-bake: could not write %s\n", manifest_path.string().c_str());
+
+    std::printf("\n%zu baked, %zu up to date, %zu failed in %.1f ms (%ju kB of sources, %ju kB baked this run)\n",
+        baked, skipped, failed, millisecondsSince(start), source_total / 1024, baked_total / 1024);
+
+    return (failed ? 1 : 0);
+}
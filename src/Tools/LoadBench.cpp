@@ -0,0 +1,106 @@
+// solder-load-bench: how long a model takes to load from its source file against its baked file
+//
+//   solder-load-bench <model> [--runs N]
+//
+// The source goes through ModelFile::import like Model::loadFromFile does for anything that isn't
+// baked. The baked file is written once up front (to the system temp directory, with every LOD level
+// like solder-bake does) and then mapped, read and copied out as the geometry pool would. No GPU
+// involved on either side, the upload costs the same for both
+
+#include "../Engine/ModelFile.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double median(std::vector<double> times)
+    {
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+
+    int usage()
+    {
+        std::fprintf(stderr, "usage: solder-load-bench <model> [--runs N]\n");
+        return 2;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    using namespace Engine;
+
+    std::vector<std::string> positional;
+    std::size_t runs = 5;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc) runs = std::max(std::stoul(argv[++i]), 1UL);
+        else if (arg.starts_with("--")) return usage();
+        else positional.push_back(arg);
+    }
+    if (positional.size() != 1) return usage();
+
+    const fs::path source = positional[0];
+    const auto baked = fs::temp_directory_path() / ("solder-load-bench" + ModelFile::Extension.string());
+
+    {
+        const auto meshes = ModelFile::import(source, 0, LodSettings{});
+        if (!meshes || !ModelFile::write(baked, *meshes))
+        {
+            std::fprintf(stderr, "solder-load-bench: could not bake %s\n", source.string().c_str());
+            return 1;
+        }
+    }
+
+    std::vector<double> import_times, baked_times;
+    std::size_t vertices = 0, indices = 0;
+    for (std::size_t run = 0; run < runs; run++)
+    {
+        const auto import_start = std::chrono::steady_clock::now();
+        const auto imported = ModelFile::import(source);
+        import_times.push_back(millisecondsSince(import_start));
+
+        // Mapping is lazy, so the copy out is where the file actually gets read
+        const auto baked_start = std::chrono::steady_clock::now();
+        const Util::MappedFile file(baked);
+        const auto read = ModelFile::read(file);
+        if (!imported || !read)
+        {
+            std::fprintf(stderr, "solder-load-bench: loading failed\n");
+            fs::remove(baked);
+            return 1;
+        }
+
+        std::vector<ModelFile::Vertex> pool_vertices;
+        std::vector<uint32_t> pool_indices;
+        for (const auto& mesh : *read)
+        {
+            pool_vertices.insert(pool_vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+            pool_indices.insert(pool_indices.end(), mesh.indices.begin(), mesh.indices.end());
+        }
+        baked_times.push_back(millisecondsSince(baked_start));
+
+        vertices = pool_vertices.size();
+        indices  = pool_indices.size();
+    }
+
+    std::printf("%s: %zu verts, %zu indices (with LOD levels), %ju kB baked\n",
+        source.string().c_str(), vertices, indices, fs::file_size(baked) / 1024);
+    std::printf("  import %10.2f ms\n  baked  %10.2f ms  (%.1fx)\n",
+        median(import_times), median(baked_times), median(import_times) / std::max(median(baked_times), 1e-6));
+
+    fs::remove(baked);
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include "FrameArena.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+// Replacing the global operator new touches every binary that links this, so it takes
+// -DSOLDER_PROOF_COUNT_ALLOCATIONS=ON to turn it on
+#ifdef SOLDER_PROOF_COUNT_ALLOCATIONS
+namespace
+{
+    std::atomic<std::size_t> allocations{0};
+}
+
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+#endif
+
+namespace Util
+{
+    std::size_t allocationCount()
+    {
+#ifdef SOLDER_PROOF_COUNT_ALLOCATIONS
+        return allocations.load(std::memory_order_relaxed);
+#else
+        return 0;
+#endif
+    }
+
+    FrameArena::FrameArena(std::size_t initial_size) :
+        buffer(initial_size)
+    {   }
+
+    FrameArena::~FrameArena()
+    {
+        for (const auto& spill : spills)
+            ::operator delete(spill.ptr, std::align_val_t(spill.alignment));
+    }
+
+    void FrameArena::reset()
+    {
+        for (const auto& spill : spills)
+            ::operator delete(spill.ptr, std::align_val_t(spill.alignment));
+        spills.clear();
+
+        // Everything from last frame has to fit in one buffer next time around
+        resized = (spilled > 0);
+        if (resized)
+            buffer.resize(std::max(buffer.size() * 2, (offset + spilled) * 2));
+
+        offset  = 0;
+        spilled = 0;
+    }
+
+    void* FrameArena::do_allocate(std::size_t bytes, std::size_t alignment)
+    {
+        void* ptr = buffer.data() + offset;
+        std::size_t space = buffer.size() - offset;
+        if (std::align(alignment, bytes, ptr, space))
+        {
+            offset = buffer.size() - space + bytes;
+            return ptr;
+        }
+
+        spilled += bytes + alignment;
+        auto* spill = ::operator new(bytes, std::align_val_t(alignment));
+        spills.push_back(Spill{ .ptr = spill, .alignment = alignment });
+        return spill;
+    }
+}
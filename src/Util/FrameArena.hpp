@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace Util
+{
+    // Bump allocator for containers that only live for one frame. Nothing is freed
+    // until reset(), which hands everything back at once. Requests that do not fit
+    // spill over to the heap, and the next reset() grows the buffer so they fit next time
+    struct FrameArena : std::pmr::memory_resource
+    {
+        FrameArena(std::size_t initial_size = 1 << 20);
+        FrameArena(const FrameArena&) = delete;
+        ~FrameArena();
+
+        void reset();
+
+        std::size_t used()     const { return offset + spilled; }
+        std::size_t capacity() const { return buffer.size(); }
+
+        // True if the previous reset() had to grow the buffer or anything spilled since
+        bool grew() const { return resized || spilled; }
+
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void  do_deallocate(void*, std::size_t, std::size_t) override { }
+        bool  do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+        std::vector<std::byte> buffer;
+        std::size_t offset = 0, spilled = 0;
+        bool resized = false;
+
+        struct Spill
+        {
+            void* ptr;
+            std::size_t alignment;
+        };
+
+        std::vector<Spill> spills;
+    };
+
+    // Number of calls made to the global operator new so far. Only tracked when built with
+    // SOLDER_PROOF_COUNT_ALLOCATIONS, always 0 otherwise
+    std::size_t allocationCount();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+
+namespace Util
+{
+    // 64-bit FNV-1a. Good enough to spot changed or duplicate files, not for anything adversarial
+    constexpr uint64_t FNVOffset = 14695981039346656037ULL;
+
+    inline uint64_t fnv1a(const void* data, std::size_t size, uint64_t hash = FNVOffset)
+    {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        for (std::size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    // Over the whole file, 0 if it can't be read
+    inline uint64_t hashFile(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return 0;
+
+        uint64_t hash = FNVOffset;
+        char buffer[1 << 16];
+        while (file)
+        {
+            file.read(buffer, sizeof(buffer));
+            hash = fnv1a(buffer, static_cast<std::size_t>(file.gcount()), hash);
+        }
+        return hash;
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace Util
+{
+    // Read-only memory mapping of a whole file, unmapped on destruction. Empty if the file
+    // couldn't be opened
+    struct MappedFile
+    {
+        MappedFile() = default;
+        MappedFile(const std::filesystem::path& path);
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        ~MappedFile();
+
+        explicit operator bool() const { return _data != nullptr; }
+
+        std::span<const std::byte> bytes() const { return { static_cast<const std::byte*>(_data), _size }; }
+
+    private:
+        void close();
+
+        void* _data = nullptr;
+        std::size_t _size = 0;
+#ifdef _WIN32
+        void* _mapping = nullptr;
+#endif
+    };
+}
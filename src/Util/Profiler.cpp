@@ -1,5 +1,6 @@
 #include "Profiler.hpp"
 
+#include <algorithm>
 #include <numeric>
 #include <iostream>
 
@@ -14,39 +15,47 @@ namespace Util
         // accrue the duration values until you hit an instance that is
         // beyond over_last_sec
         // take the average and return
-        const auto now = high_resolution_clock::now();
-        std::vector<double> runtime;
+        const auto now = steady_clock::now();
 
-        for (auto it = runs.end(); it != runs.begin(); it--)
+        double total = 0.0;
+        std::size_t count = 0;
+        for (std::size_t i = 1; i <= std::min(next, MaxRuns); i++)
         {
-            if (it == runs.end()) continue;
+            const auto& run = runs[(next - i) % MaxRuns];
 
-            const auto secs_ago = duration<double, seconds::period>( now - it->second.timestamp );
+            const auto secs_ago = duration<double, seconds::period>( now - run.timestamp );
             if (secs_ago.count() > over_last_sec) break;
 
-            if (it->second.completion)
+            if (run.completion)
             {
-                const auto exec_time = duration<double, milliseconds::period>( *it->second.completion - it->second.timestamp );
-                runtime.push_back(exec_time.count());
+                total += duration<double, milliseconds::period>( *run.completion - run.timestamp ).count();
+                count++;
             }
         }
 
-        double total = 0.0;
-        for (const auto& d : runtime) total += d;
-        return total / (double)runtime.size();
+        return total / (double)count;
     }
 
     std::size_t Profiler::beginBlock(const std::string& name)
     {
         static std::size_t id = 0;
         if (!data.count(name)) data[name] = std::make_shared<BlockData>(BlockData());
-        data[name]->runs[id] = BlockData::Run{ .timestamp = std::chrono::high_resolution_clock::now() };
+        auto& block = *data[name];
+        block.runs[block.next++ % BlockData::MaxRuns] = BlockData::Run{ .id = id, .timestamp = std::chrono::steady_clock::now() };
         return id++;
     }   
 
     void Profiler::endBlock(std::size_t id, const std::string& name)
     {
-        data[name]->runs[id].completion = std::chrono::high_resolution_clock::now();
+        // The run being closed is almost always the latest one for its block
+        auto& block = *data[name];
+        for (std::size_t i = 1; i <= std::min(block.next, BlockData::MaxRuns); i++)
+        {
+            auto& run = block.runs[(block.next - i) % BlockData::MaxRuns];
+            if (run.id != id) continue;
+            run.completion = std::chrono::steady_clock::now();
+            return;
+        }
     }
 
     std::shared_ptr<Profiler::BlockData>
@@ -2,6 +2,8 @@
 
 #include <string>
 #include <map>
+#include <memory>
+#include <optional>
 #include <unordered_map>
 #include <vector>
 
@@ -15,13 +17,18 @@ namespace Util
         {
             struct Run
             {
+                std::size_t id;
                 std::chrono::steady_clock::time_point timestamp;
                 std::optional<std::chrono::steady_clock::time_point> completion;
             };
 
+            // Only the most recent runs are kept, so recording a block never allocates
+            static constexpr std::size_t MaxRuns = 4096;
+
             double getAverageRuntime(double over_last_sec = 1.0);
 
-            std::map<std::size_t, Run> runs;
+            std::vector<Run> runs = std::vector<Run>(MaxRuns);
+            std::size_t next = 0;
         };
         
 
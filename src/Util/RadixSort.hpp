@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace Util
+{
+    // Stable LSD radix sort on the low key_bits of key(item), 8 bits per pass. scratch must
+    // hold at least as many items as items, and the sorted result always ends up in items
+    template<typename T, typename K>
+    void radixSort(std::span<T> items, std::span<T> scratch, uint32_t key_bits, const K& key)
+    {
+        // Not worth building histograms for a handful of items. Insertion sort is stable too, and unlike
+        // std::stable_sort it never asks the heap for a buffer
+        if (items.size() < 64)
+        {
+            for (std::size_t i = 1; i < items.size(); i++)
+            {
+                T item = items[i];
+                const auto k = key(item);
+
+                std::size_t j = i;
+                for (; j > 0 && k < key(items[j - 1]); j--) items[j] = items[j - 1];
+                items[j] = item;
+            }
+            return;
+        }
+
+        T* src = items.data();
+        T* dst = scratch.data();
+
+        std::array<uint32_t, 256> counts;
+        for (uint32_t shift = 0; shift < key_bits; shift += 8)
+        {
+            counts.fill(0);
+            for (std::size_t i = 0; i < items.size(); i++)
+                counts[(key(src[i]) >> shift) & 0xFF]++;
+
+            // Everything landed in the same bucket, this pass wouldn't move anything
+            if (std::find(counts.begin(), counts.end(), items.size()) != counts.end()) continue;
+
+            uint32_t offset = 0;
+            for (auto& count : counts)
+            {
+                const auto c = count;
+                count  = offset;
+                offset += c;
+            }
+
+            for (std::size_t i = 0; i < items.size(); i++)
+                dst[counts[(key(src[i]) >> shift) & 0xFF]++] = src[i];
+
+            std::swap(src, dst);
+        }
+
+        if (src != items.data())
+            std::copy(src, src + items.size(), items.data());
+    }
+}
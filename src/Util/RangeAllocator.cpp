@@ -0,0 +1,115 @@
+#include "RangeAllocator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+namespace Util
+{
+    RangeAllocator::RangeAllocator(std::size_t capacity)
+    {
+        grow(capacity);
+    }
+
+    std::optional<std::size_t> RangeAllocator::allocate(std::size_t count)
+    {
+        if (!count) return 0;
+
+        for (auto it = free_blocks.begin(); it != free_blocks.end(); it++)
+        {
+            if (it->second < count) continue;
+
+            const auto [ offset, size ] = *it;
+            free_blocks.erase(it);
+            if (size > count) free_blocks.emplace(offset + count, size - count);
+
+            _used += count;
+            return offset;
+        }
+
+        return std::nullopt;
+    }
+
+    void RangeAllocator::free(std::size_t offset, std::size_t count)
+    {
+        if (!count) return;
+
+        assert(offset + count <= _capacity);
+        _used -= count;
+
+        auto next = free_blocks.lower_bound(offset);
+
+        // Merge with the block right after us
+        if (next != free_blocks.end() && offset + count == next->first)
+        {
+            count += next->second;
+            next = free_blocks.erase(next);
+        }
+
+        // And the one right before
+        if (next != free_blocks.begin())
+        {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset)
+            {
+                prev->second += count;
+                return;
+            }
+        }
+
+        free_blocks.emplace_hint(next, offset, count);
+    }
+
+    void RangeAllocator::retire(std::size_t offset, std::size_t count, std::size_t delay)
+    {
+        if (!count) return;
+
+        if (!delay)
+        {
+            free(offset, count);
+            return;
+        }
+
+        assert(offset + count <= _capacity);
+        retiring.push_back(Retired{ .offset = offset, .count = count, .frame = frame + delay });
+        _retired += count;
+    }
+
+    void RangeAllocator::nextFrame()
+    {
+        frame++;
+
+        const auto due = std::partition(retiring.begin(), retiring.end(), [this](const Retired& r) { return r.frame > frame; });
+        for (auto it = due; it != retiring.end(); it++)
+        {
+            free(it->offset, it->count);
+            _retired -= it->count;
+        }
+        retiring.erase(due, retiring.end());
+    }
+
+    void RangeAllocator::grow(std::size_t capacity)
+    {
+        if (capacity <= _capacity) return;
+
+        const auto old_capacity = _capacity;
+        _capacity = capacity;
+        _used    += capacity - old_capacity;
+        free(old_capacity, capacity - old_capacity);
+    }
+
+    std::size_t RangeAllocator::largestFree() const
+    {
+        std::size_t largest = 0;
+        for (const auto& [ offset, count ] : free_blocks)
+            largest = std::max(largest, count);
+        return largest;
+    }
+
+    float RangeAllocator::fragmentation() const
+    {
+        const auto free_total = _capacity - _used;
+        if (!free_total) return 0.f;
+        return 1.f - static_cast<float>(largestFree()) / static_cast<float>(free_total);
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace Util
+{
+    // First-fit suballocator over the elements [0, capacity()) of some buffer. It only does
+    // the bookkeeping, freed ranges get merged back into their free neighbours
+    struct RangeAllocator
+    {
+        RangeAllocator(std::size_t capacity = 0);
+
+        std::optional<std::size_t> allocate(std::size_t count);
+        void free(std::size_t offset, std::size_t count);
+
+        // Like free(), but the range stays taken until nextFrame() has been called delay more times.
+        // For ranges the GPU may still be reading from frames already submitted
+        void retire(std::size_t offset, std::size_t count, std::size_t delay);
+
+        // Frees whatever retire()d ranges are due
+        void nextFrame();
+
+        // Adds room at the end, existing ranges stay where they are
+        void grow(std::size_t capacity);
+
+        std::size_t capacity() const { return _capacity; }
+        // Retired ranges count as used until they're freed
+        std::size_t used()     const { return _used; }
+        std::size_t retired()  const { return _retired; }
+        std::size_t largestFree() const;
+
+        // 0 when all the free space is one block, approaching 1 as it gets split up
+        float fragmentation() const;
+
+    private:
+        // offset -> count
+        std::map<std::size_t, std::size_t> free_blocks;
+        std::size_t _capacity = 0, _used = 0;
+
+        struct Retired
+        {
+            std::size_t offset, count;
+            // The frame it gets freed on
+            std::size_t frame;
+        };
+
+        std::vector<Retired> retiring;
+        std::size_t frame = 0, _retired = 0;
+    };
+}
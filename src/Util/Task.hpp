@@ -0,0 +1,22 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+
+namespace Util
+{
+    // Fire-and-forget coroutine. It starts running right away and frees itself when it
+    // finishes, meant for scene code that co_awaits resource loads. co_await on a load that failed
+    // throws, and an exception the coroutine doesn't catch ends the program
+    struct Task
+    {
+        struct promise_type
+        {
+            Task get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() { }
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+}
@@ -0,0 +1,66 @@
+#include "TaskQueue.hpp"
+
+namespace Util
+{
+    TaskQueue::TaskQueue(std::size_t thread_count)
+    {
+        for (std::size_t i = 0; i < thread_count; i++)
+            threads.emplace_back([this]() { work(); });
+    }
+
+    TaskQueue::~TaskQueue()
+    {
+        {
+            std::lock_guard lock(mutex);
+            stop = true;
+            jobs.clear();
+        }
+        cv.notify_all();
+
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    void TaskQueue::push(std::function<void()> job)
+    {
+        if (threads.empty())
+        {
+            job();
+            return;
+        }
+
+        {
+            std::lock_guard lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        cv.notify_one();
+    }
+
+    std::size_t TaskQueue::pending() const
+    {
+        std::lock_guard lock(mutex);
+        return jobs.size() + running;
+    }
+
+    void TaskQueue::work()
+    {
+        while (true)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock lock(mutex);
+                cv.wait(lock, [this]() { return stop || !jobs.empty(); });
+                if (stop) return;
+
+                job = std::move(jobs.front());
+                jobs.pop_front();
+                running++;
+            }
+
+            job();
+
+            std::lock_guard lock(mutex);
+            running--;
+        }
+    }
+}
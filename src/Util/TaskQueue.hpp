@@ -0,0 +1,41 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Util
+{
+    // Background worker threads pulling fire-and-forget jobs off a FIFO. Unlike ThreadPool
+    // nothing waits on the jobs, so they have to report back on their own. With no threads
+    // push() just runs the job on the calling thread
+    struct TaskQueue
+    {
+        TaskQueue(std::size_t thread_count);
+        TaskQueue(const TaskQueue&) = delete;
+
+        // Jobs still sitting in the queue are dropped, running ones are finished first
+        ~TaskQueue();
+
+        void push(std::function<void()> job);
+
+        std::size_t size() const { return threads.size(); }
+
+        // Queued plus running
+        std::size_t pending() const;
+
+    private:
+        void work();
+
+        std::vector<std::thread> threads;
+
+        mutable std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::function<void()>> jobs;
+        std::size_t running = 0;
+        bool stop = false;
+    };
+}
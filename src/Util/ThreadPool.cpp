@@ -0,0 +1,76 @@
+#include "ThreadPool.hpp"
+
+namespace Util
+{
+    ThreadPool::ThreadPool(std::size_t thread_count)
+    {
+        for (std::size_t i = 1; i < thread_count; i++)
+            threads.emplace_back([this, i]() { work(i); });
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard lock(mutex);
+            stop = true;
+        }
+        start_cv.notify_all();
+
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    void ThreadPool::run(std::size_t count, Job job, const void* context)
+    {
+        if (!count) return;
+
+        // Not worth waking anyone up for a single item
+        if (threads.empty() || count == 1)
+        {
+            for (std::size_t i = 0; i < count; i++) job(context, i, 0);
+            return;
+        }
+
+        {
+            std::lock_guard lock(mutex);
+            this->job     = job;
+            this->context = context;
+            this->count   = count;
+            next   = 0;
+            active = threads.size();
+            generation++;
+        }
+        start_cv.notify_all();
+
+        drain(0);
+
+        // Every worker has to check in before the job can go out of scope
+        std::unique_lock lock(mutex);
+        done_cv.wait(lock, [this]() { return active == 0; });
+    }
+
+    void ThreadPool::work(std::size_t thread)
+    {
+        uint64_t seen = 0;
+        while (true)
+        {
+            {
+                std::unique_lock lock(mutex);
+                start_cv.wait(lock, [&]() { return stop || generation != seen; });
+                if (stop) return;
+                seen = generation;
+            }
+
+            drain(thread);
+
+            std::lock_guard lock(mutex);
+            if (--active == 0) done_cv.notify_one();
+        }
+    }
+
+    void ThreadPool::drain(std::size_t thread)
+    {
+        for (auto i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+            job(context, i, thread);
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Util
+{
+    // Fixed set of worker threads for fork/join style loops. The calling thread
+    // takes part in every loop, so a pool of size N owns N - 1 threads
+    struct ThreadPool
+    {
+        ThreadPool(std::size_t thread_count);
+        ThreadPool(const ThreadPool&) = delete;
+        ~ThreadPool();
+
+        std::size_t size() const { return threads.size() + 1; }
+
+        // Calls func(index, thread) for every index in [0, count) and blocks until all calls
+        // have returned. thread is in [0, size()) and is unique among concurrent calls
+        template<typename F>
+        void parallel_for(std::size_t count, const F& func)
+        {
+            run(count, [](const void* f, std::size_t index, std::size_t thread)
+                { (*static_cast<const F*>(f))(index, thread); }, &func);
+        }
+
+    private:
+        using Job = void(*)(const void*, std::size_t, std::size_t);
+
+        void run(std::size_t count, Job job, const void* context);
+        void work(std::size_t thread);
+        void drain(std::size_t thread);
+
+        std::vector<std::thread> threads;
+
+        std::mutex mutex;
+        std::condition_variable start_cv, done_cv;
+
+        Job job = nullptr;
+        const void* context = nullptr;
+        std::size_t count = 0, active = 0;
+        std::atomic<std::size_t> next;
+        uint64_t generation = 0;
+        bool stop = false;
+    };
+}
@@ -0,0 +1,144 @@
+#include "Test.hpp"
+#include "Frustum.hpp"
+
+#include "Engine/Systems/Bvh.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <random>
+#include <vector>
+
+// Bvh::query against CullingStage::cull over every box, through random inserts, removals, moves
+// and rebuilds. The walk has to find exactly the items the brute force test keeps, no more and no fewer
+
+using namespace Engine;
+using namespace Engine::System;
+using namespace mn;
+
+int main()
+{
+    std::mt19937 rng(23);
+    std::uniform_real_distribution<float> coordinate(-150.f, 150.f), extent(0.05f, 12.f), nudge(-2.f, 2.f), unit(-1.f, 1.f), chance(0.f, 1.f);
+
+    const auto randomBox = [&]()
+    {
+        const Math::Vec3f center{ coordinate(rng), coordinate(rng), coordinate(rng) };
+        const Math::Vec3f half{ extent(rng), extent(rng), extent(rng) };
+        return BoundingBox{ center - half, center + half };
+    };
+
+    Bvh bvh;
+    std::vector<std::optional<BoundingBox>> boxes;
+    std::vector<uint32_t> leaves, live;
+
+    std::vector<uint32_t> found, expected;
+    std::vector<std::pair<uint32_t, uint32_t>> stack;
+
+    // Nothing in it, nothing found
+    {
+        const auto frustum = Test::makeFrustum(Math::Vec3f{ 0.f, 0.f, 0.f }, Math::Vec3f{ 0.f, 0.f, -1.f }, 1.2f, 1.f, 0.1f, 300.f);
+        CHECK(bvh.query(frustum, found, stack) == 0 && found.empty());
+    }
+
+    std::size_t queries = 0, mismatches = 0, duplicates = 0, visible = 0, total = 0;
+    for (int step = 0; step < 6000; step++)
+    {
+        const float roll = chance(rng);
+        if (live.empty() || roll < 0.4f)
+        {
+            const auto item = static_cast<uint32_t>(boxes.size());
+            boxes.push_back(randomBox());
+            leaves.push_back(bvh.insert(item, *boxes.back()));
+            live.push_back(item);
+        }
+        else if (roll < 0.55f)
+        {
+            const auto at = std::uniform_int_distribution<std::size_t>(0, live.size() - 1)(rng);
+            const auto item = live[at];
+            bvh.remove(leaves[item]);
+            boxes[item].reset();
+            live[at] = live.back();
+            live.pop_back();
+        }
+        else if (roll < 0.995f)
+        {
+            // Mostly small moves like an animated instance makes, sometimes a jump across the scene,
+            // sometimes the same box again
+            const auto item = live[std::uniform_int_distribution<std::size_t>(0, live.size() - 1)(rng)];
+            auto box = *boxes[item];
+            const float kind = chance(rng);
+            if (kind < 0.7f)
+            {
+                const Math::Vec3f offset{ nudge(rng), nudge(rng), nudge(rng) };
+                box = BoundingBox{ box.min + offset, box.max + offset };
+            }
+            else if (kind < 0.9f)
+                box = randomBox();
+
+            const bool moved = bvh.update(leaves[item], box);
+            CHECK(moved == (kind < 0.9f));
+            boxes[item] = box;
+        }
+        else
+        {
+            bvh.rebuild();
+            CHECK(bvh.degradation() <= 1.001f);
+        }
+
+        CHECK(bvh.size() == live.size());
+        if (step % 25) continue;
+
+        // A camera somewhere in the scene, sometimes parked inside one of the boxes
+        Math::Vec3f position{ coordinate(rng) * 0.5f, coordinate(rng) * 0.5f, coordinate(rng) * 0.5f };
+        if (!live.empty() && chance(rng) < 0.2f)
+        {
+            const auto& box = *boxes[live[std::uniform_int_distribution<std::size_t>(0, live.size() - 1)(rng)]];
+            position = (box.min + box.max) * 0.5f;
+        }
+
+        Math::Vec3f forward{ unit(rng), unit(rng) * 0.5f, unit(rng) };
+        if (Math::length(forward) < 0.1f) forward = Math::Vec3f{ 0.f, 0.f, -1.f };
+        const auto frustum = Test::makeFrustum(position, Math::normalized(forward), 1.2f, 16.f / 9.f, 0.1f, 200.f);
+
+        found.clear();
+        bvh.query(frustum, found, stack);
+
+        expected.clear();
+        for (const auto item : live)
+            if (!CullingStage::cull(frustum, *boxes[item]))
+                expected.push_back(item);
+
+        std::sort(found.begin(), found.end());
+        std::sort(expected.begin(), expected.end());
+        duplicates += (std::adjacent_find(found.begin(), found.end()) != found.end());
+        mismatches += (found != expected);
+        visible += expected.size();
+        total   += live.size();
+        queries++;
+    }
+
+    CHECK(mismatches == 0);
+    CHECK(duplicates == 0);
+
+    // Some of each, or the scenes aren't testing much
+    CHECK(queries > 100 && visible > 0 && visible < total);
+
+    // Emptied out one at a time, then filled again
+    for (const auto item : live) bvh.remove(leaves[item]);
+    CHECK(bvh.size() == 0);
+    {
+        const auto frustum = Test::makeFrustum(Math::Vec3f{ 0.f, 0.f, 0.f }, Math::Vec3f{ 0.f, 0.f, -1.f }, 1.2f, 1.f, 0.1f, 300.f);
+        found.clear();
+        CHECK(bvh.query(frustum, found, stack) == 0 && found.empty());
+
+        // Around the camera, which is never culled
+        const BoundingBox around{ Math::Vec3f{ -1.f, -1.f, -1.f }, Math::Vec3f{ 1.f, 1.f, 1.f } };
+        bvh.insert(7, around);
+        bvh.rebuild();
+        found.clear();
+        bvh.query(frustum, found, stack);
+        CHECK(found.size() == 1 && found[0] == 7);
+    }
+
+    return Test::finish();
+}
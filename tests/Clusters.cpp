@@ -0,0 +1,132 @@
+#include "Test.hpp"
+
+#include "Engine/Systems/Clusters.hpp"
+
+#include <cmath>
+#include <random>
+
+// LightClusters: every light that reaches a point in the frustum is listed in that point's cluster,
+// lights behind or right in front of the camera included, and the AVX2 batches bin exactly like the
+// scalar loop. CMake builds this once more for AVX2
+
+using namespace Engine;
+using namespace Engine::System;
+using namespace mn;
+
+namespace
+{
+    bool same(const LightClusters& a, const LightClusters& b)
+    {
+        const auto ca = a.clusters(), cb = b.clusters();
+        const auto ia = a.indices(),  ib = b.indices();
+        if (ca.size() != cb.size() || ia.size() != ib.size() || a.visible() != b.visible()) return false;
+
+        for (std::size_t i = 0; i < ca.size(); i++)
+            if (ca[i].offset != cb[i].offset || ca[i].count != cb[i].count) return false;
+
+        return std::equal(ia.begin(), ia.end(), ib.begin());
+    }
+}
+
+int main()
+{
+#if defined(__AVX2__)
+    if (!__builtin_cpu_supports("avx2")) return Test::Skip;
+#endif
+
+    const Math::Vec2f near_far{ 0.5f, 200.f };
+    const LightClusters::Dimensions dims{ 16, 9, 24 };
+    const auto view_projection = Math::perspective(16.f / 9.f, Math::Angle::degrees(60), near_far);
+
+    // The camera sits at the origin. Points in the frustum come from a ray through the screen,
+    // pushed out to the clip w they should have
+    const auto clip_w = [&](const Math::Vec3f& p) { return Math::w(view_projection * Math::Vec4f{ Math::x(p), Math::y(p), Math::z(p), 1.f }); };
+    const auto unproject = Math::inv(view_projection);
+    const auto point = [&](float ndc_x, float ndc_y, float w)
+    {
+        const auto far = unproject * Math::Vec4f{ ndc_x, ndc_y, 0.5f, 1.f };
+        auto ray = Math::xyz(far) * (1.f / Math::w(far));
+        return ray * (w / clip_w(ray));
+    };
+    const auto ahead = Math::normalized(point(0.f, 0.f, 1.f));
+
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<float> unit(-1.f, 1.f), depth(0.f, 1.f), range(0.5f, 25.f);
+
+    LightClusters batched, scalar;
+    std::vector<Math::Vec3f> positions;
+    std::vector<float> ranges;
+
+    for (int round = 0; round < 4; round++)
+    {
+        batched.setup(view_projection, near_far, dims);
+        scalar.setup(view_projection, near_far, dims);
+        positions.clear();
+        ranges.clear();
+
+        const auto add = [&](const Math::Vec3f& position, float r)
+        {
+            positions.push_back(position);
+            ranges.push_back(r);
+            batched.push(position, r);
+            scalar.push(position, r);
+        };
+
+        // Mostly in and around the frustum, some with the camera inside them, some behind the
+        // camera or between it and the near plane that only just reach in. An odd count so the
+        // last batch is partial
+        const std::size_t count = 501 + round * 13;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const float w = Math::x(near_far) + std::pow(depth(rng), 2.f) * (Math::y(near_far) - Math::x(near_far));
+            switch (i % 5)
+            {
+            case 0:
+                add(Math::Vec3f{ unit(rng), unit(rng), unit(rng) } * 2.f, range(rng));
+                break;
+            case 1:
+                add(ahead * (-1.f - depth(rng) * 10.f) + Math::Vec3f{ unit(rng), unit(rng), unit(rng) } * 3.f, 2.f + range(rng));
+                break;
+            case 2:
+                add(ahead * (depth(rng) * Math::x(near_far)) + Math::Vec3f{ unit(rng), unit(rng), 0.f } * 0.5f, 0.05f + depth(rng));
+                break;
+            default:
+                add(point(unit(rng) * 1.3f, unit(rng) * 1.3f, w), range(rng));
+                break;
+            }
+        }
+
+        batched.run();
+        scalar.run(true);
+        CHECK(same(batched, scalar));
+        CHECK(batched.visible() > 0 && batched.visible() < count);
+
+        // Every light reaching a point is in the point's cluster
+        const auto clusters = batched.clusters();
+        const auto indices  = batched.indices();
+        std::size_t missing = 0, found = 0;
+        for (int p = 0; p < 5000; p++)
+        {
+            const float ndc_x = unit(rng) * 0.999f, ndc_y = unit(rng) * 0.999f;
+            const float w = Math::x(near_far) * std::pow(Math::y(near_far) / Math::x(near_far), depth(rng));
+            const auto position = point(ndc_x, ndc_y, w);
+
+            const auto x = std::min(static_cast<uint32_t>((ndc_x * 0.5f + 0.5f) * dims.x), dims.x - 1);
+            const auto y = std::min(static_cast<uint32_t>((ndc_y * 0.5f + 0.5f) * dims.y), dims.y - 1);
+            const auto z = static_cast<uint32_t>(std::clamp(std::floor(std::log(w) * batched.sliceScale() + batched.sliceBias()), 0.f, float(dims.z - 1)));
+            const auto& cluster = clusters[x + y * dims.x + z * dims.x * dims.y];
+            const auto listed = indices.subspan(cluster.offset, cluster.count);
+
+            for (std::size_t l = 0; l < positions.size(); l++)
+            {
+                if (Math::length(position - positions[l]) > ranges[l] * 0.999f) continue;
+                found++;
+                missing += (std::find(listed.begin(), listed.end(), static_cast<uint32_t>(l)) == listed.end());
+            }
+        }
+        CHECK(found > 0);
+        CHECK(missing == 0);
+    }
+
+    return Test::finish();
+}
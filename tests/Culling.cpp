@@ -0,0 +1,108 @@
+#include "Test.hpp"
+#include "Frustum.hpp"
+
+#include "Engine/Systems/Culling.hpp"
+
+#include <cmath>
+#include <random>
+
+// CullingStage::run against the scalar CullingStage::cull, box by box. Which kernel run() uses
+// depends on how Culling.cpp was compiled, CMake builds this once per instruction set
+
+using namespace Engine;
+using namespace Engine::System;
+using namespace mn;
+
+int main()
+{
+#if defined(__AVX512F__)
+    if (!__builtin_cpu_supports("avx512f")) return Test::Skip;
+#elif defined(__AVX2__)
+    if (!__builtin_cpu_supports("avx2")) return Test::Skip;
+#endif
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> coordinate(-200.f, 200.f), extent(0.05f, 20.f), unit(-1.f, 1.f);
+
+    const auto identity = Math::Mat4<float>::identity();
+
+    CullingStage stage;
+    std::vector<BoundingBox> boxes;
+    std::vector<bool> forced;
+
+    for (int round = 0; round < 50; round++)
+    {
+        Math::Vec3f forward{ unit(rng), unit(rng) * 0.5f, unit(rng) };
+        if (Math::length(forward) < 0.1f) forward = Math::Vec3f{ 0.f, 0.f, -1.f };
+
+        const auto frustum = Test::makeFrustum(
+            Math::Vec3f{ coordinate(rng), coordinate(rng), coordinate(rng) } * 0.25f, Math::normalized(forward),
+            1.2f, 16.f / 9.f, 0.1f, 300.f);
+
+        // Odd counts so the last batch and the last mask word are partly padding
+        stage.clear();
+        boxes.clear();
+        forced.clear();
+
+        const std::size_t count = 1000 + round * 37;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            Math::Vec3f center{ coordinate(rng), coordinate(rng), coordinate(rng) };
+
+            // A third of the boxes sit right on one of the planes
+            if (i % 3 == 0)
+            {
+                const auto& plane = frustum.planes[i % 6];
+                center = center - Math::xyz(plane) * (Math::inner(Math::xyz(plane), center) + Math::w(plane));
+            }
+
+            const Math::Vec3f half{ extent(rng), extent(rng), extent(rng) };
+            boxes.push_back(BoundingBox{ center - half, center + half });
+            forced.push_back(i % 97 == 0);
+            stage.push(boxes.back(), identity, forced.back());
+        }
+
+        // A couple the camera is inside of or right next to
+        boxes.push_back(BoundingBox{ frustum.position - Math::Vec3f{ 1.f, 1.f, 1.f }, frustum.position + Math::Vec3f{ 1.f, 1.f, 1.f } });
+        forced.push_back(false);
+        stage.push(boxes.back(), identity);
+
+        boxes.push_back(BoundingBox{ frustum.position + Math::Vec3f{ 0.5f, 0.f, 0.f }, frustum.position + Math::Vec3f{ 3.f, 2.f, 2.f } });
+        forced.push_back(false);
+        stage.push(boxes.back(), identity);
+
+        const auto& mask = stage.run(frustum);
+        CHECK(mask.size() == (boxes.size() + 63) / 64);
+        CHECK(stage.size() == boxes.size());
+
+        std::size_t mismatches = 0, visible = 0;
+        for (std::size_t i = 0; i < boxes.size(); i++)
+        {
+            const bool expected = forced[i] || !CullingStage::cull(frustum, boxes[i]);
+            visible += expected;
+            mismatches += (stage.visible(i) != expected);
+        }
+        CHECK(mismatches == 0);
+
+        // Some of each, or the scene isn't testing much
+        CHECK(visible > 0 && visible < boxes.size());
+
+        // Nothing set past the last box
+        CHECK(!(boxes.size() % 64) || !(mask.back() >> (boxes.size() % 64)));
+    }
+
+    // An inner plane doesn't make a box visible by itself, this one is in front of the near
+    // plane and inside the sides but past the far plane
+    {
+        const auto frustum = Test::makeFrustum(Math::Vec3f{ 0.f, 0.f, 0.f }, Math::Vec3f{ 0.f, 0.f, -1.f }, 1.2f, 1.f, 0.1f, 100.f);
+        const BoundingBox far_away{ Math::Vec3f{ -1.f, -1.f, -150.f }, Math::Vec3f{ 1.f, 1.f, -120.f } };
+        CHECK(CullingStage::cull(frustum, far_away));
+
+        stage.clear();
+        stage.push(far_away, identity);
+        stage.run(frustum);
+        CHECK(!stage.visible(0));
+    }
+
+    return Test::finish();
+}
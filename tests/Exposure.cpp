@@ -0,0 +1,191 @@
+#include "Test.hpp"
+
+#include "Engine/Systems/Exposure.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// The CPU reference of the auto exposure passes: the histogram sorts every metered texel into its
+// bin, the reduction takes the geometric mean of what's lit between the two percentiles, and the
+// adaptation moves towards it at the configured rate
+
+using namespace Engine;
+using namespace Engine::System;
+using namespace mn;
+
+namespace
+{
+    constexpr auto Texels = GLSL::HistogramBins * GLSL::HistogramRows;
+
+    struct Image
+    {
+        uint32_t width, height;
+        std::vector<float> rgba;
+
+        Image(uint32_t width, uint32_t height, float grey) : width(width), height(height), rgba(std::size_t(width) * height * 4, grey) { }
+
+        void set(uint32_t x, uint32_t y, float grey)
+        {
+            for (int c = 0; c < 3; c++) rgba[(std::size_t(y) * width + x) * 4 + c] = grey;
+        }
+    };
+
+    ExposureState meter(const Image& image, const ExposureState& previous, float delta_time, const AutoExposure& settings)
+    {
+        std::vector<HistogramTexel> histogram(Texels);
+        meterHistogram(image.rgba, image.width, image.height, histogram, settings);
+        return adaptExposure(histogram, previous, delta_time, settings);
+    }
+
+    // The histogram is summed in order like the pass does, in floats that's a few parts in ten thousand
+    bool near(float a, float b)
+    {
+        return std::abs(a - b) <= 1e-3f * std::max(std::abs(a), std::abs(b));
+    }
+}
+
+int main()
+{
+    const AutoExposure settings;
+
+    // A grey frame settles right on its luminance the first time, whatever the size
+    for (const auto& [ width, height ] : { std::pair{ 256u, 256u }, std::pair{ 1000u, 563u }, std::pair{ 17u, 9u } })
+    {
+        const auto state = meter(Image(width, height, 0.18f), ExposureState{}, 0.f, settings);
+        CHECK(near(state.luminance, 0.18f));
+        CHECK(near(state.exposure, settings.key / 0.18f));
+    }
+
+    // Black pixels don't count, a frame with nothing lit keeps what it had
+    {
+        Image image(256, 256, 0.f);
+        const auto black = meter(image, ExposureState{ .luminance = 2.f, .exposure = 0.25f }, 0.1f, settings);
+        CHECK(black.luminance == 2.f && black.exposure == 0.25f);
+        CHECK(meter(image, ExposureState{}, 0.1f, settings).luminance == 0.f);
+
+        for (uint32_t y = 0; y < 256; y++)
+            for (uint32_t x = 0; x < 100; x++)
+                image.set(x, y, 0.5f);
+        CHECK(near(meter(image, ExposureState{}, 0.f, settings).luminance, 0.5f));
+    }
+
+    // Every metered texel lands in exactly one bin, and brighter never goes in a lower bin
+    {
+        Image image(300, 200, 0.f);
+        for (uint32_t y = 0; y < 200; y++)
+            for (uint32_t x = 0; x < 300; x++)
+                image.set(x, y, std::exp2(static_cast<float>(x) / 300.f * 16.f - 10.f));
+
+        std::vector<HistogramTexel> histogram(Texels);
+        meterHistogram(image.rgba, image.width, image.height, histogram, settings);
+
+        constexpr auto Size = GLSL::MeterSize, Bins = GLSL::HistogramBins;
+        bool rows = true;
+        float total = 0.f;
+        for (uint32_t row = 0; row < GLSL::HistogramRows; row++)
+        {
+            float in_row = 0.f;
+            for (uint32_t bin = 0; bin < Bins; bin++) in_row += histogram[bin + row * Bins].count;
+            rows &= (in_row == static_cast<float>(Size * Size / GLSL::HistogramRows));
+            total += in_row;
+        }
+        CHECK(rows);
+        CHECK(total == static_cast<float>(Size * Size));
+
+        // The darkest are in bin 0, the brightest are clamped into the last one
+        CHECK(histogram[0].count > 0.f && histogram[Bins - 1].count > 0.f);
+
+        bool ordered = true;
+        for (float grey = 1e-4f; grey < 1e4f; grey *= 1.01f)
+            ordered &= (histogramBin(meterColor(Math::Vec3f{ grey, grey, grey }, settings)) <= histogramBin(meterColor(Math::Vec3f{ grey * 1.01f, grey * 1.01f, grey * 1.01f }, settings)));
+        CHECK(ordered);
+
+        // A bin's mean stays inside the bin
+        bool inside = true;
+        for (uint32_t bin = 1; bin < Bins; bin++)
+            for (uint32_t row = 0; row < GLSL::HistogramRows; row++)
+            {
+                const auto& texel = histogram[bin + row * Bins];
+                if (texel.count > 0.f) inside &= (histogramBin(texel.mean) == bin);
+            }
+        CHECK(inside);
+    }
+
+    // The mean is taken in log space. 256 across lines every metered texel up with its own pixel, so
+    // with nothing clipped a quarter at 4 and the rest at 0.25 is exactly 2^(0.25 * 2 - 0.75 * 2)
+    {
+        auto unclipped = settings;
+        unclipped.low_percentile  = 0.f;
+        unclipped.high_percentile = 1.f;
+
+        Image image(256, 256, 0.25f);
+        for (uint32_t y = 0; y < 256; y++)
+            for (uint32_t x = 0; x < 64; x++)
+                image.set(x, y, 4.f);
+        CHECK(near(meter(image, ExposureState{}, 0.f, unclipped).luminance, 0.5f));
+
+        // Keeping the top half keeps a quarter of each, the bin at 0.25 is cut part way
+        auto top = settings;
+        top.low_percentile  = 0.5f;
+        top.high_percentile = 1.f;
+        CHECK(near(meter(image, ExposureState{}, 0.f, top).luminance, 1.f));
+    }
+
+    // A few very bright or very dark texels are clipped off and leave the rest alone. Without the
+    // clipping they pull it well away
+    {
+        auto unclipped = settings;
+        unclipped.low_percentile  = 0.f;
+        unclipped.high_percentile = 1.f;
+
+        for (const float outlier : { 1000.f, 0.006f })
+        {
+            Image image(256, 256, 0.18f);
+            for (uint32_t y = 0; y < 256; y++)
+                for (uint32_t x = 0; x < 10; x++)
+                    image.set(x, y, outlier);
+
+            CHECK(near(meter(image, ExposureState{}, 0.f, settings).luminance, 0.18f));
+            CHECK(std::abs(meter(image, ExposureState{}, 0.f, unclipped).luminance / 0.18f - 1.f) > 0.1f);
+        }
+    }
+
+    // Outside the metered range it's clamped to the ends
+    {
+        const float top = std::exp2(settings.min_log_luminance + settings.log_luminance_range);
+        CHECK(near(meter(Image(64, 64, top * 10.f), ExposureState{}, 0.f, settings).luminance, top));
+        CHECK(meterColor(Math::Vec3f{ 0.001f, 0.001f, 0.001f }, settings) < 0.f);
+        CHECK(meterColor(Math::Vec3f{ 1e6f, 1e6f, 1e6f }, settings) == 1.f);
+    }
+
+    // Going from bright to dark it moves 1 - e^(-dt * rate) of the way each frame, never overshoots,
+    // and gets there
+    {
+        const Image dark(128, 72, 0.05f);
+        ExposureState state{ .luminance = 1.f, .exposure = settings.key };
+
+        const float dt = 1.f / 60.f;
+        const auto next = meter(dark, state, dt, settings);
+        CHECK(near(next.luminance, 1.f + (0.05f - 1.f) * (1.f - std::exp(-dt * settings.adaptation_rate))));
+        CHECK(near(next.exposure, settings.key / next.luminance));
+
+        // No time passed, nothing moves
+        CHECK(meter(dark, state, 0.f, settings).luminance == 1.f);
+
+        std::vector<HistogramTexel> histogram(Texels);
+        meterHistogram(dark.rgba, dark.width, dark.height, histogram, settings);
+
+        bool monotonic = true;
+        for (int frame = 0; frame < 60 * 20; frame++)
+        {
+            const auto moved = adaptExposure(histogram, state, dt, settings);
+            monotonic &= (moved.luminance <= state.luminance && moved.luminance >= 0.05f * 0.999f);
+            state = moved;
+        }
+        CHECK(monotonic);
+        CHECK(std::abs(state.luminance - 0.05f) < 1e-3f);
+    }
+
+    return Test::finish();
+}
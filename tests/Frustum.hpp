@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Engine/Systems/Culling.hpp"
+
+#include <cmath>
+
+// Culling tests need frusta without a camera and a surface to build them from
+namespace Test
+{
+    // Same planes Frustum::fromCamera builds
+    inline Engine::System::Frustum makeFrustum(const mn::Math::Vec3f& position, const mn::Math::Vec3f& forward, float fov, float aspect, float near, float far)
+    {
+        using namespace mn;
+
+        const auto right = Math::normalized(Math::outer(forward, Math::Vec3f{ 0.f, 1.f, 0.f }));
+        const auto up    = Math::outer(right, forward);
+
+        const float near_height = 2.f * std::tan(fov / 2.f) * near;
+        const float near_width  = near_height * aspect;
+
+        const auto near_center = position + forward * near;
+        const auto far_center  = position + forward * far;
+
+        const auto plane = [](const Math::Vec3f& normal, const Math::Vec3f& point)
+        {
+            return Math::Vec4f{ Math::x(normal), Math::y(normal), Math::z(normal), -Math::inner(normal, point) };
+        };
+
+        Engine::System::Frustum frustum;
+        frustum.position = position;
+        frustum.near_distance = near;
+        frustum.planes[0] = plane(forward, near_center);
+        frustum.planes[1] = Math::Vec4f{ -Math::x(forward), -Math::y(forward), -Math::z(forward), Math::inner(forward, far_center) };
+        frustum.planes[2] = plane(Math::normalized(Math::outer(up, near_center - right * (near_width / 2.f) - position)), near_center);
+        frustum.planes[3] = plane(Math::normalized(Math::outer(near_center + right * (near_width / 2.f) - position, up)), near_center);
+        frustum.planes[4] = plane(Math::normalized(Math::outer(right, near_center + up * (near_height / 2.f) - position)), near_center);
+        frustum.planes[5] = plane(Math::normalized(Math::outer(near_center - up * (near_height / 2.f) - position, right)), near_center);
+        return frustum;
+    }
+}
@@ -0,0 +1,167 @@
+#include "Test.hpp"
+
+#include "Engine/InstancePacking.hpp"
+
+#include <array>
+#include <cmath>
+#include <random>
+
+// The quaternion an instance is uploaded with rotates vectors the same way the rotation matrix it
+// came from does, through every branch of the conversion, half turns included. Normals come out
+// perpendicular to the scaled surface and pointing out of it, mirrored or not
+
+using namespace Engine;
+using namespace mn;
+
+namespace
+{
+    constexpr float Pi = 3.14159265358979f;
+
+    using Axes = std::array<Math::Vec3f, 3>;
+
+    // Where the basis vectors end up under angle radians around the unit axis (Rodrigues)
+    Axes rotationAxes(const Math::Vec3f& axis, float angle)
+    {
+        const float c = std::cos(angle), s = std::sin(angle), t = 1.f - c;
+        const float x = Math::x(axis), y = Math::y(axis), z = Math::z(axis);
+        return Axes{
+            Math::Vec3f{ t * x * x + c,     t * x * y + s * z, t * x * z - s * y },
+            Math::Vec3f{ t * x * y - s * z, t * y * y + c,     t * y * z + s * x },
+            Math::Vec3f{ t * x * z + s * y, t * y * z - s * x, t * z * z + c     }
+        };
+    }
+
+    Math::Vec3f apply(const Axes& m, const Math::Vec3f& v)
+    {
+        return m[0] * Math::x(v) + m[1] * Math::y(v) + m[2] * Math::z(v);
+    }
+
+    bool near(const Math::Vec3f& a, const Math::Vec3f& b, float tolerance = 1e-5f)
+    {
+        return Math::length(a - b) <= tolerance * std::max(1.f, Math::length(b));
+    }
+
+    // Every vector in the set goes where the matrix sends it
+    bool agrees(const Axes& m, const Math::Vec4f& q)
+    {
+        static const Math::Vec3f probes[] = {
+            { 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, 0.f, 1.f }, { 0.3f, -2.f, 5.f }, { -1.f, -1.f, 1.f }
+        };
+
+        bool all = std::abs(Math::length(q) - 1.f) < 1e-5f;
+        for (const auto& v : probes) all &= near(rotate(q, v), apply(m, v));
+        return all;
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(6);
+    std::uniform_real_distribution<float> unit(-1.f, 1.f), angle(-Pi, Pi), scale(0.2f, 5.f);
+
+    const auto randomAxis = [&]()
+    {
+        Math::Vec3f axis{ unit(rng), unit(rng), unit(rng) };
+        while (Math::length(axis) < 0.1f) axis = Math::Vec3f{ unit(rng), unit(rng), unit(rng) };
+        return Math::normalized(axis);
+    };
+
+    // Random rotations, most of them go through the trace > 0 branch
+    {
+        bool all = true;
+        for (int i = 0; i < 2000; i++)
+        {
+            const auto m = rotationAxes(randomAxis(), angle(rng));
+            all &= agrees(m, toQuaternion(m[0], m[1], m[2]));
+        }
+        CHECK(all);
+    }
+
+    // Trace at or under zero: half turns around each axis and around diagonals, a third of a turn
+    // around (1, 1, 1) which has a trace of exactly 0, and turns just short of half
+    {
+        const float r2 = 1.f / std::sqrt(2.f), r3 = 1.f / std::sqrt(3.f);
+        const Math::Vec3f axes[] = {
+            { 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, 0.f, 1.f },
+            { r2, r2, 0.f }, { 0.f, r2, -r2 }, { -r2, 0.f, r2 }, { r3, r3, r3 }, { r3, -r3, r3 }
+        };
+
+        for (const auto& axis : axes)
+            for (const float turn : { Pi, -Pi, Pi - 1e-4f, Pi * 0.9f, Pi * 2.f / 3.f, Pi * 0.5f, 0.f })
+            {
+                const auto m = rotationAxes(axis, turn);
+                CHECK(agrees(m, toQuaternion(m[0], m[1], m[2])));
+            }
+
+        bool all = true;
+        for (int i = 0; i < 500; i++)
+        {
+            const auto m = rotationAxes(randomAxis(), Pi - std::abs(unit(rng)) * 0.5f);
+            all &= agrees(m, toQuaternion(m[0], m[1], m[2]));
+        }
+        CHECK(all);
+    }
+
+    // A rotation that's a hair off orthonormal still comes out unit length
+    {
+        auto m = rotationAxes(randomAxis(), 2.f);
+        for (auto& axis : m) axis = axis * 1.001f;
+        const auto q = toQuaternion(m[0], m[1], m[2]);
+        CHECK(std::abs(Math::length(q) - 1.f) < 1e-5f);
+    }
+
+    // Off a matrix, translation plays no part
+    {
+        const auto q = toQuaternion(Math::translation(Math::Vec3f{ 3.f, -4.f, 5.f }));
+        CHECK(near(Math::xyz(q), Math::Vec3f{ 0.f, 0.f, 0.f }) && std::abs(Math::w(q) - 1.f) < 1e-6f);
+    }
+
+    // Whole instances, non-uniform and mirrored scales included. Normals of an ellipsoid stay
+    // perpendicular to its tangents and point away from its centre
+    {
+        bool positions = true, perpendicular = true, outward = true, unit_length = true;
+        for (int i = 0; i < 2000; i++)
+        {
+            const auto m = rotationAxes(randomAxis(), angle(rng));
+            Math::Vec3f s{ scale(rng), scale(rng), scale(rng) };
+            if (i % 4 == 1) Math::x(s) = -Math::x(s);
+            if (i % 4 == 2) s = s * -1.f;
+
+            const PackedInstance instance{
+                .rotation = toQuaternion(m[0], m[1], m[2]),
+                .position = Math::Vec3f{ unit(rng) * 50.f, unit(rng) * 50.f, unit(rng) * 50.f },
+                .flags    = 0,
+                .scale    = s
+            };
+
+            // A point on the unit sphere, its normal, and a tangent there
+            const auto normal  = randomAxis();
+            const auto tangent = Math::normalized(Math::outer(normal, randomAxis()));
+
+            const Math::Vec3f scaled{ Math::x(s) * Math::x(normal), Math::y(s) * Math::y(normal), Math::z(s) * Math::z(normal) };
+            const auto world = instancePosition(instance, normal);
+            positions &= near(world, instance.position + apply(m, scaled), 1e-4f);
+
+            const Math::Vec3f scaled_tangent{ Math::x(s) * Math::x(tangent), Math::y(s) * Math::y(tangent), Math::z(s) * Math::z(tangent) };
+            const auto world_tangent = apply(m, scaled_tangent);
+            const auto world_normal  = instanceNormal(instance, normal);
+
+            unit_length   &= std::abs(Math::length(world_normal) - 1.f) < 1e-5f;
+            perpendicular &= std::abs(Math::inner(world_normal, world_tangent)) < 1e-4f * Math::length(world_tangent);
+            outward       &= Math::inner(world_normal, world - instance.position) > 0.f;
+        }
+        CHECK(positions);
+        CHECK(unit_length);
+        CHECK(perpendicular);
+        CHECK(outward);
+    }
+
+    // Flattened to nothing along z, every normal with any z in it lines up with z
+    {
+        const PackedInstance flat{ .rotation = Math::Vec4f{ 0.f, 0.f, 0.f, 1.f }, .position = {}, .flags = 0, .scale = Math::Vec3f{ 2.f, 3.f, 0.f } };
+        CHECK(near(instanceNormal(flat, Math::normalized(Math::Vec3f{ 0.3f, 0.4f, 0.5f })), Math::Vec3f{ 0.f, 0.f, 1.f }));
+        CHECK(near(instanceNormal(flat, Math::normalized(Math::Vec3f{ 0.3f, 0.4f, -0.5f })), Math::Vec3f{ 0.f, 0.f, -1.f }));
+    }
+
+    return Test::finish();
+}
@@ -0,0 +1,115 @@
+#include "Test.hpp"
+#include "Meshes.hpp"
+
+#include "Engine/ModelFile.hpp"
+#include "Engine/VertexPacking.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+// LOD levels out of the import and ModelFile::simplify: fewer triangles as the levels get coarser,
+// errors within each target, and meshes that still cover what they should
+
+using namespace Engine;
+using namespace mn;
+
+namespace
+{
+    float area(std::span<const mn::Graphics::Mesh::Vertex> vertices, std::span<const uint32_t> indices)
+    {
+        float total = 0.f;
+        for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            const auto& a = vertices[indices[i]].position;
+            total += Math::length(Math::outer(vertices[indices[i + 1]].position - a, vertices[indices[i + 2]].position - a)) * 0.5f;
+        }
+        return total;
+    }
+}
+
+int main()
+{
+    // Every level the baker would build, over a sphere
+    {
+        const LodSettings settings;
+        const auto path = Test::writeSphere("lod.obj", 64, 128);
+        const auto meshes = ModelFile::import(path, 1, settings);
+        std::filesystem::remove(path);
+
+        CHECK(meshes && meshes->size() == 1);
+        if (!meshes || meshes->empty()) return Test::finish();
+
+        const auto& mesh = meshes->front();
+        CHECK(mesh.levels.size() == settings.targets.size());
+
+        // Levels follow the full mesh back to back, coarsest first
+        std::size_t next = mesh.index_count, previous = 0;
+        for (std::size_t l = 0; l < mesh.levels.size(); l++)
+        {
+            const auto& level = mesh.levels[l];
+            CHECK(level.offset == next);
+            CHECK(level.count % 3 == 0 && level.count > 0);
+            CHECK(level.count >= previous && level.count < mesh.index_count);
+
+            // meshopt measures error against the extents, 2 for this sphere
+            CHECK(level.error >= 0.f && level.error <= settings.targets[l].max_error * 2.f * 1.01f);
+
+            next     = level.offset + level.count;
+            previous = level.count;
+        }
+        CHECK(next == mesh.indices.size());
+
+        bool in_range = true;
+        for (const auto index : mesh.indices) in_range &= (index < mesh.vertices.size());
+        CHECK(in_range);
+    }
+
+    // A flat grid can go all the way down without any error once its border is free to move, and
+    // with the border locked every border vertex stays
+    {
+        const auto path = Test::writeGrid("lod-grid.obj", 32);
+        const auto meshes = ModelFile::import(path, 1);
+        std::filesystem::remove(path);
+
+        CHECK(meshes && meshes->size() == 1);
+        if (!meshes || meshes->empty()) return Test::finish();
+
+        const auto& mesh = meshes->front();
+        const auto vertices = unpackVertices(mesh.vertices, mesh.aabb);
+        const auto full = std::span(mesh.indices).first(mesh.index_count);
+        CHECK(mesh.levels.empty());
+        CHECK(std::abs(area(vertices, full) - 4.f) < 1e-3f);
+
+        LodSettings settings;
+        settings.lock_border = false;
+
+        float error = -1.f;
+        const auto loose = ModelFile::simplify(vertices, full, settings, LodSettings::Target{ 0.01f, 0.01f }, error);
+        CHECK(!loose.empty() && loose.size() % 3 == 0);
+        CHECK(loose.size() <= std::max<std::size_t>(full.size() / 100, 6));
+        CHECK(error >= 0.f && error < 1e-3f);
+        CHECK(std::abs(area(vertices, loose) - 4.f) < 1e-3f);
+
+        settings.lock_border = true;
+        const auto locked = ModelFile::simplify(vertices, full, settings, LodSettings::Target{ 0.01f, 0.01f }, error);
+        CHECK(!locked.empty() && locked.size() < full.size());
+        CHECK(std::abs(area(vertices, locked) - 4.f) < 1e-3f);
+
+        const std::set<uint32_t> used(locked.begin(), locked.end());
+        std::size_t dropped = 0;
+        for (uint32_t v = 0; v < vertices.size(); v++)
+        {
+            const auto& p = vertices[v].position;
+            const bool border = std::abs(std::abs(Math::x(p)) - 1.f) < 1e-4f || std::abs(std::abs(Math::z(p)) - 1.f) < 1e-4f;
+            dropped += (border && !used.count(v));
+        }
+        CHECK(dropped == 0);
+
+        // Nothing to simplify, nothing back
+        const auto empty = ModelFile::simplify(vertices, {}, settings, LodSettings::Target{ 0.5f, 0.01f }, error);
+        CHECK(empty.empty() && error == 0.f);
+    }
+
+    return Test::finish();
+}
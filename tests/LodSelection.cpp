@@ -0,0 +1,173 @@
+#include "Test.hpp"
+
+#include "Engine/Systems/LodSelection.hpp"
+
+#include <cmath>
+#include <vector>
+
+// selectLevel on a made up LOD chain: the coarsest level under the threshold, unbuilt levels
+// requested and stood in for, overrides, and the hysteresis band holding a level steady until the
+// error really is past it
+
+using namespace Engine::System;
+
+namespace
+{
+    // Level 0 is the coarsest, past the last one is the full mesh
+    struct FakeLod
+    {
+        struct Level
+        {
+            std::size_t count;
+            float error;
+        };
+
+        std::vector<Level> levels;
+        std::vector<std::size_t> requests;
+
+        std::size_t size() const { return levels.size(); }
+        Level level(std::size_t l) const { return levels[l]; }
+        void request(std::size_t l) { requests.push_back(l); }
+    };
+
+    constexpr float Threshold = 1.f, Hysteresis = 0.25f;
+
+    LodQuery at(float pixels_per_error, int override_level = -1)
+    {
+        return LodQuery{ .pixels_per_error = pixels_per_error, .threshold = Threshold, .hysteresis = Hysteresis, .override_level = override_level };
+    }
+
+    // What it picks with no history: the first level under the threshold
+    uint32_t ideal(const FakeLod& lod, float pixels_per_error)
+    {
+        for (uint32_t l = 0; l < lod.size(); l++)
+            if (lod.levels[l].error * pixels_per_error <= Threshold) return l;
+        return static_cast<uint32_t>(lod.size());
+    }
+}
+
+int main()
+{
+    FakeLod lod{ .levels = { { 100, 0.4f }, { 200, 0.2f }, { 400, 0.1f }, { 800, 0.05f } } };
+    const auto full = static_cast<uint32_t>(lod.size());
+
+    // Without history, the coarsest that is fine enough, up to the full mesh up close
+    {
+        bool right = true;
+        for (float p = 0.5f; p < 100.f; p *= 1.07f)
+            right &= (selectLevel(&lod, at(p), nullptr) == ideal(lod, p));
+        CHECK(right);
+
+        CHECK(selectLevel(&lod, at(1.f), nullptr) == 0);
+        CHECK(selectLevel(&lod, at(4.f), nullptr) == 1);
+        CHECK(selectLevel(&lod, at(1000.f), nullptr) == full);
+        CHECK(lod.requests.empty());
+
+        // No chain at all, always the full mesh
+        CHECK(selectLevel<FakeLod>(nullptr, at(1.f), nullptr) == 0);
+    }
+
+    // A level that isn't built yet is asked for, and the next finer one that is draws meanwhile
+    {
+        auto partial = lod;
+        partial.levels[1].count = 0;
+
+        CHECK(selectLevel(&partial, at(4.f), nullptr) == 2);
+        CHECK(partial.requests.size() == 1 && partial.requests[0] == 1);
+
+        // The override gets the same treatment, and is clamped to the full mesh
+        partial.requests.clear();
+        CHECK(selectLevel(&partial, at(1.f, 1), nullptr) == 2);
+        CHECK(partial.requests.size() == 1 && partial.requests[0] == 1);
+        CHECK(selectLevel(&partial, at(1.f, 3), nullptr) == 3);
+        CHECK(selectLevel(&partial, at(1.f, 9), nullptr) == full);
+    }
+
+    // The first pick is recorded as is
+    {
+        uint8_t previous = NoLevel;
+        CHECK(selectLevel(&lod, at(4.f), &previous) == 1 && previous == 1);
+    }
+
+    // Jittering around a boundary inside the band never changes level. Level 1 (error 0.2) is
+    // right at the threshold at 5 pixels per unit of error
+    {
+        uint8_t previous = NoLevel;
+        selectLevel(&lod, at(5.f), &previous);
+        const auto held = previous;
+
+        bool steady = true;
+        for (int frame = 0; frame < 200; frame++)
+        {
+            const float p = 5.f * (1.f + 0.15f * std::sin(frame * 0.7f));
+            steady &= (selectLevel(&lod, at(p), &previous) == held);
+        }
+        CHECK(steady);
+
+        // Without the band the same jitter flips back and forth
+        std::size_t flips = 0;
+        uint32_t last = selectLevel(&lod, at(5.f), nullptr);
+        for (int frame = 0; frame < 200; frame++)
+        {
+            const auto level = selectLevel(&lod, at(5.f * (1.f + 0.15f * std::sin(frame * 0.7f))), nullptr);
+            flips += (level != last);
+            last = level;
+        }
+        CHECK(flips > 10);
+    }
+
+    // Coming closer, a level is only left once its error is past the band's top. Going away again,
+    // a coarser one is only taken once it's under the band's bottom
+    {
+        uint8_t previous = NoLevel;
+        float p = 1.f;
+        CHECK(selectLevel(&lod, at(p), &previous) == 0);
+
+        bool right = true;
+        for (; p < 200.f; p *= 1.01f)
+        {
+            const auto before = previous;
+            const auto level  = selectLevel(&lod, at(p), &previous);
+            if (level != before)
+            {
+                // Finer, and only because the old level went past the band
+                right &= (level > before);
+                right &= (lod.levels[before].error * p > Threshold * (1.f + Hysteresis));
+                right &= (level == ideal(lod, p));
+            }
+            else if (before < full)
+                right &= (lod.levels[before].error * p <= Threshold * (1.f + Hysteresis));
+        }
+        CHECK(right);
+        CHECK(previous == full);
+
+        for (; p > 0.5f; p /= 1.01f)
+        {
+            const auto before = previous;
+            const auto level  = selectLevel(&lod, at(p), &previous);
+            if (level != before)
+            {
+                // Coarser, and only to a level under the band's bottom
+                right &= (level < before);
+                right &= (lod.levels[level].error * p <= Threshold * (1.f - Hysteresis));
+            }
+            else if (level > 0)
+                right &= (lod.levels[level - 1].error * p > Threshold * (1.f - Hysteresis));
+        }
+        CHECK(right);
+        CHECK(previous == 0);
+    }
+
+    // A history pointing at a level that's gone (or never was) is ignored
+    {
+        uint8_t previous = 7;
+        CHECK(selectLevel(&lod, at(4.f), &previous) == 1 && previous == 1);
+
+        auto partial = lod;
+        partial.levels[2].count = 0;
+        previous = 2;
+        CHECK(selectLevel(&partial, at(4.f), &previous) == 1);
+    }
+
+    return Test::finish();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+// Meshes the import tests write out as OBJ before handing them to ModelFile::import. Assimp
+// makes a vertex per face corner out of these, just like the files the weld is there for
+namespace Test
+{
+    inline std::filesystem::path scratchPath(const std::string& name)
+    {
+        return std::filesystem::temp_directory_path() / ("solder-proof-" + name);
+    }
+
+    // UV sphere of radius 1 with smooth normals, outward facing counter clockwise triangles
+    inline std::filesystem::path writeSphere(const std::string& name, int rings, int sectors)
+    {
+        constexpr float Pi = 3.14159265358979f;
+
+        const auto path = scratchPath(name);
+        std::ofstream file(path);
+
+        for (int r = 0; r <= rings; r++)
+            for (int s = 0; s <= sectors; s++)
+            {
+                const float theta = Pi * r / rings, phi = 2.f * Pi * s / sectors;
+                const float x = std::sin(theta) * std::cos(phi), y = std::cos(theta), z = -std::sin(theta) * std::sin(phi);
+                file << "v " << x << ' ' << y << ' ' << z << "\nvn " << x << ' ' << y << ' ' << z << '\n';
+                file << "vt " << float(s) / sectors << ' ' << float(r) / rings << '\n';
+            }
+
+        const auto corner = [&](int r, int s)
+        {
+            const int i = r * (sectors + 1) + s + 1;
+            return std::to_string(i) + '/' + std::to_string(i) + '/' + std::to_string(i);
+        };
+
+        for (int r = 0; r < rings; r++)
+            for (int s = 0; s < sectors; s++)
+            {
+                if (r > 0)         file << "f " << corner(r, s) << ' ' << corner(r + 1, s) << ' ' << corner(r, s + 1) << '\n';
+                if (r < rings - 1) file << "f " << corner(r, s + 1) << ' ' << corner(r + 1, s) << ' ' << corner(r + 1, s + 1) << '\n';
+            }
+
+        return path;
+    }
+
+    // Flat square of cells x cells quads in the XZ plane facing up, from -1 to 1
+    inline std::filesystem::path writeGrid(const std::string& name, int cells)
+    {
+        const auto path = scratchPath(name);
+        std::ofstream file(path);
+
+        for (int z = 0; z <= cells; z++)
+            for (int x = 0; x <= cells; x++)
+            {
+                file << "v " << (2.f * x / cells - 1.f) << " 0 " << (2.f * z / cells - 1.f) << '\n';
+                file << "vt " << float(x) / cells << ' ' << float(z) / cells << '\n';
+            }
+        file << "vn 0 1 0\n";
+
+        const auto corner = [&](int x, int z)
+        {
+            const int i = z * (cells + 1) + x + 1;
+            return std::to_string(i) + '/' + std::to_string(i) + "/1";
+        };
+
+        for (int z = 0; z < cells; z++)
+            for (int x = 0; x < cells; x++)
+            {
+                file << "f " << corner(x, z) << ' ' << corner(x, z + 1) << ' ' << corner(x + 1, z) << '\n';
+                file << "f " << corner(x + 1, z) << ' ' << corner(x, z + 1) << ' ' << corner(x + 1, z + 1) << '\n';
+            }
+
+        return path;
+    }
+}
@@ -0,0 +1,151 @@
+#include "Test.hpp"
+#include "Meshes.hpp"
+
+#include "Engine/ModelFile.hpp"
+#include "Engine/VertexPacking.hpp"
+#include "Engine/Systems/Culling.hpp"
+
+#include <random>
+
+// Meshlets out of the import tile the mesh, hold their triangles, and CullingStage::cullMeshlets only
+// ever drops meshlets that are off screen or facing away
+
+using namespace Engine;
+using namespace Engine::System;
+using namespace mn;
+
+namespace
+{
+    using Meshlet = Model::BoundedMesh::Meshlet;
+
+    // Planes so far out nothing is outside them, for testing the cones on their own
+    Frustum everywhere(const Math::Vec3f& position)
+    {
+        Frustum frustum;
+        frustum.position = position;
+        frustum.near_distance = 0.1f;
+        frustum.planes = {
+            Math::Vec4f{ 1.f, 0.f, 0.f, 1e6f }, Math::Vec4f{ -1.f, 0.f, 0.f, 1e6f },
+            Math::Vec4f{ 0.f, 1.f, 0.f, 1e6f }, Math::Vec4f{ 0.f, -1.f, 0.f, 1e6f },
+            Math::Vec4f{ 0.f, 0.f, 1.f, 1e6f }, Math::Vec4f{ 0.f, 0.f, -1.f, 1e6f }
+        };
+        return frustum;
+    }
+}
+
+int main()
+{
+    const auto identity = Math::Mat4<float>::identity();
+
+    // Spheres against the planes, moved and scaled by the model matrix. No cones here
+    {
+        auto frustum = everywhere(Math::Vec3f{ 0.f, 0.f, 0.f });
+        frustum.planes[0] = Math::Vec4f{ 1.f, 0.f, 0.f, 0.f };
+
+        const std::vector<Meshlet> meshlets = {
+            Meshlet{ .offset = 0,  .count = 30, .center = { 5.f, 0.f, 0.f },  .radius = 1.f, .cone_cutoff = 1.f },
+            Meshlet{ .offset = 30, .count = 60, .center = { -5.f, 0.f, 0.f }, .radius = 1.f, .cone_cutoff = 1.f },
+            Meshlet{ .offset = 90, .count = 90, .center = { -0.8f, 0.f, 0.f }, .radius = 1.f, .cone_cutoff = 1.f },
+        };
+
+        std::vector<uint8_t> visible(meshlets.size());
+        auto stats = CullingStage::cullMeshlets(meshlets, identity, 1.f, false, frustum, visible);
+        CHECK(visible[0] && !visible[1] && visible[2]);
+        CHECK(stats.tested == 3 && stats.culled == 1 && stats.triangles == 20);
+
+        // Moved right by 4.8 the second one's sphere reaches over the plane
+        stats = CullingStage::cullMeshlets(meshlets, Math::translation(Math::Vec3f{ 4.8f, 0.f, 0.f }), 1.f, false, frustum, visible);
+        CHECK(visible[0] && visible[1] && visible[2] && !stats.culled);
+
+        // Doubled, the third one's centre moves to -1.6 but its radius grows to 2
+        stats = CullingStage::cullMeshlets(meshlets, Math::scale(Math::Vec3f{ 2.f, 2.f, 2.f }), 2.f, false, frustum, visible);
+        CHECK(visible[0] && !visible[1] && visible[2]);
+    }
+
+    // A meshlet facing +z within 0.5 radians: gone from straight behind, kept from the front, and
+    // kept from behind when the transform mirrors
+    {
+        const float cutoff = std::sin(0.5f);
+        const std::vector<Meshlet> meshlets = {
+            Meshlet{ .offset = 0, .count = 3, .center = { 0.f, 0.f, 0.f }, .radius = 1.f,
+                     .cone_apex = { 0.f, 0.f, 0.f }, .cone_axis = { 0.f, 0.f, 1.f }, .cone_cutoff = cutoff }
+        };
+
+        std::vector<uint8_t> visible(1);
+        CullingStage::cullMeshlets(meshlets, identity, 1.f, true, everywhere(Math::Vec3f{ 0.f, 0.f, -10.f }), visible);
+        CHECK(!visible[0]);
+
+        CullingStage::cullMeshlets(meshlets, identity, 1.f, true, everywhere(Math::Vec3f{ 0.f, 0.f, 10.f }), visible);
+        CHECK(visible[0]);
+
+        CullingStage::cullMeshlets(meshlets, identity, 1.f, false, everywhere(Math::Vec3f{ 0.f, 0.f, -10.f }), visible);
+        CHECK(visible[0]);
+
+        // The camera goes into object space, moving the mesh behind it puts the camera in front
+        CullingStage::cullMeshlets(meshlets, Math::translation(Math::Vec3f{ 0.f, 0.f, -20.f }), 1.f, true, everywhere(Math::Vec3f{ 0.f, 0.f, -10.f }), visible);
+        CHECK(visible[0]);
+    }
+
+    // The import's meshlets over a real mesh
+    {
+        const auto path = Test::writeSphere("meshlets.obj", 48, 96);
+        const auto meshes = ModelFile::import(path, 1);
+        std::filesystem::remove(path);
+
+        CHECK(meshes && meshes->size() == 1);
+        if (!meshes || meshes->empty()) return Test::finish();
+
+        const auto& mesh = meshes->front();
+        const auto vertices = unpackVertices(mesh.vertices, mesh.aabb);
+
+        CHECK(mesh.meshlets.size() > 1);
+
+        // Back to back from the start of the mesh to index_count, whole triangles each
+        std::size_t next = 0;
+        bool tiled = true;
+        for (const auto& meshlet : mesh.meshlets)
+        {
+            tiled &= (meshlet.offset == next && meshlet.count % 3 == 0 && meshlet.count > 0);
+            next = meshlet.offset + meshlet.count;
+        }
+        CHECK(tiled && next == mesh.index_count);
+
+        // Every vertex inside its meshlet's sphere, give or take the packing
+        std::size_t outside = 0;
+        for (const auto& meshlet : mesh.meshlets)
+            for (std::size_t i = meshlet.offset; i < meshlet.offset + meshlet.count; i++)
+                outside += (Math::length(vertices[mesh.indices[i]].position - meshlet.center) > meshlet.radius + 1e-3f);
+        CHECK(outside == 0);
+
+        // From cameras all around, whatever the cones cull has to face away from the camera, and
+        // some has to be culled or the cones aren't doing anything
+        std::mt19937 rng(2);
+        std::uniform_real_distribution<float> around(-6.f, 6.f);
+        std::vector<uint8_t> visible(mesh.meshlets.size());
+        std::size_t culled = 0, facing = 0;
+        for (int c = 0; c < 200; c++)
+        {
+            const Math::Vec3f camera{ around(rng), around(rng), around(rng) };
+            if (Math::length(camera) < 1.5f) continue;
+
+            culled += CullingStage::cullMeshlets(mesh.meshlets, identity, 1.f, true, everywhere(camera), visible).culled;
+            for (std::size_t m = 0; m < mesh.meshlets.size(); m++)
+            {
+                if (visible[m]) continue;
+
+                const auto& meshlet = mesh.meshlets[m];
+                for (std::size_t i = meshlet.offset; i < meshlet.offset + meshlet.count; i += 3)
+                {
+                    const auto& a = vertices[mesh.indices[i]].position;
+                    const auto& b = vertices[mesh.indices[i + 1]].position;
+                    const auto& c = vertices[mesh.indices[i + 2]].position;
+                    facing += (Math::inner(Math::outer(b - a, c - a), camera - a) > 1e-5f);
+                }
+            }
+        }
+        CHECK(culled > 0);
+        CHECK(facing == 0);
+    }
+
+    return Test::finish();
+}
@@ -0,0 +1,99 @@
+#include "Test.hpp"
+#include "Meshes.hpp"
+
+#include "Engine/ModelFile.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+// Imported meshes written out as a baked file and mapped back come out exactly as they went in,
+// and read() turns down files that are cut short or index past their vertices
+
+using namespace Engine;
+using namespace mn;
+
+namespace
+{
+    template<typename T>
+    bool sameBytes(std::span<const T> a, std::span<const T> b)
+    {
+        return a.size() == b.size() && (a.empty() || !std::memcmp(a.data(), b.data(), a.size_bytes()));
+    }
+
+    bool same(const ModelFile::MeshData& in, const ModelFile::MeshView& out)
+    {
+        bool levels = (in.levels.size() == out.levels.size());
+        for (std::size_t l = 0; levels && l < in.levels.size(); l++)
+            levels = (in.levels[l].offset == out.levels[l].offset && in.levels[l].count == out.levels[l].count && in.levels[l].error == out.levels[l].error);
+
+        bool meshlets = (in.meshlets.size() == out.meshlets.size());
+        for (std::size_t m = 0; meshlets && m < in.meshlets.size(); m++)
+        {
+            const auto& a = in.meshlets[m];
+            const auto& b = out.meshlets[m];
+            meshlets = (a.offset == b.offset && a.count == b.count && a.radius == b.radius && a.cone_cutoff == b.cone_cutoff &&
+                Math::length(a.center - b.center) == 0.f && Math::length(a.cone_apex - b.cone_apex) == 0.f && Math::length(a.cone_axis - b.cone_axis) == 0.f);
+        }
+
+        return
+            Math::length(in.aabb.min - out.aabb.min) == 0.f && Math::length(in.aabb.max - out.aabb.max) == 0.f &&
+            sameBytes(std::span<const ModelFile::Vertex>(in.vertices), out.vertices) &&
+            in.source_vertex_count == out.source_vertex_count &&
+            sameBytes(std::span<const uint32_t>(in.colors), out.colors) && in.color == out.color &&
+            sameBytes(std::span<const uint32_t>(in.indices), out.indices) && in.index_count == out.index_count &&
+            levels && meshlets && in.material.diffuse == out.material.diffuse;
+    }
+}
+
+int main()
+{
+    // The cube fixture and a sphere with every LOD level, the way the baker imports them
+    auto meshes = ModelFile::import(TEST_DIR "/fixtures/cube.obj", 1, LodSettings{});
+    const auto sphere_path = Test::writeSphere("model-file.obj", 32, 64);
+    const auto sphere = ModelFile::import(sphere_path, 1, LodSettings{});
+    std::filesystem::remove(sphere_path);
+
+    CHECK(meshes && sphere && meshes->size() == 1 && sphere->size() == 1);
+    if (!meshes || !sphere || meshes->empty() || sphere->empty()) return Test::finish();
+
+    meshes->push_back(sphere->front());
+    meshes->front().material.diffuse = "textures/cube.png";
+    CHECK(!meshes->back().levels.empty() && !meshes->back().meshlets.empty());
+
+    const auto path = Test::scratchPath("model-file.spm");
+    CHECK(ModelFile::isBaked(path));
+    CHECK(ModelFile::write(path, *meshes));
+
+    {
+        const Util::MappedFile file(path);
+        CHECK(static_cast<bool>(file));
+
+        const auto read = ModelFile::read(file);
+        CHECK(read && read->size() == meshes->size());
+        if (read && read->size() == meshes->size())
+            for (std::size_t m = 0; m < meshes->size(); m++)
+                CHECK(same((*meshes)[m], (*read)[m]));
+    }
+
+    // Cut short, it's turned down rather than read past the end
+    {
+        const auto size = std::filesystem::file_size(path);
+        std::filesystem::resize_file(path, size - 16);
+        const Util::MappedFile file(path);
+        CHECK(!ModelFile::read(file));
+    }
+
+    // One index past the vertices
+    {
+        auto broken = meshes->front();
+        broken.indices[broken.index_count / 2] = static_cast<uint32_t>(broken.vertices.size());
+        CHECK(ModelFile::write(path, std::span(&broken, 1)));
+
+        const Util::MappedFile file(path);
+        CHECK(!ModelFile::read(file));
+    }
+
+    std::filesystem::remove(path);
+
+    return Test::finish();
+}
@@ -0,0 +1,222 @@
+#include "Test.hpp"
+
+#include "Engine/Systems/Occlusion.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+
+// OcclusionBuffer only ever hides boxes that really are behind the occluders, at the buffer's own
+// resolution: the ray through every pixel centre under a hidden box has to meet an occluder before
+// the box. Which rasterizer it tests depends on how Occlusion.cpp was compiled, CMake builds this
+// once more for AVX2
+
+using namespace Engine;
+using namespace Engine::System;
+using namespace mn;
+
+namespace
+{
+    using Triangle = std::array<Math::Vec3f, 3>;
+
+    constexpr uint32_t Width = 256, Height = 144;
+    constexpr float Miss = std::numeric_limits<float>::max();
+
+    float axis(const Math::Vec3f& v, int a)
+    {
+        return (a == 0 ? Math::x(v) : a == 1 ? Math::y(v) : Math::z(v));
+    }
+
+    // How far along the ray from the camera (at the origin) it meets the triangle. Edges get a
+    // hair of slack, the rasterizer and this don't round the same way
+    float hit(const Math::Vec3f& ray, const Triangle& t)
+    {
+        constexpr float Slack = 1e-4f;
+
+        const auto e1 = t[1] - t[0], e2 = t[2] - t[0];
+        const auto h = Math::outer(ray, e2);
+        const float det = Math::inner(e1, h);
+        if (std::abs(det) < 1e-12f) return Miss;
+
+        const auto s = t[0] * -1.f;
+        const float u = Math::inner(s, h) / det;
+        if (u < -Slack || u > 1.f + Slack) return Miss;
+
+        const auto q = Math::outer(s, e1);
+        const float v = Math::inner(ray, q) / det;
+        if (v < -Slack || u + v > 1.f + Slack) return Miss;
+
+        const float along = Math::inner(e2, q) / det;
+        return (along > 0.f ? along : Miss);
+    }
+
+    // Where the same ray enters the box
+    float enter(const Math::Vec3f& ray, const BoundingBox& box)
+    {
+        float first = 0.f, last = Miss;
+        for (int a = 0; a < 3; a++)
+        {
+            const float d = (axis(ray, a) == 0.f ? 1e-20f : axis(ray, a));
+            float near = axis(box.min, a) / d, far = axis(box.max, a) / d;
+            if (near > far) std::swap(near, far);
+            first = std::max(first, near);
+            last  = std::min(last, far);
+        }
+        return (first <= last ? first : Miss);
+    }
+
+    struct Scene
+    {
+        OcclusionBuffer buffer;
+        std::vector<Triangle> occluders;
+        Math::Mat4<float> projection, unproject;
+        Math::Mat4<float> identity = Math::Mat4<float>::identity();
+        Math::Vec3f ahead;
+
+        Scene(const Math::Mat4<float>& projection, const Math::Vec3f& ahead)
+            : projection(projection), unproject(Math::inv(projection)), ahead(ahead)
+        {
+            buffer.resize(Width, Height);
+            buffer.clear(projection, 0.1f);
+        }
+
+        void add(const Triangle& t)
+        {
+            occluders.push_back(t);
+            const std::array<uint32_t, 3> indices = { 0, 1, 2 };
+            buffer.rasterize(t, indices, identity);
+        }
+
+        // Whether any pixel centre sees part of the box before it sees an occluder
+        bool seen(const BoundingBox& box) const
+        {
+            float min_x = Miss, max_x = -Miss, min_y = Miss, max_y = -Miss;
+            for (int corner = 0; corner < 8; corner++)
+            {
+                const auto clip = projection * Math::Vec4f{
+                    (corner & 1 ? Math::x(box.max) : Math::x(box.min)),
+                    (corner & 2 ? Math::y(box.max) : Math::y(box.min)),
+                    (corner & 4 ? Math::z(box.max) : Math::z(box.min)),
+                    1.f
+                };
+                const float x = (Math::x(clip) / Math::w(clip) * 0.5f + 0.5f) * Width;
+                const float y = (Math::y(clip) / Math::w(clip) * 0.5f + 0.5f) * Height;
+                min_x = std::min(min_x, x); max_x = std::max(max_x, x);
+                min_y = std::min(min_y, y); max_y = std::max(max_y, y);
+            }
+
+            const int x0 = std::max(static_cast<int>(std::floor(min_x)), 0), x1 = std::min(static_cast<int>(std::ceil(max_x)), int(Width) - 1);
+            const int y0 = std::max(static_cast<int>(std::floor(min_y)), 0), y1 = std::min(static_cast<int>(std::ceil(max_y)), int(Height) - 1);
+            for (int y = y0; y <= y1; y++)
+                for (int x = x0; x <= x1; x++)
+                {
+                    const auto point = unproject * Math::Vec4f{ (x + 0.5f) / Width * 2.f - 1.f, (y + 0.5f) / Height * 2.f - 1.f, 0.5f, 1.f };
+                    auto ray = Math::xyz(point) * (1.f / Math::w(point));
+                    if (Math::inner(ray, ahead) < 0.f) ray = ray * -1.f;
+
+                    const float box_at = enter(ray, box);
+                    if (box_at == Miss) continue;
+
+                    float occluder_at = Miss;
+                    for (const auto& t : occluders) occluder_at = std::min(occluder_at, hit(ray, t));
+                    if (box_at < occluder_at * 0.9999f) return true;
+                }
+
+            return false;
+        }
+    };
+}
+
+int main()
+{
+#if defined(__AVX2__)
+    if (!__builtin_cpu_supports("avx2")) return Test::Skip;
+#endif
+
+    const auto projection = Math::perspective(float(Width) / float(Height), Math::Angle::degrees(70), Math::Vec2f{ 0.1f, 500.f });
+
+    // Whichever way the projection looks, the scenes go in front of the camera
+    const float forward = (Math::w(projection * Math::Vec4f{ 0.f, 0.f, -1.f, 1.f }) > 0.f ? -1.f : 1.f);
+    const auto at = [forward](float x, float y, float depth) { return Math::Vec3f{ x, y, depth * forward }; };
+    const auto box = [&](float x0, float y0, float d0, float x1, float y1, float d1)
+    {
+        const auto a = at(x0, y0, d0), b = at(x1, y1, d1);
+        return BoundingBox{ Math::min(a, b), Math::max(a, b) };
+    };
+    const auto ahead = at(0.f, 0.f, 1.f);
+
+    // A wall ten units out, 8 across. One of its triangles is wound the other way
+    {
+        Scene scene(projection, ahead);
+        scene.add({ at(-4.f, -4.f, 10.f), at(4.f, -4.f, 10.f), at(4.f, 4.f, 10.f) });
+        scene.add({ at(-4.f, -4.f, 10.f), at(-4.f, 4.f, 10.f), at(4.f, 4.f, 10.f) });
+        scene.buffer.finish();
+        CHECK(scene.buffer.triangles() == 2);
+
+        const auto& buffer = scene.buffer;
+        CHECK(buffer.occluded(box(-1.f, -1.f, 20.f, 1.f, 1.f, 22.f), scene.identity));
+        CHECK(!buffer.occluded(box(-1.f, -1.f, 5.f, 1.f, 1.f, 6.f), scene.identity));
+        CHECK(!buffer.occluded(box(10.f, -1.f, 20.f, 12.f, 1.f, 22.f), scene.identity));
+
+        // Sticking out past the edge, and passing through the wall
+        CHECK(!buffer.occluded(box(6.f, -1.f, 20.f, 10.f, 1.f, 22.f), scene.identity));
+        CHECK(!buffer.occluded(box(-1.f, -1.f, 8.f, 1.f, 1.f, 12.f), scene.identity));
+
+        // The wall's own box isn't hidden behind itself
+        CHECK(!buffer.occluded(box(-4.f, -4.f, 10.f, 4.f, 4.f, 10.f), scene.identity));
+
+        // Moved behind the wall by the model matrix
+        CHECK(buffer.occluded(box(-1.f, -1.f, 1.f, 1.f, 1.f, 2.f), Math::translation(at(0.f, 0.f, 20.f))));
+    }
+
+    // A triangle reaching behind the near plane isn't drawn at all
+    {
+        Scene scene(projection, ahead);
+        scene.add({ at(-50.f, -50.f, -5.f), at(50.f, -50.f, 30.f), at(0.f, 50.f, 10.f) });
+        scene.buffer.finish();
+        CHECK(scene.buffer.triangles() == 0);
+        CHECK(!scene.buffer.occluded(box(-1.f, -1.f, 40.f, 1.f, 1.f, 42.f), scene.identity));
+    }
+
+    // Random occluders and boxes against the ray cast truth
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<float> across(-12.f, 12.f), near_depth(8.f, 20.f), far_depth(15.f, 60.f), size(0.2f, 4.f), unit(-1.f, 1.f);
+
+    std::size_t occluded = 0, wrong = 0, boxes = 0;
+    for (int round = 0; round < 20; round++)
+    {
+        Scene scene(projection, ahead);
+        for (int t = 0; t < 12; t++)
+        {
+            const auto center = at(across(rng), across(rng) * 0.6f, near_depth(rng));
+            const float extent = 3.f + size(rng) * 2.f;
+            scene.add({
+                center + Math::Vec3f{ unit(rng), unit(rng), unit(rng) * 0.3f } * extent,
+                center + Math::Vec3f{ unit(rng), unit(rng), unit(rng) * 0.3f } * extent,
+                center + Math::Vec3f{ unit(rng), unit(rng), unit(rng) * 0.3f } * extent
+            });
+        }
+        scene.buffer.finish();
+
+        for (int b = 0; b < 200; b++)
+        {
+            const auto corner = at(across(rng), across(rng) * 0.6f, far_depth(rng));
+            const Math::Vec3f extent{ size(rng), size(rng), size(rng) };
+            const BoundingBox bounds{ Math::min(corner, corner + extent), Math::max(corner, corner + extent) };
+
+            boxes++;
+            if (!scene.buffer.occluded(bounds, scene.identity)) continue;
+
+            occluded++;
+            wrong += scene.seen(bounds);
+        }
+    }
+    CHECK(wrong == 0);
+
+    // Some hidden, or the random scenes don't test anything
+    CHECK(occluded > boxes / 50);
+
+    return Test::finish();
+}
@@ -0,0 +1,80 @@
+#include "Test.hpp"
+
+#include "Util/RadixSort.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// Util::radixSort against std::stable_sort on the same keys
+
+namespace
+{
+    struct Item
+    {
+        uint32_t key;
+        uint32_t index;
+    };
+
+    bool sorted(std::vector<Item> items, uint32_t key_bits, std::mt19937& rng)
+    {
+        const uint32_t key_mask = (key_bits >= 32 ? ~0U : (1U << key_bits) - 1);
+        const auto key = [key_mask](const Item& item) { return item.key & key_mask; };
+
+        auto expected = items;
+        std::stable_sort(expected.begin(), expected.end(), [&key](const Item& a, const Item& b) { return key(a) < key(b); });
+
+        // Garbage in the scratch space must not leak into the result
+        std::vector<Item> scratch(items.size() + rng() % 8);
+        for (auto& item : scratch) item = Item{ static_cast<uint32_t>(rng()), ~0U };
+
+        Util::radixSort(std::span(items), std::span(scratch), key_bits, key);
+
+        return std::equal(items.begin(), items.end(), expected.begin(), expected.end(),
+            [](const Item& a, const Item& b) { return a.key == b.key && a.index == b.index; });
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(5);
+
+    // Below and above the cut over to insertion sort, with lots of equal keys to catch an unstable pass
+    for (const std::size_t count : { 0, 1, 2, 17, 63, 64, 65, 1000, 100000 })
+    {
+        for (const uint32_t key_bits : { 8U, 12U, 24U, 32U })
+        {
+            std::vector<Item> items(count);
+            for (uint32_t i = 0; i < count; i++)
+                items[i] = Item{ static_cast<uint32_t>(rng()) % (count / 4 + 1) * 2654435761U, i };
+            CHECK(sorted(items, key_bits, rng));
+
+            for (uint32_t i = 0; i < count; i++)
+                items[i] = Item{ static_cast<uint32_t>(rng()), i };
+            CHECK(sorted(items, key_bits, rng));
+        }
+    }
+
+    // Passes where every key shares a byte get skipped, the result still has to be right
+    {
+        std::vector<Item> items(5000);
+        for (uint32_t i = 0; i < items.size(); i++)
+            items[i] = Item{ 0xAB00CD00U | (static_cast<uint32_t>(rng()) & 0x00FF00FFU), i };
+        CHECK(sorted(items, 32, rng));
+
+        for (auto& item : items) item.key = 42;
+        CHECK(sorted(items, 32, rng));
+    }
+
+    // Already sorted and reversed
+    {
+        std::vector<Item> items(3000);
+        for (uint32_t i = 0; i < items.size(); i++) items[i] = Item{ i * 3, i };
+        CHECK(sorted(items, 16, rng));
+
+        std::reverse(items.begin(), items.end());
+        CHECK(sorted(items, 16, rng));
+    }
+
+    return Test::finish();
+}
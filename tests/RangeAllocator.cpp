@@ -0,0 +1,219 @@
+#include "Test.hpp"
+
+#include "Util/RangeAllocator.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// Util::RangeAllocator against a plain used/free flag per element
+
+namespace
+{
+    // Where a first-fit search over the flags puts count elements
+    std::optional<std::size_t> firstFit(const std::vector<bool>& taken, std::size_t count)
+    {
+        std::size_t run = 0;
+        for (std::size_t i = 0; i < taken.size(); i++)
+        {
+            run = (taken[i] ? 0 : run + 1);
+            if (run == count) return i + 1 - count;
+        }
+        return std::nullopt;
+    }
+
+    std::size_t largestRun(const std::vector<bool>& taken)
+    {
+        std::size_t run = 0, largest = 0;
+        for (const bool t : taken)
+        {
+            run = (t ? 0 : run + 1);
+            largest = std::max(largest, run);
+        }
+        return largest;
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(11);
+
+    Util::RangeAllocator ranges(1000);
+    std::vector<bool> taken(1000, false);
+
+    struct Range
+    {
+        std::size_t offset, count;
+    };
+    std::vector<Range> live;
+
+    std::size_t used = 0, mismatches = 0;
+    for (int step = 0; step < 20000; step++)
+    {
+        // Now and then add room at the end, which has to merge with a free tail
+        if (step % 5000 == 4999)
+        {
+            const auto capacity = ranges.capacity() + 500;
+            ranges.grow(capacity);
+            taken.resize(capacity, false);
+            CHECK(ranges.capacity() == capacity);
+        }
+
+        if (live.empty() || rng() % 2)
+        {
+            const std::size_t count = 1 + rng() % 64;
+            const auto expected = firstFit(taken, count);
+            const auto offset = ranges.allocate(count);
+
+            if (offset != expected)
+            {
+                mismatches++;
+                continue;
+            }
+            if (!offset) continue;
+
+            for (std::size_t i = *offset; i < *offset + count; i++) taken[i] = true;
+            live.push_back({ *offset, count });
+            used += count;
+        }
+        else
+        {
+            const auto index = rng() % live.size();
+            const auto range = live[index];
+            live[index] = live.back();
+            live.pop_back();
+
+            ranges.free(range.offset, range.count);
+            for (std::size_t i = range.offset; i < range.offset + range.count; i++) taken[i] = false;
+            used -= range.count;
+        }
+
+        mismatches += (ranges.used() != used);
+        mismatches += (ranges.largestFree() != largestRun(taken));
+    }
+    CHECK(mismatches == 0);
+
+    // Giving everything back leaves one block again
+    for (const auto& range : live)
+        ranges.free(range.offset, range.count);
+    CHECK(ranges.used() == 0);
+    CHECK(ranges.largestFree() == ranges.capacity());
+    CHECK(ranges.fragmentation() == 0.f);
+
+    // Zero sized requests never take anything
+    CHECK(ranges.allocate(0) == std::size_t(0));
+    CHECK(ranges.used() == 0);
+
+    // Too big fails without changing anything
+    CHECK(!ranges.allocate(ranges.capacity() + 1));
+    CHECK(ranges.used() == 0);
+
+    // Every other block free, half the free space is outside the largest block
+    {
+        Util::RangeAllocator split(40);
+        for (std::size_t i = 0; i < 4; i++) CHECK(split.allocate(10) == i * 10);
+        split.free(0, 10);
+        split.free(20, 10);
+        CHECK(split.largestFree() == 10);
+        CHECK(split.fragmentation() == 0.5f);
+
+        // Freeing the one in between merges all three
+        split.free(10, 10);
+        CHECK(split.largestFree() == 30);
+        CHECK(split.allocate(30) == std::size_t(0));
+    }
+
+    // A retired range stays taken for delay frames, then comes back like a free()
+    {
+        Util::RangeAllocator frames(30);
+        for (std::size_t i = 0; i < 3; i++) CHECK(frames.allocate(10) == i * 10);
+
+        frames.retire(10, 10, 2);
+        CHECK(frames.used() == 30 && frames.retired() == 10);
+        CHECK(!frames.allocate(1));
+
+        frames.nextFrame();
+        CHECK(!frames.allocate(1));
+        frames.nextFrame();
+        CHECK(frames.used() == 20 && frames.retired() == 0);
+        CHECK(frames.allocate(10) == std::size_t(10));
+
+        // No delay is just a free
+        frames.retire(0, 10, 0);
+        CHECK(frames.used() == 20 && frames.allocate(10) == std::size_t(0));
+    }
+
+    // Random retires over many frames: nothing handed out may overlap a range retired fewer than
+    // Delay frames ago, and the allocator still agrees with the flags once they're due
+    {
+        constexpr std::size_t Delay = 3;
+
+        Util::RangeAllocator frames(2000);
+        std::vector<bool> held(2000, false);
+        std::vector<Range> owned;
+
+        struct Pending
+        {
+            Range range;
+            std::size_t due;
+        };
+        std::vector<Pending> pending;
+
+        std::size_t frame = 0, retire_mismatches = 0, retired = 0;
+        for (int step = 0; step < 20000; step++)
+        {
+            if (step % 7 == 6)
+            {
+                frames.nextFrame();
+                frame++;
+                for (std::size_t i = 0; i < pending.size();)
+                {
+                    if (pending[i].due > frame) { i++; continue; }
+                    for (std::size_t e = pending[i].range.offset; e < pending[i].range.offset + pending[i].range.count; e++) held[e] = false;
+                    retired -= pending[i].range.count;
+                    pending[i] = pending.back();
+                    pending.pop_back();
+                }
+            }
+
+            if (owned.empty() || rng() % 2)
+            {
+                const std::size_t count = 1 + rng() % 64;
+                const auto expected = firstFit(held, count);
+                const auto offset = frames.allocate(count);
+
+                if (offset != expected)
+                {
+                    retire_mismatches++;
+                    continue;
+                }
+                if (!offset) continue;
+
+                for (std::size_t e = *offset; e < *offset + count; e++) held[e] = true;
+                owned.push_back({ *offset, count });
+            }
+            else
+            {
+                const auto index = rng() % owned.size();
+                const auto range = owned[index];
+                owned[index] = owned.back();
+                owned.pop_back();
+
+                frames.retire(range.offset, range.count, Delay);
+                pending.push_back({ range, frame + Delay });
+                retired += range.count;
+            }
+
+            retire_mismatches += (frames.retired() != retired);
+            retire_mismatches += (frames.largestFree() != largestRun(held));
+        }
+        CHECK(retire_mismatches == 0);
+
+        // Everything due after Delay frames
+        for (const auto& range : owned) frames.retire(range.offset, range.count, Delay);
+        for (std::size_t f = 0; f < Delay; f++) frames.nextFrame();
+        CHECK(frames.used() == 0 && frames.retired() == 0);
+    }
+
+    return Test::finish();
+}
@@ -0,0 +1,127 @@
+#include "Test.hpp"
+
+#include "Engine/ResourceManager.hpp"
+#include "Util/Task.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+// ResourceManager::load stages on a loader thread and builds on the thread calling update(), and a
+// throw in either half comes back through the Pending instead of taking the program down
+
+using namespace Engine;
+
+namespace
+{
+    struct Resource
+    {
+        struct Staged
+        {
+            int value;
+            std::thread::id staged_on;
+        };
+
+        static Staged stage(int value)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            if (value < 0) throw std::runtime_error("staging failed");
+            return Staged{ .value = value, .staged_on = std::this_thread::get_id() };
+        }
+
+        Resource(Staged&& staged) :
+            value(staged.value), staged_on(staged.staged_on), built_on(std::this_thread::get_id())
+        {
+            if (value == 13) throw std::runtime_error("building failed");
+        }
+
+        int value;
+        std::thread::id staged_on, built_on;
+    };
+
+    static_assert(ResourceManager::Stageable<Resource, int>);
+    static_assert(!ResourceManager::Stageable<Resource, const char*>);
+
+    // Calls update() until nothing is in flight, or gives up after a few seconds
+    bool settle(ResourceManager& res)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        while (res.loading())
+        {
+            if (std::chrono::steady_clock::now() - start > std::chrono::seconds(5)) return false;
+            res.update();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    template<typename T>
+    std::string message(const ResourceManager::Pending<T>& pending)
+    {
+        try { std::rethrow_exception(pending.error()); }
+        catch (const std::exception& error) { return error.what(); }
+        catch (...) { return ""; }
+    }
+
+    Util::Task await(ResourceManager::Pending<Resource> pending, int& value, std::string& error)
+    {
+        try
+        {
+            value = (co_await pending).value->value;
+        }
+        catch (const std::exception& e)
+        {
+            error = e.what();
+        }
+    }
+}
+
+int main()
+{
+    const auto main_thread = std::this_thread::get_id();
+    ResourceManager res;
+
+    const auto good     = res.load<Resource>("good", 7);
+    const auto bad      = res.load<Resource>("bad", -1);
+    const auto bad_ctor = res.load<Resource>("bad-ctor", 13);
+    CHECK(good.loading() && bad.loading() && bad_ctor.loading());
+    CHECK(res.loading() == 3);
+
+    // Nothing is registered or built before update() picks it up
+    CHECK(!res.exists<Resource>("good"));
+
+    CHECK(settle(res));
+    CHECK(good.ready() && bad.ready() && bad_ctor.ready());
+
+    CHECK(!good.failed() && good.entry().value && good.entry().value->value == 7);
+    CHECK(res.exists<Resource>("good"));
+    if (good.entry().value)
+    {
+        CHECK(good.entry().value->staged_on != main_thread);
+        CHECK(good.entry().value->built_on == main_thread);
+    }
+
+    CHECK(bad.failed() && !bad.entry().value && message(bad) == "staging failed");
+    CHECK(bad_ctor.failed() && !bad_ctor.entry().value && message(bad_ctor) == "building failed");
+    CHECK(!res.exists<Resource>("bad") && !res.exists<Resource>("bad-ctor"));
+
+    // A coroutine resumes on the thread calling update(), and co_await rethrows a failure
+    {
+        int value = 0;
+        std::string error;
+        await(res.load<Resource>("awaited", 21), value, error);
+        await(res.load<Resource>("awaited-bad", -5), value, error);
+        CHECK(value == 0 && error.empty());
+
+        CHECK(settle(res));
+        CHECK(value == 21);
+        CHECK(error == "staging failed");
+
+        // Already done, co_await doesn't suspend at all
+        value = 0;
+        await(good, value, error);
+        CHECK(value == 7);
+    }
+
+    return Test::finish();
+}
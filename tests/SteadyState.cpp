@@ -0,0 +1,130 @@
+#include "Test.hpp"
+#include "Frustum.hpp"
+
+#include "Engine/Systems/Bvh.hpp"
+#include "Engine/Systems/Clusters.hpp"
+#include "Engine/Systems/Occlusion.hpp"
+#include "Util/FrameArena.hpp"
+#include "Util/RadixSort.hpp"
+
+#include <cmath>
+#include <memory_resource>
+#include <random>
+#include <vector>
+
+// The CPU side of a frame the way Renderer::render runs it: frame arena containers, batched
+// culling, the BVH walk, the occlusion buffer, light binning and the draw sort. Once a few frames
+// of the same shape have gone by, none of it may touch the heap. CMake builds this with
+// SOLDER_PROOF_COUNT_ALLOCATIONS whatever the option says, so Util::allocationCount() counts
+
+using namespace Engine;
+using namespace Engine::System;
+using namespace mn;
+
+int main()
+{
+    // Counting has to work, or the zero below means nothing
+    {
+        const auto before = Util::allocationCount();
+        // Straight to operator new, a new expression can be optimized away
+        void* probe = ::operator new(sizeof(int));
+        ::operator delete(probe);
+        CHECK(Util::allocationCount() == before + 1);
+    }
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> coordinate(-100.f, 100.f), extent(0.2f, 6.f), range(1.f, 20.f);
+
+    constexpr std::size_t Instances = 4000, Lights = 300;
+
+    std::vector<BoundingBox> boxes;
+    std::vector<Math::Mat4<float>> models;
+    Bvh bvh;
+    for (std::size_t i = 0; i < Instances; i++)
+    {
+        const Math::Vec3f half{ extent(rng), extent(rng), extent(rng) };
+        boxes.push_back(BoundingBox{ half * -1.f, half });
+        models.push_back(Math::translation(Math::Vec3f{ coordinate(rng), coordinate(rng), coordinate(rng) }));
+        bvh.insert(static_cast<uint32_t>(i), CullingStage::worldBounds(boxes.back(), models.back()));
+    }
+    bvh.rebuild();
+
+    std::vector<Math::Vec3f> lights;
+    std::vector<float> ranges;
+    for (std::size_t i = 0; i < Lights; i++)
+    {
+        lights.push_back(Math::Vec3f{ coordinate(rng), coordinate(rng), coordinate(rng) });
+        ranges.push_back(range(rng));
+    }
+
+    // A wall in front of the camera to rasterize
+    const std::vector<Math::Vec3f> occluder = {
+        { -20.f, -20.f, -30.f }, { 20.f, -20.f, -30.f }, { 20.f, 20.f, -30.f }, { -20.f, 20.f, -30.f }
+    };
+    const std::vector<uint32_t> occluder_indices = { 0, 1, 2, 0, 2, 3 };
+
+    // Everything that lives across frames, like the renderer's mutable members
+    Util::FrameArena arena;
+    CullingStage culling;
+    OcclusionBuffer occlusion;
+    LightClusters clusters;
+    std::vector<uint32_t> found;
+    std::vector<std::pair<uint32_t, uint32_t>> stack;
+    occlusion.resize(256, 144);
+
+    const Math::Vec2f near_far{ 0.1f, 250.f };
+    const auto projection = Math::perspective(16.f / 9.f, Math::Angle::degrees(70), near_far);
+
+    // One frame, the camera swaying back and forth over 16 frames so the same views come round again.
+    // Returns what got drawn so the work can't be thrown away
+    const auto frame = [&](int index)
+    {
+        arena.reset();
+
+        const float turn = std::sin(index * 6.2831853f / 16.f) * 0.4f;
+        const Math::Vec3f forward{ std::sin(turn), 0.f, -std::cos(turn) };
+        const auto frustum = Test::makeFrustum(Math::Vec3f{ 0.f, 0.f, 0.f }, forward, 1.2f, 16.f / 9.f, Math::x(near_far), Math::y(near_far));
+
+        culling.clear();
+        for (std::size_t i = 0; i < Instances; i++) culling.push(boxes[i], models[i]);
+        culling.run(frustum);
+
+        found.clear();
+        bvh.query(frustum, found, stack);
+
+        occlusion.clear(projection, Math::x(near_far));
+        occlusion.rasterize(occluder, occluder_indices, Math::Mat4<float>::identity());
+        occlusion.finish();
+
+        // Sort keys for what's left, the same way the draws are ordered
+        std::pmr::vector<uint64_t> keys(&arena);
+        keys.reserve(found.size());
+        for (const auto item : found)
+            if (culling.visible(item) && !occlusion.occluded(boxes[item], models[item]))
+                keys.push_back((static_cast<uint64_t>(item % 61) << 32) | item);
+
+        std::pmr::vector<uint64_t> scratch(keys.size(), &arena);
+        Util::radixSort<uint64_t>(keys, scratch, 40, [](uint64_t key) { return key; });
+
+        clusters.setup(projection, near_far, LightClusters::Dimensions{});
+        for (std::size_t i = 0; i < Lights; i++) clusters.push(lights[i], ranges[i]);
+        clusters.run();
+
+        return keys.size() + clusters.visible();
+    };
+
+    // The first few swings size everything up
+    std::size_t drawn = 0;
+    for (int i = 0; i < 64; i++) drawn += frame(i);
+    CHECK(!arena.grew());
+
+    const auto before = Util::allocationCount();
+    for (int i = 64; i < 256; i++) drawn += frame(i);
+    const auto allocations = Util::allocationCount() - before;
+
+    if (allocations) std::printf("%zu heap allocation(s) over 192 steady-state frames\n", allocations);
+    CHECK(allocations == 0);
+    CHECK(drawn > 0);
+
+    return Test::finish();
+}
@@ -0,0 +1,103 @@
+#include "Test.hpp"
+
+#include "Util/TaskQueue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// Util::TaskQueue runs every job once, in order on a single worker, and shuts down cleanly
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    void waitIdle(const Util::TaskQueue& queue)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + 10s;
+        while (queue.pending() && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(1ms);
+    }
+}
+
+int main()
+{
+    // No threads, push() runs the job before returning
+    {
+        Util::TaskQueue queue(0);
+        int runs = 0;
+        queue.push([&runs]() { runs++; });
+        CHECK(runs == 1);
+        CHECK(queue.pending() == 0);
+    }
+
+    // Every job exactly once, from several threads pushing at the same time
+    {
+        constexpr int Jobs = 10000;
+        std::vector<std::atomic<int>> runs(Jobs);
+
+        Util::TaskQueue queue(4);
+        CHECK(queue.size() == 4);
+
+        std::vector<std::thread> pushers;
+        for (int p = 0; p < 4; p++)
+            pushers.emplace_back([&, p]()
+            {
+                for (int i = p; i < Jobs; i += 4)
+                    queue.push([&runs, i]() { runs[i]++; });
+            });
+        for (auto& pusher : pushers) pusher.join();
+
+        waitIdle(queue);
+        CHECK(queue.pending() == 0);
+
+        int wrong = 0;
+        for (const auto& r : runs) wrong += (r != 1);
+        CHECK(wrong == 0);
+    }
+
+    // One worker takes them first in first out
+    {
+        std::vector<int> order;
+        Util::TaskQueue queue(1);
+        for (int i = 0; i < 100; i++)
+            queue.push([&order, i]() { order.push_back(i); });
+
+        waitIdle(queue);
+        CHECK(order.size() == 100);
+
+        bool in_order = true;
+        for (int i = 0; i < static_cast<int>(order.size()); i++) in_order &= (order[i] == i);
+        CHECK(in_order);
+    }
+
+    // pending() counts the running job, the destructor lets it finish and drops the rest
+    {
+        std::atomic<bool> started = false, release = false;
+        std::atomic<int> finished = 0, dropped = 0;
+        std::thread releaser;
+        {
+            Util::TaskQueue queue(1);
+            queue.push([&]()
+            {
+                started = true;
+                while (!release) std::this_thread::sleep_for(1ms);
+                finished++;
+            });
+            for (int i = 0; i < 10; i++)
+                queue.push([&dropped]() { dropped++; });
+
+            while (!started) std::this_thread::sleep_for(1ms);
+            CHECK(queue.pending() == 11);
+
+            releaser = std::thread([&release]() { std::this_thread::sleep_for(20ms); release = true; });
+        }
+        releaser.join();
+
+        CHECK(finished == 1);
+        CHECK(dropped == 0);
+    }
+
+    return Test::finish();
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdio>
+
+// Just enough of a harness for ctest. Each test is its own executable, a failed CHECK prints
+// where it happened and carries on, and main returns Test::finish()
+namespace Test
+{
+    inline int failures = 0;
+
+    // ctest reports this exit code as skipped, for tests that can't run on this machine
+    constexpr int Skip = 77;
+
+    inline int finish()
+    {
+        if (failures) std::printf("%d check(s) failed\n", failures);
+        return (failures ? 1 : 0);
+    }
+}
+
+#define CHECK(condition) \
+    do { if (!(condition)) { std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); Test::failures++; } } while (0)
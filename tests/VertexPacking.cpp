@@ -0,0 +1,105 @@
+#include "Test.hpp"
+
+#include "Engine/VertexPacking.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+// packVertices and unpackVertices round trip within what the pool's formats can hold: 16 bits over
+// the bounds for positions, 16 bit octahedral normals and half float texture coordinates
+
+using namespace Engine;
+using namespace mn;
+
+int main()
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> unit(-1.f, 1.f), uv(-4.f, 4.f);
+
+    using Vertex = Graphics::Mesh::Vertex;
+
+    // Random vertices in a lopsided box, with normals pointing everywhere including straight down
+    // the axes and the creases of the octahedron
+    const BoundingBox bounds{ Math::Vec3f{ -3.f, 0.5f, -100.f }, Math::Vec3f{ 7.f, 0.75f, 20.f } };
+    const auto extent = bounds.max - bounds.min;
+
+    std::vector<Vertex> vertices;
+    const Math::Vec3f axes[] = {
+        { 1.f, 0.f, 0.f }, { -1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, -1.f, 0.f }, { 0.f, 0.f, 1.f }, { 0.f, 0.f, -1.f },
+        { 1.f, 1.f, 0.f }, { 1.f, -1.f, 0.f }, { -1.f, 0.f, -1.f }, { 0.f, 1.f, -1.f }
+    };
+    for (int i = 0; i < 10000; i++)
+    {
+        Vertex vertex;
+        vertex.position = bounds.min + Math::Vec3f{
+            (unit(rng) * 0.5f + 0.5f) * Math::x(extent),
+            (unit(rng) * 0.5f + 0.5f) * Math::y(extent),
+            (unit(rng) * 0.5f + 0.5f) * Math::z(extent)
+        };
+        if (i < 8) vertex.position = Math::Vec3f{
+            (i & 1 ? Math::x(bounds.max) : Math::x(bounds.min)),
+            (i & 2 ? Math::y(bounds.max) : Math::y(bounds.min)),
+            (i & 4 ? Math::z(bounds.max) : Math::z(bounds.min))
+        };
+
+        Math::Vec3f normal{ unit(rng), unit(rng), unit(rng) };
+        if (i < 10) normal = axes[i];
+        if (Math::length(normal) < 1e-3f) normal = axes[0];
+        vertex.normal = Math::normalized(normal);
+
+        vertex.color      = { 1.f, 1.f, 1.f, 1.f };
+        vertex.tex_coords = { uv(rng), uv(rng) };
+        vertices.push_back(vertex);
+    }
+
+    const auto packed = packVertices(vertices, bounds);
+    const auto unpacked = unpackVertices(packed, bounds);
+    CHECK(packed.size() == vertices.size() && unpacked.size() == vertices.size());
+
+    std::size_t positions = 0, normals = 0, tex_coords = 0;
+    for (std::size_t i = 0; i < vertices.size(); i++)
+    {
+        const auto error = unpacked[i].position - vertices[i].position;
+        positions += (std::abs(Math::x(error)) > Math::x(extent) / 65535.f * 0.51f ||
+                      std::abs(Math::y(error)) > Math::y(extent) / 65535.f * 0.51f ||
+                      std::abs(Math::z(error)) > Math::z(extent) / 65535.f * 0.51f);
+
+        // About a hundredth of a degree
+        normals += (Math::inner(unpacked[i].normal, vertices[i].normal) < 0.99999f);
+
+        // Halves keep 11 bits of mantissa, anything under the smallest normal half goes to zero
+        const auto uv_error = unpacked[i].tex_coords - vertices[i].tex_coords;
+        const float smallest = std::ldexp(1.f, -14);
+        tex_coords += (std::abs(Math::x(uv_error)) > std::max(std::abs(Math::x(vertices[i].tex_coords)) / 2048.f, smallest) ||
+                       std::abs(Math::y(uv_error)) > std::max(std::abs(Math::y(vertices[i].tex_coords)) / 2048.f, smallest));
+    }
+    CHECK(positions == 0);
+    CHECK(normals == 0);
+    CHECK(tex_coords == 0);
+
+    // A flat mesh has an empty axis, everything on it comes back exactly
+    {
+        const BoundingBox flat{ Math::Vec3f{ -1.f, 2.f, -1.f }, Math::Vec3f{ 1.f, 2.f, 1.f } };
+        Vertex vertex;
+        vertex.position   = { 0.25f, 2.f, -0.5f };
+        vertex.normal     = { 0.f, 1.f, 0.f };
+        vertex.tex_coords = { 0.5f, 0.25f };
+
+        const auto back = unpackVertices(packVertices(std::span(&vertex, 1), flat), flat);
+        CHECK(Math::y(back[0].position) == 2.f);
+        CHECK(std::abs(Math::x(back[0].position) - 0.25f) < 1e-4f && std::abs(Math::z(back[0].position) + 0.5f) < 1e-4f);
+        CHECK(Math::x(back[0].tex_coords) == 0.5f && Math::y(back[0].tex_coords) == 0.25f);
+    }
+
+    // Colours are RGBA8 with red in the low byte, and only get a stream when they differ
+    CHECK(packColor({ 1.f, 0.f, 0.f, 1.f }) == 0xFF0000FFU);
+    CHECK(packColor({ 0.f, 0.5f, 2.f, -1.f }) == 0x00FF8000U);
+    CHECK(packColors(vertices).empty());
+
+    vertices[5000].color = { 0.f, 1.f, 0.f, 1.f };
+    const auto colors = packColors(vertices);
+    CHECK(colors.size() == vertices.size() && colors[5000] == 0xFF00FF00U && colors[0] == 0xFFFFFFFFU);
+
+    return Test::finish();
+}
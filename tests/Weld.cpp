@@ -0,0 +1,68 @@
+#include "Test.hpp"
+
+#include "Engine/ModelFile.hpp"
+#include "Engine/VertexPacking.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// A cube stored as a vertex per triangle corner welds down to four vertices a face, and every
+// triangle still has the corners and the normal it came with
+
+using namespace Engine;
+using namespace mn;
+
+int main()
+{
+    const auto meshes = ModelFile::import(TEST_DIR "/fixtures/cube.obj", 1);
+    CHECK(meshes && meshes->size() == 1);
+    if (!meshes || meshes->empty()) return Test::finish();
+
+    const auto& mesh = meshes->front();
+    CHECK(mesh.source_vertex_count == 36);
+    CHECK(mesh.vertices.size() == 24);
+    CHECK(mesh.index_count == 36);
+
+    const auto vertices = unpackVertices(mesh.vertices, mesh.aabb);
+
+    bool in_range = true;
+    for (std::size_t i = 0; i < mesh.index_count; i++) in_range &= (mesh.indices[i] < vertices.size());
+    CHECK(in_range);
+    if (!in_range) return Test::finish();
+
+    // Each triangle lies on a face of the cube, faces the way its vertex normals say, and the
+    // twelve of them cover the whole surface
+    std::size_t off_surface = 0, wrong_normal = 0;
+    float area = 0.f;
+    for (std::size_t i = 0; i < mesh.index_count; i += 3)
+    {
+        const auto& a = vertices[mesh.indices[i]];
+        const auto& b = vertices[mesh.indices[i + 1]];
+        const auto& c = vertices[mesh.indices[i + 2]];
+
+        const auto cross = Math::outer(b.position - a.position, c.position - a.position);
+        area += Math::length(cross) * 0.5f;
+
+        for (const auto* v : { &a, &b, &c })
+        {
+            const auto& p = v->position;
+            const float largest = std::max({ std::abs(Math::x(p)), std::abs(Math::y(p)), std::abs(Math::z(p)) });
+            off_surface += (std::abs(largest - 1.f) > 1e-4f);
+            wrong_normal += (Math::inner(Math::normalized(cross), v->normal) < 0.99f);
+        }
+    }
+    CHECK(off_surface == 0);
+    CHECK(wrong_normal == 0);
+    CHECK(std::abs(area - 24.f) < 1e-3f);
+
+    // Nothing left that could have been merged
+    std::size_t duplicates = 0;
+    for (std::size_t i = 0; i < vertices.size(); i++)
+        for (std::size_t j = i + 1; j < vertices.size(); j++)
+            duplicates += (Math::length(vertices[i].position - vertices[j].position) < 1e-4f &&
+                           Math::length(vertices[i].normal - vertices[j].normal) < 1e-3f &&
+                           Math::length(vertices[i].tex_coords - vertices[j].tex_coords) < 1e-4f);
+    CHECK(duplicates == 0);
+
+    return Test::finish();
+}